@@ -0,0 +1,40 @@
+# Reports the code size of every instantiation of wait, when_all and when_any in OBJECTS (as
+# listed by NM), and the totals per combinator. Run by the 'code-size' target.
+
+execute_process(
+  COMMAND ${NM} --print-size --size-sort --radix=d --demangle ${OBJECTS}
+  OUTPUT_VARIABLE symbols
+  COMMAND_ERROR_IS_FATAL ANY
+)
+
+string(REGEX MATCHALL "[^\n]+" lines "${symbols}")
+set(total 0)
+foreach(combinator wait_t when_all_t when_any_t)
+  set(total_${combinator} 0)
+  set(count_${combinator} 0)
+endforeach()
+
+foreach(line IN LISTS lines)
+  # <address> <size> <type> <name>, only code
+  if(NOT line MATCHES "^[0-9]+ ([0-9]+) [tTwW] (.*)$")
+    continue()
+  endif()
+  math(EXPR size "${CMAKE_MATCH_1}")
+  set(name "${CMAKE_MATCH_2}")
+
+  foreach(combinator wait_t when_all_t when_any_t)
+    if(name MATCHES "olifilo::${combinator}::")
+      math(EXPR total_${combinator} "${total_${combinator}} + ${size}")
+      math(EXPR count_${combinator} "${count_${combinator}} + 1")
+      math(EXPR total "${total} + ${size}")
+      message("${size}\t${name}")
+      break()
+    endif()
+  endforeach()
+endforeach()
+
+message("")
+foreach(combinator wait_t when_all_t when_any_t)
+  message("${combinator}: ${total_${combinator}} bytes in ${count_${combinator}} functions")
+endforeach()
+message("total: ${total} bytes")
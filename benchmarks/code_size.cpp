@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Instantiates the combinators for a handful of distinct future types, the way an application using
+// them would, to see what every new combination costs in code. Only compiled (by the 'code-size'
+// target), never run.
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/wait.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/coro/when_any.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <tuple>
+
+namespace olifilo::code_size
+{
+template <typename T>
+future<T> value() noexcept
+{
+  co_return T{};
+}
+
+template <typename... Ts>
+future<void> combine() noexcept
+{
+  using namespace std::literals::chrono_literals;
+
+  if (auto r = co_await when_all(value<Ts>()...); !r)
+    co_return r.error();
+
+  if (auto r = co_await when_any(value<Ts>()..., 1s); !r)
+    co_return r.error();
+
+  auto futures = std::tuple{value<Ts>()...};
+  if (auto r = co_await std::apply([] (auto&... f) { return wait(until::first_completed, f..., 1s); }, futures); !r)
+    co_return r.error();
+
+  co_return {};
+}
+
+template future<void> combine<int, char>() noexcept;
+template future<void> combine<int, long>() noexcept;
+template future<void> combine<bool, float, double>() noexcept;
+template future<void> combine<std::uint16_t, std::span<const std::byte>>() noexcept;
+template future<void> combine<std::uint8_t, std::uint32_t, std::uint64_t, std::chrono::nanoseconds>() noexcept;
+}  // namespace olifilo::code_size
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/wait.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/coro/when_any.hpp>
+#include <olifilo/detail/small_vector.hpp>
+#include <olifilo/detail/variant_ptr.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include "harness.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+using namespace olifilo;
+
+future<int> ready() noexcept
+{
+  co_return 42;
+}
+
+// Suspends exactly once: the (already expired) timeout gets handled by the executor on its next iteration
+future<int> yield_once() noexcept
+{
+  (void)co_await io::poll(io::poll::timeout_clock::time_point{});
+  co_return 42;
+}
+
+// Never completes unless cancelled: 'fd' doesn't become readable
+future<int> never(io::file_descriptor_handle fd) noexcept
+{
+  (void)co_await io::poll(fd, io::poll::read);
+  co_return 42;
+}
+
+future<int> chain(unsigned depth, bool suspend) noexcept
+{
+  if (depth == 0)
+    co_return co_await (suspend ? yield_once() : ready());
+  auto r = co_await chain(depth - 1, suspend);
+  if (!r)
+    co_return r;
+  co_return *r + 1;
+}
+
+std::vector<future<int>> make_futures(std::size_t count)
+{
+  std::vector<future<int>> futures;
+  futures.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+    futures.push_back(yield_once());
+  return futures;
+}
+
+future<void> wait_on(until condition, std::size_t count) noexcept
+{
+  auto futures = make_futures(count);
+  if (auto r = co_await wait(condition, futures); !r)
+    co_return r.error();
+  co_return {};
+}
+
+future<void> wait_timeout(io::file_descriptor_handle fd, std::size_t count) noexcept
+{
+  std::vector<future<int>> futures;
+  futures.reserve(count);
+  for (std::size_t i = 0; i < count; ++i)
+    futures.push_back(never(fd));
+
+  if (auto r = co_await wait(until::first_completed, futures, wait_t::clock::now()); r || r.error() != std::errc::timed_out)
+    co_return make_error_code(std::errc::protocol_error);
+  co_return {};
+}
+
+void check(const expected<void>& r)
+{
+  if (!r)
+  {
+    std::fprintf(stderr, "benchmark failed: %s\n", r.error().message().c_str());
+    std::exit(1);
+  }
+}
+
+template <typename T>
+requires(!std::is_void_v<T>)
+void check(expected<T>&& r)
+{
+  check(r ? expected<void>() : expected<void>(unexpect, r.error()));
+  bench::do_not_optimize(*r);
+}
+}  // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  bench::runner bench("coro", argc, argv);
+
+  bench.run("future_create_destroy", 0, [](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i)
+      {
+        auto f = ready();
+        bench::do_not_optimize(f);
+      }
+    });
+
+  bench.run("future_get_ready", 0, [](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i)
+        check(ready().get());
+    });
+
+  bench.run("future_get_suspended", 0, [](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i)
+        check(yield_once().get());
+    });
+
+  for (const unsigned depth : {1u, 8u, 64u})
+  {
+    bench.run("await_chain_ready", depth, [depth](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(chain(depth, false).get());
+      });
+    bench.run("await_chain_suspended", depth, [depth](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(chain(depth, true).get());
+      });
+  }
+
+  int never_ready[2];
+  if (::pipe(never_ready) != 0)
+  {
+    std::perror("pipe");
+    return 1;
+  }
+
+  for (const std::size_t count : {1uz, 4uz, 64uz, 512uz})
+  {
+    bench.run("wait_all", count, [count](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(wait_on(until::all_completed, count).get());
+      });
+    bench.run("wait_first", count, [count](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(wait_on(until::first_completed, count).get());
+      });
+    bench.run("wait_timeout", count, [fd = io::file_descriptor_handle(never_ready[0]), count](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(wait_timeout(fd, count).get());
+      });
+    bench.run("when_all_range", count, [count](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(when_all(make_futures(count)).get());
+      });
+    bench.run("when_any_range", count, [count](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          check(when_any(make_futures(count)).get());
+      });
+  }
+
+  bench.run("when_all_tuple", 3, [](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i)
+        check(when_all(yield_once(), yield_once(), yield_once()).get());
+    });
+  bench.run("when_any_tuple", 3, [](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i)
+        check(when_any(yield_once(), yield_once(), yield_once()).get());
+    });
+
+  ::close(never_ready[0]);
+  ::close(never_ready[1]);
+
+  // Cost of the first push_back's that still fit in the small buffer vs. the ones that have to spill to the heap
+  using callee_list = decltype(detail::promise_wait_callgraph::callees);
+  for (const std::size_t count : {1uz, callee_list::small_capacity, callee_list::small_capacity + 1, 16uz, 256uz})
+  {
+    std::array<int, 256> values{};
+    bench.run("sbo_vector_push_back", count, [count, &values](std::uint64_t n) {
+        detail::promise_wait_callgraph::allocator_type alloc;
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+          detail::sbo_vector<int*> v;
+          for (std::size_t j = 0; j < count; ++j)
+            check(v.push_back(&values[j], alloc));
+          bench::do_not_optimize(v);
+          v.destroy(alloc);
+        }
+      });
+  }
+
+  {
+    struct alignas(8) a { int x; };
+    struct alignas(8) b { int x; };
+    struct alignas(8) c { int x; };
+    static std::array<a, 4> as{};
+    static std::array<b, 4> bs{};
+    static std::array<c, 4> cs{};
+
+    // Mix the alternatives so the branch predictor doesn't get a free ride
+    std::array<detail::variant_ptr<a, b, c>, 1024> ptrs;
+    std::uint32_t seed = 1;
+    for (auto& ptr : ptrs)
+    {
+      seed = seed * 1664525u + 1013904223u;
+      switch ((seed >> 16) % 3)
+      {
+        case 0: ptr = &as[seed % as.size()]; break;
+        case 1: ptr = &bs[seed % bs.size()]; break;
+        case 2: ptr = &cs[seed % cs.size()]; break;
+      }
+    }
+
+    bench.run("variant_ptr_visit", ptrs.size(), [&ptrs](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+          int sum = 0;
+          for (const auto& ptr : ptrs)
+            sum += visit([](auto* p) { return p->x; }, ptr);
+          bench::do_not_optimize(sum);
+        }
+      });
+  }
+}
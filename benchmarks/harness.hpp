@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <utility>
+
+// Minimal benchmark driver: calibrates the iteration count per benchmark, keeps the fastest of a
+// few repetitions and prints one JSON object per line so results can be diffed or fed to scripts.
+namespace olifilo::bench
+{
+template <typename T>
+inline void do_not_optimize(T const& value) noexcept
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct counters
+{
+  std::uint64_t iterations = 0;
+  double        ns_per_op = 0;
+};
+
+class runner
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    explicit runner(std::string_view suite, int argc, char** argv) noexcept
+      : _suite(suite)
+      , _filter(argc > 1 ? argv[1] : "")
+    {
+    }
+
+    bool enabled(std::string_view name) const noexcept
+    {
+      return _filter.empty() || name.find(_filter) != name.npos;
+    }
+
+    /**
+     * @param body  called as body(iterations) and has to execute the measured operation that many times.
+     * @param param size parameter of this benchmark (N futures, depth, fd count, ...), reported verbatim.
+     */
+    template <typename F>
+    counters run(std::string_view name, std::uint64_t param, F&& body)
+    {
+      if (!enabled(name))
+        return {};
+
+      std::uint64_t iterations = 1;
+      while (true)
+      {
+        const auto elapsed = measure(body, iterations);
+        if (elapsed >= min_time || iterations >= max_iterations)
+          break;
+        // aim a bit past the target to avoid creeping up to it
+        const auto scale = elapsed.count() > 0 ? std::chrono::duration<double>(min_time * 1.4) / elapsed : 10.0;
+        iterations = std::min(max_iterations, std::max(iterations + 1, static_cast<std::uint64_t>(static_cast<double>(iterations) * std::min(scale, 10.0))));
+      }
+
+      auto best = clock::duration::max();
+      for (int i = 0; i < repetitions; ++i)
+        best = std::min(best, measure(body, iterations));
+
+      const counters rv{
+        .iterations = iterations,
+        .ns_per_op = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(best).count()) / static_cast<double>(iterations),
+      };
+      report(name, param, rv);
+      return rv;
+    }
+
+    // For benchmarks that do their own measurement, e.g. because they need per-event counters
+    template <typename... Extra>
+    void report(std::string_view name, std::uint64_t param, const counters& c, Extra&&... extra) const
+    {
+      std::printf(R"({"suite":"%.*s","name":"%.*s","param":%llu,"iterations":%llu,"ns_per_op":%.2f)"
+          , static_cast<int>(_suite.size()), _suite.data()
+          , static_cast<int>(name.size()), name.data()
+          , static_cast<unsigned long long>(param)
+          , static_cast<unsigned long long>(c.iterations)
+          , c.ns_per_op);
+      (print_field(extra.first, extra.second), ...);
+      std::printf("}\n");
+      std::fflush(stdout);
+    }
+
+  private:
+    template <typename F>
+    static clock::duration measure(F& body, std::uint64_t iterations)
+    {
+      const auto start = clock::now();
+      body(iterations);
+      return clock::now() - start;
+    }
+
+    static void print_field(std::string_view key, double value)
+    {
+      std::printf(R"(,"%.*s":%.2f)", static_cast<int>(key.size()), key.data(), value);
+    }
+
+    static constexpr auto          min_time = std::chrono::milliseconds(50);
+    static constexpr std::uint64_t max_iterations = 1'000'000'000;
+    static constexpr int           repetitions = 5;
+
+    std::string_view _suite;
+    std::string_view _filter;
+};
+}  // namespace olifilo::bench
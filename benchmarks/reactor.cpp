@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/file_descriptor.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/coro/when_any.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include "harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Measures how the cost of an executor iteration scales with the amount of registered fds, the
+// fraction of them that is active per iteration and the amount of pending timeouts.
+//
+// Every endpoint is either a pipe or a socketpair. A reader coroutine per endpoint waits on
+// file_descriptor::read() of its read end. A driver coroutine writes a single byte into 'active'
+// endpoints per round and waits until all of them got read before starting the next round.
+
+namespace
+{
+using namespace olifilo;
+using namespace std::literals::string_view_literals;
+using clock = std::chrono::steady_clock;
+
+#if OLIFILO_EXECUTOR_TIMERFD
+constexpr auto backend = "select+timerfd"sv;
+#else
+constexpr auto backend = "select"sv;
+#endif
+
+struct endpoint
+{
+  io::file_descriptor reader;
+  io::file_descriptor writer;
+  clock::time_point   sent;
+};
+
+struct shared_state
+{
+  std::size_t                received = 0;
+  std::vector<std::uint64_t> latencies_ns;
+};
+
+// Counts system calls of this thread through the raw_syscalls tracepoint, when we're allowed to
+class syscall_counter
+{
+  public:
+    syscall_counter()
+    {
+      std::uint64_t id = 0;
+      for (const char* path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id", "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"})
+        if (std::ifstream(path) >> id)
+          break;
+      if (!id)
+        return;
+
+      ::perf_event_attr attr{};
+      attr.type = PERF_TYPE_TRACEPOINT;
+      attr.size = sizeof(attr);
+      attr.config = id;
+      attr.sample_period = 1;
+      attr.exclude_hv = 1;
+      _fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    ~syscall_counter()
+    {
+      if (_fd != -1)
+        ::close(_fd);
+    }
+
+    syscall_counter(const syscall_counter&) = delete;
+    syscall_counter& operator=(const syscall_counter&) = delete;
+
+    // -1 when not available
+    double read() const noexcept
+    {
+      std::uint64_t count;
+      if (_fd == -1 || ::read(_fd, &count, sizeof(count)) != sizeof(count))
+        return -1;
+      return static_cast<double>(count);
+    }
+
+  private:
+    int _fd = -1;
+};
+
+std::chrono::nanoseconds cpu_time() noexcept
+{
+  ::rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+  return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+       + std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+}
+
+long context_switches() noexcept
+{
+  ::rusage usage;
+  ::getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+void raise_fd_limit() noexcept
+{
+  ::rlimit limit;
+  if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+  {
+    limit.rlim_cur = limit.rlim_max;
+    (void)::setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+
+// Keeps the write ends out of the range that select() can handle, so the read ends stay as dense as possible
+io::file_descriptor_handle move_out_of_the_way(int fd) noexcept
+{
+  const int moved = ::fcntl(fd, F_DUPFD_CLOEXEC, FD_SETSIZE);
+  if (moved == -1)
+    return io::file_descriptor_handle(fd);
+  ::close(fd);
+  return io::file_descriptor_handle(moved);
+}
+
+expected<std::vector<endpoint>> make_endpoints(std::size_t count)
+{
+  std::vector<endpoint> endpoints(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    int fds[2];
+    if (i % 2 == 0 ? ::pipe2(fds, O_NONBLOCK | O_CLOEXEC) : ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds))
+      return {unexpect, errno, std::system_category()};
+
+    endpoints[i].writer = move_out_of_the_way(fds[1]);
+    endpoints[i].reader = io::file_descriptor_handle(fds[0]);
+  }
+  return endpoints;
+}
+
+future<void> reader(endpoint& ep, shared_state& state) noexcept
+{
+  std::byte buf;
+  while (true)
+  {
+    if (auto r = co_await ep.reader.read(std::span(&buf, 1), eagerness::lazy); !r)
+      co_return r.error();
+    else if (r->empty())
+      co_return make_error_code(std::errc::connection_reset);
+
+    state.latencies_ns.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - ep.sent).count()));
+    ++state.received;
+  }
+}
+
+// Pending timeout that never expires during the benchmark, to measure the cost of having many timers
+future<void> idle_timer() noexcept
+{
+  (void)co_await io::poll(std::chrono::hours(1));
+  co_return {};
+}
+
+future<void> driver(std::vector<endpoint>& endpoints, shared_state& state, std::size_t active, std::size_t rounds) noexcept
+{
+  const std::byte message{42};
+  std::size_t next = 0;
+  std::size_t sent = 0;
+
+  for (std::size_t round = 0; round < rounds; ++round)
+  {
+    for (std::size_t i = 0; i < active; ++i)
+    {
+      auto& ep = endpoints[next];
+      next = (next + 1) % endpoints.size();
+
+      ep.sent = clock::now();
+      if (auto r = co_await ep.writer.write(std::span(&message, 1)); !r)
+        co_return r;
+      ++sent;
+    }
+
+    // yield to the executor until every reader processed its message
+    while (state.received < sent)
+      (void)co_await io::poll(io::poll::timeout_clock::time_point{});
+  }
+
+  co_return {};
+}
+
+std::uint64_t percentile(std::vector<std::uint64_t>& values, double fraction) noexcept
+{
+  if (values.empty())
+    return 0;
+  const auto nth = values.begin() + static_cast<std::ptrdiff_t>(fraction * static_cast<double>(values.size() - 1));
+  std::ranges::nth_element(values, nth);
+  return *nth;
+}
+
+void run(bench::runner& bench, std::size_t fds, unsigned active_percent, std::size_t timers)
+{
+  char name[64];
+  std::snprintf(name, sizeof(name), "reactor_%.*s_active%u_timers%zu", static_cast<int>(backend.size()), backend.data(), active_percent, timers);
+  if (!bench.enabled(name))
+    return;
+
+  auto endpoints = make_endpoints(fds);
+  if (!endpoints)
+  {
+    std::fprintf(stderr, "%s/%zu: %s\n", name, fds, endpoints.error().message().c_str());
+    return;
+  }
+  if (const int highest = std::ranges::max_element(*endpoints, {}, [] (const endpoint& ep) { return static_cast<int>(ep.reader.handle()); })->reader.handle();
+      highest >= FD_SETSIZE)
+  {
+    // The select() based executor can't wait on these at all
+    bench.report(name, fds, {}, std::pair{"skipped_fd_above_fd_setsize"sv, static_cast<double>(highest)});
+    return;
+  }
+
+  const std::size_t active = std::max<std::size_t>(1, fds * active_percent / 100);
+  // Aim for a comparable amount of executor iterations regardless of the fd count
+  const std::size_t rounds = std::max<std::size_t>(20, 200'000 / std::max(fds, active * 10));
+
+  shared_state state;
+  state.latencies_ns.reserve(rounds * active);
+
+  std::vector<future<void>> background;
+  background.reserve(fds + timers);
+  for (auto& ep : *endpoints)
+    background.push_back(reader(ep, state));
+  for (std::size_t i = 0; i < timers; ++i)
+    background.push_back(idle_timer());
+
+  syscall_counter syscalls;
+  const auto syscalls_start = syscalls.read();
+  const auto switches_start = context_switches();
+  const auto cpu_start = cpu_time();
+  const auto start = clock::now();
+
+  auto result = when_any(driver(*endpoints, state, active, rounds), when_all(std::move(background))).get();
+
+  const auto wall = clock::now() - start;
+  const auto cpu = cpu_time() - cpu_start;
+  const auto switches = context_switches() - switches_start;
+  const auto syscalls_end = syscalls.read();
+
+  if (!result || result->index != 0 || !std::get<0>(result->futures).get())
+  {
+    std::fprintf(stderr, "%s/%zu: failed\n", name, fds);
+    return;
+  }
+
+  const auto messages = static_cast<double>(state.received);
+  bench.report(name, fds
+    , {
+        .iterations = state.received,
+        .ns_per_op = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count()) / messages,
+      }
+    , std::pair{"active"sv, static_cast<double>(active)}
+    , std::pair{"rounds"sv, static_cast<double>(rounds)}
+    , std::pair{"cpu_ns_per_msg"sv, static_cast<double>(cpu.count()) / messages}
+    , std::pair{"syscalls_per_msg"sv, syscalls_start < 0 ? -1. : (syscalls_end - syscalls_start) / messages}
+    , std::pair{"ctx_switches"sv, static_cast<double>(switches)}
+    , std::pair{"latency_p50_ns"sv, static_cast<double>(percentile(state.latencies_ns, 0.50))}
+    , std::pair{"latency_p99_ns"sv, static_cast<double>(percentile(state.latencies_ns, 0.99))}
+    , std::pair{"latency_max_ns"sv, static_cast<double>(percentile(state.latencies_ns, 1.00))}
+    );
+}
+}  // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  raise_fd_limit();
+
+  bench::runner bench("reactor", argc, argv);
+
+  for (const std::size_t fds : {10uz, 1'000uz, 10'000uz})
+    for (const unsigned active_percent : {1u, 10u, 100u})
+      for (const std::size_t timers : {0uz, fds})
+        run(bench, fds, active_percent, timers);
+}
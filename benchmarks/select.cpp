@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/detail/ring_buffer.hpp>
+#include <olifilo/detail/select_driver.hpp>
+#include <olifilo/detail/small_vector.hpp>
+#include <olifilo/detail/waiter_slots.hpp>
+#include <olifilo/dynarray.hpp>
+
+#include "harness.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+
+#include <sys/select.h>
+
+// Host run of the start_select/end_select pair of the ESP-IDF events VFS driver (the same
+// detail::select_driver idf/components/olifilo/src/event.cpp uses): what io_poll_context pays on
+// every executor iteration that selects on event fds. Compares the preallocated waiter slots with
+// the per-call allocated and mutex protected waiter list they replaced. The VFS' semaphore is
+// replaced by a counter.
+
+namespace
+{
+using namespace olifilo;
+
+constexpr std::size_t fd_count = 5;
+constexpr std::size_t max_selects_per_fd = 2;
+
+struct stand_in_waker
+{
+  std::atomic<std::uint64_t>* triggered = nullptr;
+};
+
+void select_triggered(stand_in_waker waker) noexcept
+{
+  waker.triggered->fetch_add(1, std::memory_order_relaxed);
+}
+
+using fd_waiter = detail::select_waiter<stand_in_waker>;
+
+struct fd_context
+{
+  std::mutex                                           lock;
+  detail::record_ring                                  queue;
+  detail::waiter_slots<fd_waiter, max_selects_per_fd> waiters;
+  std::atomic<bool>                                    opened = true;
+};
+
+std::array<fd_context, fd_count> contexts;
+
+using driver = detail::select_driver<fd_context, fd_count>;
+
+bool start_select(int nfds, ::fd_set* readfds, stand_in_waker waker, void** driver_data) noexcept
+{
+  detail::armed_select_slots armed;
+  if (!driver::start_select(contexts, nfds, readfds, nullptr, nullptr, waker, select_triggered, armed))
+    return false;
+  *driver_data = reinterpret_cast<void*>(armed);
+  return true;
+}
+
+void end_select(void* driver_data) noexcept
+{
+  driver::end_select(contexts, reinterpret_cast<detail::armed_select_slots>(driver_data));
+}
+
+// The previous implementation: a waiter list allocated per select() call, registered under a mutex per fd
+namespace allocating
+{
+struct fd_waiter;
+
+struct fd_context
+{
+  std::mutex                      lock;
+  detail::record_ring             queue;
+  detail::sbo_vector<fd_waiter*>  waiters;
+  bool                            opened = true;
+
+  ~fd_context()
+  {
+    std::allocator<std::byte> alloc;
+    waiters.destroy(alloc);
+  }
+};
+
+std::array<fd_context, fd_count> contexts;
+
+struct fd_waiter
+{
+  int            fd      = -1;
+  ::fd_set*      readers = nullptr;
+  stand_in_waker waker;
+
+  ~fd_waiter()
+  {
+    if (fd < 0)
+      return;
+
+    auto&& context = contexts[static_cast<std::size_t>(fd)];
+    std::scoped_lock _(context.lock);
+    erase(context.waiters, this);
+  }
+};
+
+using fd_waiters_t = dynarray<fd_waiter>;
+
+bool start_select(int nfds, ::fd_set* readfds, stand_in_waker waker, void** driver_data) noexcept
+{
+  std::size_t count = 0;
+  bool should_awake = false;
+  for (int fd = 0; fd < nfds; ++fd)
+  {
+    if (!FD_ISSET(fd, readfds))
+      continue;
+
+    auto&& context = contexts[static_cast<std::size_t>(fd)];
+    std::scoped_lock _(context.lock);
+    if (!context.queue.empty() || !context.opened)
+    {
+      should_awake = true;
+      break;
+    }
+    ++count;
+  }
+
+  fd_waiters_t fd_waiters;
+  if (!should_awake)
+  {
+    auto r = fd_waiters_t::create(count);
+    if (!r)
+      return false;
+    fd_waiters = *std::move(r);
+  }
+
+  auto fd_waiter = fd_waiters.begin();
+  for (int fd = 0; fd < nfds; ++fd)
+  {
+    if (!FD_ISSET(fd, readfds))
+      continue;
+
+    auto&& context = contexts[static_cast<std::size_t>(fd)];
+    std::scoped_lock _(context.lock);
+    if (context.queue.empty())
+      FD_CLR(fd, readfds);
+    if (should_awake)
+      continue;
+
+    fd_waiter->fd      = fd;
+    fd_waiter->readers = readfds;
+    fd_waiter->waker   = waker;
+
+    std::allocator<std::byte> alloc;
+    if (!context.waiters.push_back(fd_waiter++, alloc))
+      return false;
+  }
+
+  if (should_awake)
+    select_triggered(waker);
+  else
+    *driver_data = fd_waiters.release();
+  return true;
+}
+
+void end_select(void* driver_data) noexcept
+{
+  fd_waiters_t fd_waiters(driver_data);
+  for (auto& fd_waiter : fd_waiters)
+  {
+    auto&& context = contexts[static_cast<std::size_t>(fd_waiter.fd)];
+    std::scoped_lock _(context.lock);
+    if (fd_waiter.readers && !context.queue.empty())
+      FD_SET(fd_waiter.fd, fd_waiter.readers);
+  }
+}
+}  // namespace allocating
+
+// What fd_context::receive does after queueing an event
+void notify(fd_context& context) noexcept
+{
+  driver::notify(context, select_triggered);
+}
+
+template <typename StartSelect, typename EndSelect>
+void select_once(int nfds, stand_in_waker waker, StartSelect&& start, EndSelect&& end)
+{
+  ::fd_set readfds;
+  FD_ZERO(&readfds);
+  for (int fd = 0; fd < nfds; ++fd)
+    FD_SET(fd, &readfds);
+
+  void* driver_data = nullptr;
+  if (!start(nfds, &readfds, waker, &driver_data))
+    std::abort();
+  end(driver_data);
+  bench::do_not_optimize(readfds);
+}
+}  // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  bench::runner bench("select", argc, argv);
+
+  for (auto& context : contexts)
+    if (!context.queue.reset(16, 16, detail::overflow_policy::drop_oldest))
+      return 1;
+  for (auto& context : allocating::contexts)
+    if (!context.queue.reset(16, 16, detail::overflow_policy::drop_oldest))
+      return 1;
+
+  std::atomic<std::uint64_t> triggered = 0;
+  const stand_in_waker waker{&triggered};
+
+  for (const int nfds : {1, static_cast<int>(fd_count)})
+  {
+    bench.run("start_end_select", static_cast<std::uint64_t>(nfds), [nfds, waker](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          select_once(nfds, waker, start_select, end_select);
+      });
+    bench.run("start_end_select_allocating", static_cast<std::uint64_t>(nfds), [nfds, waker](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          select_once(nfds, waker, allocating::start_select, allocating::end_select);
+      });
+  }
+
+  // Posting while nobody selects: lock-free
+  bench.run("notify_unarmed", 0, [](std::uint64_t n) {
+      for (std::uint64_t i = 0; i < n; ++i)
+        notify(contexts[0]);
+    });
+
+  // Posting while a select() call waits: locks to keep it from finishing during the wake-up
+  {
+    ::fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(0, &readfds);
+    void* driver_data = nullptr;
+    if (!start_select(1, &readfds, waker, &driver_data))
+      return 1;
+    bench.run("notify_armed", 1, [](std::uint64_t n) {
+        for (std::uint64_t i = 0; i < n; ++i)
+          notify(contexts[0]);
+      });
+    end_select(driver_data);
+  }
+
+  return triggered.load() ? 0 : 1;
+}
@@ -49,6 +49,7 @@
       suffix ? "",
       compiler ? gcc,
       toolchain ? [],
+      options ? [],
     }: pkgs.stdenv.mkDerivation {
       pname = "olifilo${suffix}";
       inherit version;
@@ -63,13 +64,23 @@
 
       cmakeFlags = [
         "-DPROJECT_VER=${version}"
-      ] ++ toolchain;
+      ] ++ toolchain ++ options;
 
       ${if self ? lastModified then "SOURCE_DATE_EPOCH" else null} = self.lastModified;
 
       cmakeBuildType = "Debug";
       doCheck = true;
     }) {};
+    # Builds & runs the tests that only exist with this option, e.g. the allocation counting ones
+    olifilo-memory-budget = olifilo.override {
+      suffix = "-memory-budget";
+      options = [ "-DOLIFILO_MEMORY_BUDGET=ON" ];
+    };
+    # Runs every test, and the timers' in particular, on the executor waiting through a timerfd
+    olifilo-executor-timerfd = olifilo.override {
+      suffix = "-executor-timerfd";
+      options = [ "-DOLIFILO_EXECUTOR_TIMERFD=ON" ];
+    };
     idf-olifilo = olifilo.overrideAttrs {
       prePatch = ''
         cd idf
@@ -98,7 +109,7 @@
 
   in rec {
     packages = rec {
-      inherit olifilo;
+      inherit olifilo olifilo-memory-budget olifilo-executor-timerfd;
       default = olifilo;
       inherit (pkgs) qemu-espressif qemu-esp32 qemu-esp32c3;
       qemu-esp32s3 = qemu-esp32;
@@ -146,7 +157,10 @@
         esp32s3 = "esp32s3-20210327";
         esp32c3 = "esp32c3-api1-20210207";
       };
-    in builtins.listToAttrs (
+    in {
+      # doCheck: building these runs their tests
+      inherit olifilo olifilo-memory-budget olifilo-executor-timerfd;
+    } // builtins.listToAttrs (
       map (chip: {
         name = "${chip}-qemu";
         value =
@@ -4,22 +4,29 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <mutex>
 #include <tuple>
 #include <utility>
 #include <variant>
 #include <vector>
 
-#include <olifilo/detail/small_vector.hpp>
+#include <olifilo/detail/ring_buffer.hpp>
+#include <olifilo/detail/select_driver.hpp>
+#include <olifilo/detail/waiter_slots.hpp>
+#include <olifilo/events/decoder.hpp>
 #include <olifilo/expected.hpp>
 #include <olifilo/coro/future.hpp>
 #include <olifilo/coro/io/file_descriptor.hpp>
 
 #include "events/base.hpp"
-#include "events/detail.hpp"
 
 #include <esp_event_base.h>
+#include <esp_vfs.h>
+#include <sys/select.h>
 
 namespace olifilo::esp
 {
@@ -97,79 +104,46 @@ class event_subscription_default
 class events
 {
   public:
+    using overflow_policy = olifilo::detail::overflow_policy;
+    static constexpr std::size_t default_queue_capacity = 16;
+
     static expected<int> init() noexcept;
 
     template <detail::EventIdEnum auto... EventIds>
     class subscriber
     {
       public:
-        using var_event_id_t = detail::unique_t<std::variant<decltype(EventIds)...>>;
-        using var_event_t = std::conditional_t<
-            detail::contains_void<detail::event_t<EventIds>...>
-          , detail::unique_t<std::variant<
-              // ensure std::monostate is the *first* alternative in our variant
-              std::monostate
-            , std::conditional_t<
-                std::is_void_v<detail::event_t<EventIds>>
-              , std::monostate
-              , detail::event_t<EventIds>
-              >...
-            >>
-          , detail::unique_t<std::variant<detail::event_t<EventIds>...>>
-          >;
-        static_assert(std::tuple_size_v<detail::unique_t<std::tuple<std::integral_constant<std::size_t, detail::event_id<decltype(EventIds)>::sort_key>...>>>
-            == std::variant_size_v<var_event_id_t>, "non-unique sort-key found for used event id enums!");
-
-        using event_id_t = std::conditional_t<
-            std::variant_size_v<var_event_id_t> == 1
-          , std::variant_alternative_t<0, var_event_id_t>
-          , var_event_id_t
-          >;
-        using event_t = std::conditional_t<
-            std::variant_size_v<var_event_t> == 1
-          , std::conditional_t<
-              detail::contains_void<detail::event_t<EventIds>...>
-              && std::is_same_v<std::variant_alternative_t<0, var_event_t>, std::monostate>
-            , void
-            , std::variant_alternative_t<0, var_event_t>
-            >
-          , var_event_t
-          >;
-
-        static constexpr auto max_event_size = std::max({
-            detail::size_of<detail::event_t<EventIds>>...
-          });
-
-        using result_t = std::conditional_t<
-              sizeof...(EventIds) == 1
-            , event_t
-            , std::conditional_t<
-                std::is_void_v<event_t>
-              , event_id_t
-              , std::pair<event_id_t, event_t>
-              >
-            >;
+        using decoder_t = olifilo::events::decoder<EventIds...>;
+        using var_event_id_t = typename decoder_t::var_event_id_t;
+        using var_event_t = typename decoder_t::var_event_t;
+        using event_id_t = typename decoder_t::event_id_t;
+        using event_t = typename decoder_t::event_t;
+        using result_t = typename decoder_t::result_t;
+        static constexpr auto max_event_size = decoder_t::max_event_size;
 
         future<result_t> receive() noexcept
         {
+          // see fd_context for this layout
           struct {
-            struct {
-              ::esp_event_base_t base;
-              std::int32_t       id;
-            } hdr;
-            std::byte data[max_event_size];
+            alignas(std::max_align_t) std::byte data[max_event_size];
+            record_index_t                      index;
           } serialized;
-          constexpr auto header_size = sizeof(serialized.hdr);
+          constexpr auto record_size = max_event_size + sizeof(record_index_t);
           auto result = co_await _fd.read_some(as_writable_bytes(std::span(&serialized, 1)));
           if (!result)
             co_return {olifilo::unexpect, result.error()};
-          else if (result->size_bytes() < header_size)
-            co_return {olifilo::unexpect, make_error_code(std::errc::message_size)};
-
-          co_return detail::decode_event<result_t, event_t, var_event_id_t, 0, EventIds...>(
-              serialized.hdr.base
-            , serialized.hdr.id
-            , result->subspan(header_size)
+          else if (result->size_bytes() != record_size
+                || serialized.index >= sizeof...(EventIds))
+            co_return {olifilo::unexpect, make_error_code(std::errc::bad_message)};
+
+          // indices are in the order create() subscribed in
+          const ::esp_event_base_t bases[] = {detail::event_id<decltype(EventIds)>::base...};
+          static constexpr std::int32_t ids[] = {static_cast<std::int32_t>(EventIds)...};
+          static constexpr std::size_t sizes[] = {detail::size_of<detail::event_t<EventIds>>...};
+          co_return decoder_t::decode(
+              bases[serialized.index]
+            , ids[serialized.index]
+            , std::span(serialized.data, sizes[serialized.index])
             );
         }
 
@@ -184,6 +158,9 @@ class events
         }
 
       private:
+        static_assert(sizeof...(EventIds) <= std::size_t(std::numeric_limits<record_index_t>::max()) + 1
+            , "too many events to index in a single subscription");
+
         io::file_descriptor _fd;
 
         friend class events;
@@ -192,23 +169,35 @@ class events
         {
         }
 
-        static expected<subscriber> create() noexcept
+        static expected<subscriber> create(std::size_t queue_capacity, overflow_policy policy) noexcept
         {
           auto fd = subscribe({
-              {detail::event_id<decltype(EventIds)>::base, static_cast<std::int32_t>(EventIds)}...
-            }, max_event_size);
+              {
+                detail::event_id<decltype(EventIds)>::base
+              , static_cast<std::int32_t>(EventIds)
+              , detail::size_of<detail::event_t<EventIds>>
+              }...
+            }, max_event_size, queue_capacity, policy);
           if (!fd)
             return {unexpect, fd.error()};
           return subscriber(*std::move(fd));
         }
     };
 
+    /**
+     * Events are queued in a ring of 'queue_capacity' events allocated here. Posting into it from the
+     * event loop never allocates nor waits for the reader: when it's full 'policy' decides which event
+     * to drop.
+     */
     template <detail::EventIdEnum auto... EventIds>
-    static constexpr auto subscribe() noexcept
+    static constexpr auto subscribe(
+        std::size_t queue_capacity = default_queue_capacity
+      , overflow_policy policy = overflow_policy::drop_oldest
+      ) noexcept
     {
       // use decltype() and call create() ourselves to avoid code-gen for the index_sequence overload
       constexpr auto indices = detail::sort_indices<EventIds...>();
-      return std::remove_pointer_t<decltype(subscribe<indices, EventIds...>(std::make_index_sequence<indices.size()>()))>::create();
+      return std::remove_pointer_t<decltype(subscribe<indices, EventIds...>(std::make_index_sequence<indices.size()>()))>::create(queue_capacity, policy);
     }
 
   private:
@@ -220,25 +209,44 @@ class events
       return static_cast<subscriber<std::tuple_element_t<indices[Is], input_t>::value...>*>(nullptr);
     }
 
+    // @param events base, id and payload size of every event to subscribe to
     static expected<io::file_descriptor> subscribe(
-        std::initializer_list<std::tuple<::esp_event_base_t, std::int32_t>> events
-      , std::size_t event_data_size) noexcept;
+        std::initializer_list<std::tuple<::esp_event_base_t, std::int32_t, std::size_t>> events
+      , std::size_t event_data_size
+      , std::size_t queue_capacity
+      , overflow_policy policy) noexcept;
 
   private:
-    struct fd_waiter;
+    // index of a record's event in its fd_context's 'subscriptions'
+    using record_index_t = std::uint8_t;
+
+    // A select() call waiting for an fd, which it should be woken up for
+    using fd_waiter = olifilo::detail::select_waiter<::esp_vfs_select_sem_t>;
+
+    // select() calls that may wait for the same fd at the same time
+    static constexpr std::size_t max_selects_per_fd = 2;
+
     struct fd_context
     {
-      std::mutex                              lock;
-      std::vector<std::byte>                  queue;
-      olifilo::detail::sbo_vector<fd_waiter*> waiters;
-      std::vector<event_subscription_default> subscriptions;
-      std::size_t                             event_data_size = 0;
-      bool                                    opened          = false;
-
-      ~fd_context();
+      struct subscription
+      {
+        event_subscription_default handler;
+        std::size_t                event_data_size = 0;
+      };
+
+      // protects 'subscriptions', reading from 'queue' and waking (vs. disarming) 'waiters'
+      std::mutex                                                   lock;
+      // records of event_data_size bytes of payload (padded for smaller events) followed by a record_index_t
+      olifilo::detail::record_ring                                 queue;
+      olifilo::detail::waiter_slots<fd_waiter, max_selects_per_fd> waiters;
+      std::vector<subscription>                                    subscriptions;
+      std::size_t                                                  event_data_size = 0;
+      std::atomic<bool>                                            opened          = false;
+
       void receive(this fd_context* self, esp_event_base_t event_base, std::int32_t event_id, void* event_data) noexcept;
     };
 
     static std::array<fd_context, 5> contexts;
+    using select_driver = olifilo::detail::select_driver<fd_context, 5>;
 };
 }  // namespace olifilo::esp
@@ -2,42 +2,18 @@
 
 #pragma once
 
-#include <concepts>
-#include <cstdint>
-#include <limits>
 #include <type_traits>
 
-#include <esp_event_base.h>
-
-namespace olifilo::esp::detail
-{
-template <typename T>
-concept EventIdEnumBase =
-    std::is_enum<T>::value
- && std::integral<std::underlying_type_t<T>>
- && sizeof(std::underlying_type_t<T>) <= sizeof(std::int32_t);
+#include <olifilo/events/base.hpp>
 
-template <EventIdEnumBase Base>
-struct event_id;
-
-template <typename T>
-concept EventIdEnum =
-    EventIdEnumBase<T>
- && std::is_same_v<std::decay_t<decltype(event_id<T>::base)>, esp_event_base_t>
- && std::is_same_v<std::decay_t<decltype(event_id<T>::sort_key)>, std::size_t>
- && std::is_same_v<std::remove_cvref_t<decltype(event_id<T>::max)>, std::underlying_type_t<T>>
- && (event_id<T>::min >= std::numeric_limits<std::int32_t>::min() || event_id<T>::min >= 0)
- &&  event_id<T>::max <= std::numeric_limits<std::int32_t>::max();
+#include <esp_event_base.h>
 
-template <EventIdEnum auto EventId>
-struct event
+namespace olifilo::esp
 {
-  // Defaulting to 'void' because there are plenty of events without payload
-  using type = void;
-};
+// Event ids and payloads get specialized in olifilo::events::detail, shared with other platforms
+namespace detail = olifilo::events::detail;
 
-template <EventIdEnum auto EventId>
-using event_t = typename event<EventId>::type;
+static_assert(std::is_same_v<detail::event_base_t, ::esp_event_base_t>);
 
 // Arbitrary order of events and the sort keys they have as a result.
 // The only requirement for sort keys is that they need to be unique.
@@ -60,4 +36,4 @@ using event_t = typename event<EventId>::type;
 // 15. ESP_HTTPS_SERVER_EVENT
 // 16. ESP_HTTP_CLIENT_EVENT
 // 17. ESP_HTTP_SERVER_EVENT
-}  // namespace olifilo::esp::detail
+}  // namespace olifilo::esp
@@ -9,7 +9,7 @@
 
 #include "base.hpp"
 
-namespace olifilo::esp::detail
+namespace olifilo::events::detail
 {
 template <>
 struct event_id<::eth_event_t>
@@ -25,4 +25,4 @@ struct event<EventId>
 {
   using type = ::esp_eth_handle_t;
 };
-}  // namespace olifilo::esp::detail
+}  // namespace olifilo::events::detail
@@ -8,7 +8,7 @@
 
 #include "base.hpp"
 
-namespace olifilo::esp::detail
+namespace olifilo::events::detail
 {
 template <>
 struct event_id<::ip_event_t>
@@ -54,4 +54,4 @@ struct event<::IP_EVENT_TX_RX>
 {
   using type = ::esp_netif_tx_rx_direction_t;
 };
-}  // namespace olifilo::esp::detail
+}  // namespace olifilo::events::detail
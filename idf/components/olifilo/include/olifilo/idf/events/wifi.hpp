@@ -8,7 +8,7 @@
 
 #include "base.hpp"
 
-namespace olifilo::esp::detail
+namespace olifilo::events::detail
 {
 template <>
 struct event_id<::wifi_event_t>
@@ -168,4 +168,4 @@ struct event<::WIFI_EVENT_STA_NEIGHBOR_REP>
 {
   using type = ::wifi_event_neighbor_report_t;
 };
-}  // namespace olifilo::esp::detail
+}  // namespace olifilo::events::detail
@@ -3,10 +3,11 @@
 #include <olifilo/idf/event.hpp>
 
 #include <algorithm>
-#include <cstring>
-#include <iterator>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <span>
 
-#include <olifilo/dynarray.hpp>
 #include <olifilo/idf/errors.hpp>
 
 #include <esp_event.h>
@@ -47,63 +48,44 @@ expected<event_subscription_default> event_subscription_default::create(
   return event_subscription_default(event_base, event_id, subscription);
 }
 
-struct events::fd_waiter
-{
-  int                     fd      = -1;
-  ::fd_set*               readers = nullptr;
-  ::fd_set*               errors  = nullptr;
-  ::esp_vfs_select_sem_t  waker;
-
-  ~fd_waiter()
-  {
-    if (fd < 0)
-      return;
-
-    auto&& context = contexts[fd];
-    std::scoped_lock _(context.lock);
-    erase(context.waiters, this);
-  }
-};
-
-events::fd_context::~fd_context()
-{
-  std::allocator<std::byte> alloc;
-  waiters.destroy(alloc);
-}
-
 void events::fd_context::receive(this events::fd_context* self, esp_event_base_t event_base, std::int32_t event_id, void* event_data) noexcept
 {
   ESP_LOGD(TAG, "fd[%zd@%p]::receive: received event %s:%ld(%p) [open=%u,max_size=%zu]"
-      , self - contexts.begin(), self, event_base, event_id, event_data, self->opened, self->event_data_size);
+      , self - contexts.begin(), self, event_base, event_id, event_data, self->opened.load(std::memory_order_relaxed), self->event_data_size);
 
   assert(self != nullptr);
-  std::scoped_lock _(self->lock);
-  if (!self->opened)
+  if (!self->opened.load(std::memory_order_acquire))
     return;
 
-  const auto event_size = sizeof(::esp_event_base_t) + sizeof(std::int32_t) + self->event_data_size;
-  assert(self->queue.size() % event_size == 0);
-  self->queue.reserve(self->queue.size() + event_size);
-  std::back_insert_iterator out(self->queue);
-  out = std::ranges::copy(as_bytes(std::span(&event_base, 1)), out).out;
-  out = std::ranges::copy(as_bytes(std::span(&event_id, 1)), out).out;
-  if (event_data)
-    out = std::ranges::copy(std::span(static_cast<const std::byte*>(event_data), self->event_data_size), out).out;
-  else
-    self->queue.resize(self->queue.size() + self->event_data_size);
-  ESP_LOGD(TAG, "fd[%zd@%p]::receive: event queue size: %zu"
-      , self - contexts.begin(), self, self->queue.size());
-  assert(self->queue.size() % event_size == 0);
-  assert(!self->queue.empty());
-
-  for (auto& waiter : self->waiters)
-    esp_vfs_select_triggered(waiter->waker);
+  // No need to lock: unsubscribing (clearing 'subscriptions') waits for running handlers to finish
+  const auto subscription = std::ranges::find_if(self->subscriptions, [&] (const auto& s) {
+      return s.handler.base() == event_base && s.handler.id() == event_id;
+    });
+  if (subscription == self->subscriptions.end())
+    return;
+  const auto index = static_cast<record_index_t>(subscription - self->subscriptions.begin());
+
+  const bool queued = self->queue.push([&] (std::span<std::byte> record) noexcept {
+      // only this event's own payload: reading up to event_data_size could go out of bounds
+      const auto payload = record.first(subscription->event_data_size);
+      if (event_data)
+        std::ranges::copy(std::span(static_cast<const std::byte*>(event_data), payload.size()), payload.begin());
+      else
+        std::ranges::fill(payload, std::byte());
+      record.back() = static_cast<std::byte>(index);
+    });
+  if (!queued)
+  {
+    ESP_LOGD(TAG, "fd[%zd@%p]::receive: event queue full, dropped %zu events"
+        , self - contexts.begin(), self, self->queue.dropped());
+    return;
+  }
+
+  select_driver::notify(*self, esp_vfs_select_triggered);
 }
 
 expected<int> events::init() noexcept
 {
-  using fd_waiters_t = dynarray<fd_waiter>;
-
   static constexpr ::esp_vfs_select_ops_t select_ops = {
       .start_select = [](
             int                  nfds
@@ -113,128 +95,16 @@ expected<int> events::init() noexcept
           , esp_vfs_select_sem_t waker
           , void**               driver_data) noexcept -> esp_err_t
         {
-          nfds = std::min(nfds, static_cast<int>(events::contexts.size()));
-
-          // Count fds to allocate for
-          std::size_t count = 0;
-          bool should_awake = false;
-          for (int fd = 0; fd < nfds; ++fd)
-          {
-            // event fds are never writable
-            // thus everything in writefds is always 'ready' (to fail with ENOSYS)
-            if (FD_ISSET(fd, writefds))
-            {
-              should_awake = true;
-              break;
-            }
-            auto&& context = events::contexts[fd];
-            if (FD_ISSET(fd, readfds))
-            {
-              std::scoped_lock _(context.lock);
-              if (!context.queue.empty() || !context.opened)
-              {
-                should_awake = true;
-                break;
-              }
-              ++count;
-            }
-            if (FD_ISSET(fd, exceptfds))
-            {
-              if (!context.opened)
-              {
-                should_awake = true;
-                break;
-              }
-              ++count;
-            }
-          }
-
-          fd_waiters_t fd_waiters;
-          if (!should_awake)
-          {
-            if (auto r = fd_waiters_t::create(count); r)
-              fd_waiters = *std::move(r);
-            else if (&r.error().category() == &error_category())
-              return r.error().value();
-            else if (r.error() == std::errc::invalid_argument)
-              return ESP_ERR_INVALID_ARG;
-            else if (r.error() == std::errc::not_enough_memory)
-              return ESP_ERR_NO_MEM;
-            else
-              return ESP_FAIL;
-          }
-
-          auto fd_waiter = fd_waiters.begin();
-          for (int fd = 0; fd < nfds; ++fd)
-          {
-            if (!FD_ISSET(fd, readfds) && !FD_ISSET(fd, exceptfds))
-              continue;
-
-            auto&& context = events::contexts[fd];
-            std::scoped_lock _(context.lock);
-
-            if (!context.opened)
-              continue;
-
-            ::fd_set* const check_read  = FD_ISSET(fd, readfds  ) ? readfds   : nullptr;
-            ::fd_set* const check_error = FD_ISSET(fd, exceptfds) ? exceptfds : nullptr;
-            FD_CLR(fd, exceptfds);
-            if (check_read
-             && context.queue.empty())
-                FD_CLR(fd, check_read);
-
-            if (should_awake)
-              // avoid allocating more.
-              // we already know we're awaking select: no need for the bookkeeping!
-              continue;
-
-            assert(fd_waiter != fd_waiters.end());
-            fd_waiter->fd       = fd;
-            fd_waiter->readers  = check_read;
-            fd_waiter->errors   = check_error;
-            fd_waiter->waker    = waker;
-
-            std::allocator<std::byte> alloc;
-            if (auto r = context.waiters.push_back(fd_waiter++, alloc); r)
-              ;
-            else if (&r.error().category() == &error_category())
-              return r.error().value();
-            else if (r.error() == std::errc::invalid_argument)
-              return ESP_ERR_INVALID_ARG;
-            else if (r.error() == std::errc::not_enough_memory)
-              return ESP_ERR_NO_MEM;
-            else
-              return ESP_FAIL;
-          }
-
-          if (should_awake)
-            esp_vfs_select_triggered(waker);
-          else
-            *driver_data = fd_waiters.release();
+          olifilo::detail::armed_select_slots armed;
+          if (!select_driver::start_select(events::contexts, nfds, readfds, writefds, exceptfds, waker, esp_vfs_select_triggered, armed))
+            return ESP_ERR_NO_MEM;
 
+          *driver_data = reinterpret_cast<void*>(armed);
           return ESP_OK;
         },
       .end_select = [](void* driver_data) noexcept -> esp_err_t
         {
-          // resume ownership of waiter list we released in start_select
-          fd_waiters_t fd_waiters(driver_data);
-          for (auto& fd_waiter : fd_waiters)
-          {
-            auto&& context = events::contexts[fd_waiter.fd];
-            std::scoped_lock _(context.lock);
-
-            if (context.opened)
-            {
-              if (fd_waiter.readers && !context.queue.empty())
-                FD_SET(fd_waiter.fd, fd_waiter.readers);
-            }
-            else
-            {
-              if (fd_waiter.errors)
-                FD_SET(fd_waiter.fd, fd_waiter.errors);
-            }
-          }
-
+          select_driver::end_select(events::contexts, reinterpret_cast<olifilo::detail::armed_select_slots>(driver_data));
           return ESP_OK;
         },
   };
@@ -254,9 +124,10 @@ expected<int> events::init() noexcept
             return -1;
           }
 
+          // serializes readers: the queue has a single consumer
           std::scoped_lock _(context.lock);
-          ESP_LOGD(TAG, "read(fd=%d@%p [open=%u], dest=<%p,%zu>): event queue size: %zu"
-              , fd, &context, context.opened, data, size, context.queue.size());
+          ESP_LOGD(TAG, "read(fd=%d@%p [open=%u], dest=<%p,%zu>): event queue empty: %u"
+              , fd, &context, context.opened.load(std::memory_order_relaxed), data, size, context.queue.empty());
           if (!context.opened)
           {
             errno = EBADF;
@@ -267,16 +138,18 @@ expected<int> events::init() noexcept
             errno = EAGAIN;
             return -1;
           }
-          const auto event_size = sizeof(::esp_event_base_t) + sizeof(std::int32_t) + context.event_data_size;
+          const auto event_size = context.queue.record_size();
           if (size < event_size)
           {
             errno = EMSGSIZE;
             return -1;
           }
 
-          assert(context.queue.size() % event_size == 0);
-          std::memcpy(data, context.queue.data(), event_size);
-          context.queue.erase(context.queue.begin(), context.queue.begin() + event_size);
+          if (!context.queue.pop(std::span(static_cast<std::byte*>(data), size)))
+          {
+            errno = EAGAIN;
+            return -1;
+          }
           return event_size;
         },
       .close = [](int fd) noexcept -> int
@@ -289,16 +162,18 @@ expected<int> events::init() noexcept
 
           auto&& context = events::contexts[fd];
           std::scoped_lock _(context.lock);
-          if (!std::exchange(context.opened, false))
+          if (!context.opened.exchange(false))
           {
             errno = EBADF;
             return -1;
           }
 
-          context.queue.clear();
+          // unsubscribe first: stops posting into the queue
           context.subscriptions.clear();
-          for (auto& waiter : context.waiters)
-            esp_vfs_select_triggered(waiter->waker);
+          context.queue.clear();
+          context.waiters.for_each_armed([] (const fd_waiter& waiter) noexcept {
+              esp_vfs_select_triggered(waiter.waker);
+            });
 
           return 0;
         },
@@ -328,8 +203,16 @@ expected<int> events::init() noexcept
   return {std::in_place, vfs_id};
 }
 
-expected<io::file_descriptor> events::subscribe(std::initializer_list<std::tuple<::esp_event_base_t, std::int32_t>> events, std::size_t event_data_size) noexcept
+expected<io::file_descriptor> events::subscribe(
+    std::initializer_list<std::tuple<::esp_event_base_t, std::int32_t, std::size_t>> events
+  , std::size_t event_data_size
+  , std::size_t queue_capacity
+  , overflow_policy policy
+  ) noexcept
 {
+  if (events.size() > std::size_t(std::numeric_limits<record_index_t>::max()) + 1)
+    return {unexpect, make_error_code(std::errc::invalid_argument)};
+
   const auto vfs = init();
   if (!vfs)
     return {unexpect, vfs.error()};
@@ -338,16 +221,26 @@ expected<io::file_descriptor> events::subscribe(std::initializer_list<std::tuple
   {
     auto&& context = contexts[fd];
     std::scoped_lock _(context.lock);
-    if (context.opened || !context.waiters.empty())
+    if (context.opened || context.waiters.any_claimed())
       continue;
 
     context.subscriptions.clear();
     context.subscriptions.reserve(events.size());
 
-    for (auto&& [event_base, event_id] : events)
+    // allocate before subscribing: receive() never does
+    if (auto r = context.queue.reset(
+          event_data_size + sizeof(record_index_t)
+        , queue_capacity
+        , policy
+        ); !r)
+      return {unexpect, r.error()};
+    context.event_data_size = event_data_size;
+
+    for (auto&& [event_base, event_id, data_size] : events)
     {
-      ESP_LOGD(TAG, "[local_fd=%d] subscribing to %s:%ld (max_size=%zu)"
-          , fd, event_base, event_id, event_data_size);
+      ESP_LOGD(TAG, "[local_fd=%d] subscribing to %s:%ld (size=%zu,max_size=%zu)"
+          , fd, event_base, event_id, data_size, event_data_size);
+      assert(data_size <= event_data_size);
       if (auto subscription = event_subscription_default::create(
             event_base
           , event_id
@@ -360,7 +253,7 @@ expected<io::file_descriptor> events::subscribe(std::initializer_list<std::tuple
       }
       else
       {
-        context.subscriptions.push_back(*std::move(subscription));
+        context.subscriptions.push_back({*std::move(subscription), data_size});
       }
     }
 
@@ -381,8 +274,7 @@ expected<io::file_descriptor> events::subscribe(std::initializer_list<std::tuple
       return {unexpect, status, error_category()};
     }
 
-    context.event_data_size = event_data_size;
-    context.opened = true;
+    context.opened.store(true, std::memory_order_release);
     return {std::in_place, io::file_descriptor_handle(global_fd)};
   }
 
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <olifilo/expected.hpp>
+#include <olifilo/io/types.hpp>
+
+namespace olifilo
+{
+namespace detail
+{
+struct async_profile;
+}  // namespace detail
+
+/**
+ * Sampling CPU profiler that attributes time to async call chains instead of to the executor.
+ *
+ * Every 'period' of consumed CPU time SIGPROF interrupts a running thread, whose current_async_stack()
+ * gets recorded into a preallocated buffer. Samples taken outside of any coroutine resumed by an
+ * executor are attributed to "[no coroutine]".
+ *
+ * Only one profiler can run per process: it owns SIGPROF and ITIMER_PROF while running.
+ */
+class async_profiler
+{
+  public:
+    async_profiler() = default;
+    async_profiler(async_profiler&&) noexcept = default;
+    async_profiler& operator=(async_profiler&& rhs) noexcept;
+    ~async_profiler();
+
+    /**
+     * @param max_samples samples beyond this amount get dropped (and counted) instead of recorded
+     * @returns errc::device_or_resource_busy when another profiler is already running
+     */
+    static expected<async_profiler> start(std::chrono::microseconds period = std::chrono::milliseconds(1), std::size_t max_samples = 16384) noexcept;
+
+    // Stops sampling, the recorded samples stay available. Implied by destruction.
+    void stop() noexcept;
+
+    std::size_t samples() const noexcept;
+    std::size_t dropped_samples() const noexcept;
+
+    /**
+     * Writes the samples aggregated per async stack in the folded format ("outer;inner count" lines)
+     * understood by flamegraph.pl, inferno and speedscope. Frames get named after the symbol of the
+     * coroutine's resume function (only exported ones, i.e. link with -rdynamic) or 'module+offset'.
+     *
+     * Only call this after stop().
+     */
+    expected<void> write_folded(io::file_descriptor_handle fd) const noexcept;
+
+  private:
+    explicit async_profiler(std::unique_ptr<detail::async_profile> profile) noexcept;
+
+    std::unique_ptr<detail::async_profile> _state;
+};
+
+/**
+ * Name of the coroutine whose code contains 'function', e.g. an async_frame_function() or a return
+ * address: the demangled symbol (only exported ones, i.e. link with -rdynamic) without the suffix the
+ * compiler gives its resume function, or 'module+offset' when there's no symbol.
+ */
+std::string coroutine_name(const void* function);
+}  // namespace olifilo
@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <span>
+
+// Maximum amount of coroutine frames recorded per async stack. Deeper chains lose their innermost frames.
+#ifndef OLIFILO_ASYNC_STACK_DEPTH
+#define OLIFILO_ASYNC_STACK_DEPTH 32
+#endif
+
+namespace olifilo
+{
+inline constexpr std::size_t async_stack_depth = OLIFILO_ASYNC_STACK_DEPTH;
+
+namespace detail
+{
+/**
+ * The chain of coroutines, from the one passed to future::get() to the one waiting on the event,
+ * that the executor resumed last on this thread.
+ *
+ * Only ever modified by its own thread, but may be read by a signal handler interrupting that
+ * thread: 'depth' is what makes frames visible, so it's zero while they're being (re)written.
+ */
+struct async_stack
+{
+  std::atomic<std::size_t> depth = 0;
+  // length of the chain being recorded, may exceed the capacity of 'frames'
+  std::size_t              recorded = 0;
+  const void*              frames[async_stack_depth] = {};
+};
+
+constinit inline thread_local async_stack this_thread_async_stack;
+
+// Called by the executor for the coroutine waiting on a ready event, found at 'level' in the wait graph
+inline void record_async_leaf(std::size_t level, std::coroutine_handle<> frame) noexcept
+{
+  auto& stack = this_thread_async_stack;
+  stack.recorded = level + 1;
+  if (level < async_stack_depth)
+    stack.frames[level] = frame.address();
+}
+
+// Called by the executor for every coroutine between the root and the leaf, on the way back up
+inline void record_async_frame(std::size_t level, std::coroutine_handle<> frame) noexcept
+{
+  if (level < async_stack_depth)
+    this_thread_async_stack.frames[level] = frame.address();
+}
+
+inline void publish_async_stack() noexcept
+{
+  auto& stack = this_thread_async_stack;
+  std::atomic_signal_fence(std::memory_order_release);
+  stack.depth.store(std::min(stack.recorded, async_stack_depth), std::memory_order_relaxed);
+}
+
+inline void clear_async_stack() noexcept
+{
+  this_thread_async_stack.depth.store(0, std::memory_order_relaxed);
+  std::atomic_signal_fence(std::memory_order_acquire);
+}
+
+// A coroutine reached its final suspend point: when it's the innermost frame, its waiter (if any) continues
+inline void leave_async_frame(const void* frame) noexcept
+{
+  auto& stack = this_thread_async_stack;
+  const auto depth = stack.depth.load(std::memory_order_relaxed);
+  if (depth == 0 || stack.recorded != depth || stack.frames[depth - 1] != frame)
+    return;
+
+  stack.recorded = depth - 1;
+  stack.depth.store(depth - 1, std::memory_order_relaxed);
+}
+}  // namespace detail
+
+/**
+ * Frames (coroutine_handle::address()) of the async call chain that the executor is currently running
+ * on this thread, outermost first. Empty when not inside a coroutine resumed by the executor.
+ *
+ * Coroutines that got called but didn't suspend yet aren't part of it: they're attributed to their caller.
+ * The span is only valid until the calling coroutine suspends. Async-signal-safe.
+ */
+inline std::span<const void* const> current_async_stack() noexcept
+{
+  const auto& stack = detail::this_thread_async_stack;
+  const auto depth = stack.depth.load(std::memory_order_relaxed);
+  std::atomic_signal_fence(std::memory_order_acquire);
+  return {stack.frames, depth};
+}
+
+// Whether current_async_stack() lacks innermost frames because the chain is deeper than async_stack_depth
+inline bool current_async_stack_truncated() noexcept
+{
+  return detail::this_thread_async_stack.recorded > async_stack_depth;
+}
+
+/**
+ * Start of the code implementing the coroutine that 'frame' belongs to, for symbolization (e.g. with dladdr).
+ * Relies on the frame layout GCC and Clang share: the resume function's address is stored first.
+ * Async-signal-safe.
+ */
+inline const void* async_frame_function(const void* frame) noexcept
+{
+  if (!frame)
+    return nullptr;
+  return *static_cast<const void* const*>(frame);
+}
+}  // namespace olifilo
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <system_error>
 
 #include "forward.hpp"
@@ -12,6 +13,22 @@ namespace olifilo::detail
 class io_poll_context
 {
   public:
+#if OLIFILO_EXECUTOR_TIMERFD
+    io_poll_context() noexcept;
+    ~io_poll_context();
+
+    io_poll_context(const io_poll_context&) = delete;
+    io_poll_context& operator=(const io_poll_context&) = delete;
+#endif
+
     std::error_code operator()(promise_wait_callgraph& polled);
+
+#if OLIFILO_EXECUTOR_TIMERFD
+  private:
+    // Timeouts are programmed as absolute CLOCK_MONOTONIC deadlines into this timerfd, instead of
+    // being passed as (truncated) relative time to select(). -1 when we failed to create it.
+    int _timer = -1;
+    std::chrono::steady_clock::time_point _armed_deadline;
+#endif
 };
 }  // namespace olifilo::detail
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>
 #include <coroutine>
 #include <exception>
 #include <system_error>
@@ -10,12 +11,16 @@
 #include <utility>
 
 #include "forward.hpp"
+#include "../async_stack.hpp"
+#include "../executor_stats.hpp"
+#include "../memory_budget.hpp"
 
 #include <olifilo/detail/small_vector.hpp>
 #include <olifilo/detail/variant_ptr.hpp>
 #include <olifilo/expected.hpp>
 #include <olifilo/errors.hpp>
 #include <olifilo/io/poll.hpp>
+#include <olifilo/trace.hpp>
 
 namespace olifilo::detail
 {
@@ -34,7 +39,11 @@ struct awaitable_poll;
 
 struct promise_wait_callgraph
 {
+#if OLIFILO_MEMORY_BUDGET
+  using allocator_type = budget_allocator<void*, memory_category::callee_list>;
+#else
   using allocator_type = std::allocator<void*>;
+#endif
 
   promise_wait_callgraph* caller = nullptr;
   sbo_vector<variant_ptr<promise_wait_callgraph, awaitable_poll>> callees;
@@ -45,6 +54,7 @@ struct promise_wait_callgraph
 
   ~promise_wait_callgraph()
   {
+    trace::emit<trace::event::promise_destroy>(this);
     if (caller)
       erase(caller->callees, this);
     for (const auto& callee : callees)
@@ -65,6 +75,8 @@ struct awaitable_poll : private io::poll
 
   expected<void> wait_result = {unexpect, error::uninitialized};
   std::coroutine_handle<> waits_on_me;
+  // when the executor noticed the event (or timeout) that set wait_result
+  std::chrono::steady_clock::time_point ready_at;
 
   // We need the location/address of this struct to be stable, so prohibit copying.
   // But we're still allowing the copy constructor to be callable (but *not* actually called!) by our factory function
@@ -92,7 +104,7 @@ struct awaitable_poll : private io::poll
   {
     assert(waits_on_me == nullptr && "may only await once");
 
-    ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}(event@{}=({}, fd={}, waits_on_me={}))\n", ts(), __LINE__, "awaitable_poll::await_suspend", static_cast<const void*>(this), this->callees, this->fd, this->waits_on_me.address());
+    trace::emit<trace::event::poll_suspend>(this, fd, static_cast<promise_wait_callgraph*>(&suspended.promise()));
 
     // NOTE: have to do this here, instead of await_transform, because we can only know the address of 'this' here
     auto& promise = suspended.promise();
@@ -103,6 +115,9 @@ struct awaitable_poll : private io::poll
       return suspended;
     }
 
+    if (timeout)
+      executor_statistics().add_timer_armed();
+
     waits_on_me = suspended;
     return std::noop_coroutine();
   }
@@ -129,10 +144,25 @@ template <typename T>
 class promise final : private detail::promise_wait_callgraph
 {
   public:
-    future<T> get_return_object() { return future<T>(std::coroutine_handle<promise>::from_promise(*this)); }
+    future<T> get_return_object()
+    {
+      trace::emit<trace::event::promise_create>(static_cast<promise_wait_callgraph*>(this));
+      return future<T>(std::coroutine_handle<promise>::from_promise(*this));
+    }
     static future<T> get_return_object_on_allocation_failure() noexcept { return future<T>(std::coroutine_handle<promise>::from_address(noop_coro_handle.address())); }
+#if OLIFILO_MEMORY_BUDGET
+    // From the current thread's memory_budget, nullptr (i.e. the above) when it's exhausted.
+    // Not inlined: so the return address is inside the coroutine's ramp function, naming the frame's owner.
+    [[gnu::noinline]] static void* operator new(std::size_t size) noexcept { return detail::allocate_frame(size, __builtin_return_address(0)); }
+    static void operator delete(void* frame, std::size_t size) noexcept { detail::deallocate_frame(frame, size); }
+#endif
     constexpr std::suspend_never initial_suspend() noexcept { return {}; }
-    constexpr suspend_always_to final_suspend() noexcept { return {std::exchange(waits_on_me, nullptr)}; }
+    constexpr suspend_always_to final_suspend() noexcept
+    {
+      trace::emit<trace::event::promise_final>(static_cast<promise_wait_callgraph*>(this), returned_value ? 0 : returned_value.error().value());
+      detail::leave_async_frame(std::coroutine_handle<promise>::from_promise(*this).address());
+      return {std::exchange(waits_on_me, nullptr)};
+    }
 
     constexpr void unhandled_exception() noexcept
     {
@@ -164,7 +194,8 @@ class promise final : private detail::promise_wait_callgraph
     template <typename U>
     constexpr future<U>&& await_transform(future<U>&& fut) noexcept
     {
-      if (detail::promise_wait_callgraph* const callee_promise = fut.handle ? &fut.handle.promise() : nullptr)
+      // No promise to link to when allocating the callee's frame failed
+      if (detail::promise_wait_callgraph* const callee_promise = fut.handle && fut.handle.address() != noop_coro_handle.address() ? &fut.handle.promise() : nullptr)
       {
         assert(std::ranges::find(callees, callee_promise) == callees.end());
         if (!callees.push_back(callee_promise, alloc))
@@ -174,6 +205,7 @@ class promise final : private detail::promise_wait_callgraph
         }
         assert(callee_promise->caller == nullptr && "stealing a future someone else is waiting on");
         callee_promise->caller = this;
+        trace::emit<trace::event::await_future>(static_cast<promise_wait_callgraph*>(this), callee_promise);
       }
       return std::move(fut);
     }
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <olifilo/errors.hpp>
+#include <olifilo/expected.hpp>
+
+namespace olifilo
+{
+// Kind of file descriptor that transferred bytes get accounted to
+enum class fd_class : unsigned char
+{
+  other,        // pipes, eventfds, character devices, ...
+  socket,
+  regular_file,
+};
+
+inline constexpr std::size_t fd_class_count = 3;
+
+/**
+ * Log-linear (HDR style) histogram of durations: values below 2^sub_bucket_bits ns get a bucket of
+ * their own, above that every power of two is split into 2^sub_bucket_bits buckets. So quantiles
+ * overestimate by less than 1/2^sub_bucket_bits (~6%) with a fixed amount of memory and without
+ * any allocation. Values from 2^max_exponent ns (~18 minutes) on share the last bucket.
+ */
+class duration_histogram
+{
+  public:
+    static constexpr unsigned    sub_bucket_bits = 4;
+    static constexpr unsigned    max_exponent = 40;
+    static constexpr std::size_t bucket_count = std::size_t(max_exponent - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    void add(std::chrono::nanoseconds value) noexcept
+    {
+      const auto ns = static_cast<std::uint64_t>(std::max(value.count(), std::chrono::nanoseconds::rep(0)));
+      _buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+      auto max = _max.load(std::memory_order_relaxed);
+      while (ns > max && !_max.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+        ;
+    }
+
+    std::uint64_t count() const noexcept
+    {
+      std::uint64_t rv = 0;
+      for (const auto& bucket : _buckets)
+        rv += bucket.load(std::memory_order_relaxed);
+      return rv;
+    }
+
+    std::chrono::nanoseconds max() const noexcept
+    {
+      return std::chrono::nanoseconds(_max.load(std::memory_order_relaxed));
+    }
+
+    // Smallest bucket bound that at least 'fraction' of the values are at or below. Zero when empty.
+    std::chrono::nanoseconds quantile(double fraction) const noexcept
+    {
+      const auto total = count();
+      if (total == 0)
+        return {};
+
+      const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5));
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < bucket_count; ++i)
+      {
+        seen += _buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+          return std::min(std::chrono::nanoseconds(bucket_upper_bound(i)), max());
+      }
+      return max();
+    }
+
+    void reset() noexcept
+    {
+      for (auto& bucket : _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+      _max.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t bucket_of(std::uint64_t ns) noexcept
+    {
+      if (ns < (1u << sub_bucket_bits))
+        return static_cast<std::size_t>(ns);
+
+      const auto exponent = static_cast<unsigned>(std::bit_width(ns)) - 1;
+      if (exponent >= max_exponent)
+        return bucket_count - 1;
+
+      const auto shift = exponent - sub_bucket_bits;
+      return (std::size_t(shift + 1) << sub_bucket_bits) + static_cast<std::size_t>((ns >> shift) & ((1u << sub_bucket_bits) - 1));
+    }
+
+    // Highest value that ends up in 'bucket'
+    static constexpr std::int64_t bucket_upper_bound(std::size_t bucket) noexcept
+    {
+      if (bucket < (1u << sub_bucket_bits))
+        return static_cast<std::int64_t>(bucket);
+
+      const auto shift = static_cast<unsigned>(bucket >> sub_bucket_bits) - 1;
+      const auto lowest = static_cast<std::uint64_t>((1u << sub_bucket_bits) + (bucket & ((1u << sub_bucket_bits) - 1))) << shift;
+      return static_cast<std::int64_t>(lowest + (std::uint64_t(1) << shift) - 1);
+    }
+
+  private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> _buckets{};
+    std::atomic<std::uint64_t>                           _max{0};
+};
+
+static_assert(duration_histogram::bucket_of(15) == 15 && duration_histogram::bucket_of(16) == 16 && duration_histogram::bucket_of(32) == 32);
+static_assert(duration_histogram::bucket_upper_bound(duration_histogram::bucket_of(1000)) >= 1000);
+static_assert(duration_histogram::bucket_of(~std::uint64_t(0)) == duration_histogram::bucket_count - 1);
+
+// Plain copy of the counters at some moment, for exporting.
+struct executor_stats_snapshot
+{
+  std::uint64_t            loop_iterations = 0;
+  std::chrono::nanoseconds blocked_time{};
+  // amount of fd waits handed to select() by the most recent iteration
+  std::uint64_t            fds_registered = 0;
+  std::uint64_t            handlers_resumed = 0;
+  std::uint64_t            max_handlers_resumed_per_iteration = 0;
+  std::uint64_t            timers_armed = 0;
+  std::uint64_t            timers_expired = 0;
+  // eager I/O attempts that completed without waiting vs. ones that had to wait for readiness vs. ones that failed
+  std::uint64_t            eager_io_completed = 0;
+  std::uint64_t            eager_io_would_block = 0;
+  std::uint64_t            eager_io_failed = 0;
+  std::array<std::uint64_t, fd_class_count> bytes_read{};
+  std::array<std::uint64_t, fd_class_count> bytes_written{};
+  // delay between the executor observing an event (or expired timeout) and resuming its waiter
+  std::uint64_t            resume_delay_samples = 0;
+  std::chrono::nanoseconds resume_delay_p50{};
+  std::chrono::nanoseconds resume_delay_p99{};
+  std::chrono::nanoseconds resume_delay_max{};
+};
+
+/**
+ * Process wide executor counters. Every executor (i.e. every thread running future::get()) adds to
+ * the same counters with relaxed atomic operations, so updating them stays cheap and reading them
+ * never blocks an executor. A snapshot is not a consistent cut across all counters.
+ */
+class executor_stats
+{
+  public:
+    executor_stats_snapshot snapshot() const noexcept
+    {
+      executor_stats_snapshot rv;
+      rv.loop_iterations = _loop_iterations.load(std::memory_order_relaxed);
+      rv.blocked_time = std::chrono::nanoseconds(_blocked_ns.load(std::memory_order_relaxed));
+      rv.fds_registered = _fds_registered.load(std::memory_order_relaxed);
+      rv.handlers_resumed = _handlers_resumed.load(std::memory_order_relaxed);
+      rv.max_handlers_resumed_per_iteration = _max_handlers_resumed.load(std::memory_order_relaxed);
+      rv.timers_armed = _timers_armed.load(std::memory_order_relaxed);
+      rv.timers_expired = _timers_expired.load(std::memory_order_relaxed);
+      rv.eager_io_completed = _eager_io_completed.load(std::memory_order_relaxed);
+      rv.eager_io_would_block = _eager_io_would_block.load(std::memory_order_relaxed);
+      rv.eager_io_failed = _eager_io_failed.load(std::memory_order_relaxed);
+      for (std::size_t i = 0; i < fd_class_count; ++i)
+      {
+        rv.bytes_read[i] = _bytes_read[i].load(std::memory_order_relaxed);
+        rv.bytes_written[i] = _bytes_written[i].load(std::memory_order_relaxed);
+      }
+      rv.resume_delay_samples = _resume_delays.count();
+      rv.resume_delay_p50 = _resume_delays.quantile(0.50);
+      rv.resume_delay_p99 = _resume_delays.quantile(0.99);
+      rv.resume_delay_max = _resume_delays.max();
+      return rv;
+    }
+
+    // For other quantiles than the ones in the snapshot
+    const duration_histogram& resume_delays() const noexcept
+    {
+      return _resume_delays;
+    }
+
+    void reset() noexcept;
+
+    void add_iteration(std::chrono::nanoseconds blocked, std::uint64_t fds, std::uint64_t resumed) noexcept
+    {
+      _loop_iterations.fetch_add(1, std::memory_order_relaxed);
+      _blocked_ns.fetch_add(static_cast<std::uint64_t>(blocked.count()), std::memory_order_relaxed);
+      _fds_registered.store(fds, std::memory_order_relaxed);
+      _handlers_resumed.fetch_add(resumed, std::memory_order_relaxed);
+      auto max = _max_handlers_resumed.load(std::memory_order_relaxed);
+      while (resumed > max && !_max_handlers_resumed.compare_exchange_weak(max, resumed, std::memory_order_relaxed))
+        ;
+    }
+
+    void add_timer_armed() noexcept
+    {
+      _timers_armed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add_timer_expired() noexcept
+    {
+      _timers_expired.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Accounts the result of an eager I/O attempt: success, EAGAIN or any other error
+    template <typename T>
+    void add_eager_io(const expected<T>& rv) noexcept
+    {
+      auto& counter = rv ? _eager_io_completed
+        : rv.error() == condition::operation_not_ready ? _eager_io_would_block
+        : _eager_io_failed;
+      counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add_bytes_read(fd_class cls, std::size_t count) noexcept
+    {
+      _bytes_read[std::to_underlying(cls)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void add_bytes_written(fd_class cls, std::size_t count) noexcept
+    {
+      _bytes_written[std::to_underlying(cls)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void add_resume_delay(std::chrono::nanoseconds delay) noexcept
+    {
+      _resume_delays.add(delay);
+    }
+
+  private:
+    std::atomic<std::uint64_t> _loop_iterations{0};
+    std::atomic<std::uint64_t> _blocked_ns{0};
+    std::atomic<std::uint64_t> _fds_registered{0};
+    std::atomic<std::uint64_t> _handlers_resumed{0};
+    std::atomic<std::uint64_t> _max_handlers_resumed{0};
+    std::atomic<std::uint64_t> _timers_armed{0};
+    std::atomic<std::uint64_t> _timers_expired{0};
+    std::atomic<std::uint64_t> _eager_io_completed{0};
+    std::atomic<std::uint64_t> _eager_io_would_block{0};
+    std::atomic<std::uint64_t> _eager_io_failed{0};
+    std::array<std::atomic<std::uint64_t>, fd_class_count> _bytes_read{};
+    std::array<std::atomic<std::uint64_t>, fd_class_count> _bytes_written{};
+    duration_histogram _resume_delays;
+};
+
+executor_stats& executor_statistics() noexcept;
+}  // namespace olifilo
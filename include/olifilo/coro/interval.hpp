@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <system_error>
+#include <utility>
+
+#include "detail/promise.hpp"
+
+#include <olifilo/expected.hpp>
+#include <olifilo/io/poll.hpp>
+
+namespace olifilo
+{
+/**
+ * Periodic timer with an absolute cadence: the n-th tick is due at 'origin + n * period', independent
+ * of how long the work between two ticks took.
+ *
+ * Awaiting tick() doesn't create a coroutine: the returned awaitable is a timeout registration living
+ * in the awaiting coroutine's frame, so a periodic task doesn't allocate per period.
+ */
+class interval
+{
+  public:
+    using clock = io::poll::timeout_clock;
+
+    struct tick_request;
+
+    explicit interval(clock::duration period) noexcept
+      : interval(period, clock::now())
+    {
+    }
+
+    explicit constexpr interval(clock::duration period, clock::time_point origin) noexcept
+      : _period(period)
+      , _next(origin + period)
+    {
+    }
+
+    class tick_awaitable : private detail::awaitable_poll
+    {
+      public:
+        using awaitable_poll::await_ready;
+        using awaitable_poll::await_suspend;
+
+        /**
+         * @returns the amount of ticks that got skipped because we were resumed too late for them.
+         *          Skipped ticks aren't delivered afterwards: the next tick is the first one still in the future.
+         */
+        expected<std::uint64_t> await_resume() noexcept
+        {
+          if (auto r = awaitable_poll::await_resume(); !r && r.error() != std::errc::timed_out)
+            return {unexpect, r.error()};
+
+          return _owner.advance(clock::now());
+        }
+
+      private:
+        explicit constexpr tick_awaitable(interval& owner) noexcept
+          : awaitable_poll(io::poll(owner._next))
+          , _owner(owner)
+        {
+        }
+
+        interval& _owner;
+
+        friend tick_request;
+    };
+
+    // Movable stand-in for tick_awaitable: that one needs a stable address, so only gets created by co_await.
+    struct tick_request
+    {
+      interval& owner;
+
+      tick_awaitable operator co_await() && noexcept
+      {
+        return tick_awaitable(owner);
+      }
+    };
+
+    // Suspends until the next tick is due. Only one tick() may be awaited at a time.
+    constexpr tick_request tick() noexcept
+    {
+      return {*this};
+    }
+
+    constexpr clock::duration period() const noexcept
+    {
+      return _period;
+    }
+
+    constexpr clock::time_point next() const noexcept
+    {
+      return _next;
+    }
+
+  private:
+    constexpr std::uint64_t advance(clock::time_point now) noexcept
+    {
+      const auto missed = now > _next ? static_cast<std::uint64_t>((now - _next) / _period) : 0;
+      _next += _period * static_cast<clock::rep>(missed + 1);
+      return missed;
+    }
+
+    clock::duration   _period;
+    clock::time_point _next;
+};
+}  // namespace olifilo
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+
+#include <sys/socket.h>
+
+#include "socket_descriptor.hpp"
+#include "stream_socket.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+
+namespace olifilo::io
+{
+// Listening stream socket
+class acceptor : public socket_descriptor
+{
+  public:
+    acceptor() = default;
+
+    // Binds to 'addr' (with SO_REUSEADDR) and starts listening
+    static expected<acceptor> create(const ::sockaddr* addr, std::size_t addrlen, int backlog = SOMAXCONN) noexcept;
+
+    // Next connection in the backlog, as non-blocking socket
+    future<stream_socket> accept(eagerness eager = eagerness::eager) noexcept;
+
+  private:
+    explicit constexpr acceptor(file_descriptor_handle fd) noexcept
+      : socket_descriptor(fd)
+    {
+    }
+};
+}  // olifilo::io
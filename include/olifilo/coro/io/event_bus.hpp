@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/events/decoder.hpp>
+#include <olifilo/expected.hpp>
+
+namespace olifilo::io
+{
+class event_bus;
+
+namespace detail
+{
+struct event_queue;
+}  // namespace detail
+
+/**
+ * Untyped subscription to some events of an event_bus, with a queue of fixed capacity that got
+ * allocated when subscribing. Pollable by the executor: its eventfd is readable while events are queued.
+ */
+class event_subscription
+{
+  public:
+    struct header
+    {
+      events::detail::event_base_t base = nullptr;
+      std::int32_t                 id = -1;
+    };
+
+    event_subscription() noexcept;
+    event_subscription(event_subscription&& rhs) noexcept;
+    event_subscription& operator=(event_subscription&& rhs) noexcept;
+    ~event_subscription();
+
+    /**
+     * Takes the oldest queued event, waiting for one when there are none.
+     *
+     * @returns the part of 'payload' the event's payload got copied into, truncated to payload.size()
+     */
+    future<std::span<std::byte>> receive(header& event, std::span<std::byte> payload) noexcept;
+
+    // Events that got dropped because the queue was full when they got posted
+    std::uint64_t dropped() const noexcept;
+
+    explicit operator bool() const noexcept
+    {
+      return static_cast<bool>(_queue);
+    }
+
+  private:
+    friend class event_bus;
+    explicit event_subscription(std::unique_ptr<detail::event_queue> queue) noexcept;
+    void unsubscribe() noexcept;
+
+    std::unique_ptr<detail::event_queue> _queue;
+};
+
+/**
+ * In-process publish/subscribe of events identified like ESP-IDF's: by an event base and an event id
+ * enum, described by specializing events::detail::event_id and events::detail::event. Subscribers
+ * decode them the same way olifilo::esp::events does, see events::decoder.
+ *
+ * Posting is thread safe and never allocates: it copies the event into the queue of every
+ * subscription to it, or drops it for subscriptions that have a full queue. It does take the bus'
+ * lock, and writes to each receiving subscription's eventfd while holding it, so it's serialized
+ * with receivers, (un)subscribing and other posters. It never waits for a queue to drain though.
+ *
+ * Subscriptions should not outlive their bus.
+ */
+class event_bus
+{
+  public:
+    static constexpr std::size_t default_queue_capacity = 16;
+
+    template <events::detail::EventIdEnum auto... EventIds>
+    class subscriber
+    {
+      public:
+        using decoder_t = events::decoder<EventIds...>;
+        using var_event_id_t = typename decoder_t::var_event_id_t;
+        using var_event_t = typename decoder_t::var_event_t;
+        using event_id_t = typename decoder_t::event_id_t;
+        using event_t = typename decoder_t::event_t;
+        using result_t = typename decoder_t::result_t;
+        static constexpr auto max_event_size = decoder_t::max_event_size;
+
+        future<result_t> receive() noexcept
+        {
+          event_subscription::header hdr;
+          alignas(std::max_align_t) std::byte data[max_event_size ? max_event_size : 1];
+          auto payload = co_await _subscription.receive(hdr, std::span(data, max_event_size));
+          if (!payload)
+            co_return {olifilo::unexpect, payload.error()};
+
+          co_return decoder_t::decode(hdr.base, hdr.id, *payload);
+        }
+
+        std::uint64_t dropped() const noexcept
+        {
+          return _subscription.dropped();
+        }
+
+        explicit operator bool() const noexcept
+        {
+          return static_cast<bool>(_subscription);
+        }
+
+      private:
+        event_subscription _subscription;
+
+        friend class event_bus;
+        explicit subscriber(event_subscription subscription) noexcept
+          : _subscription(std::move(subscription))
+        {
+        }
+
+        static expected<subscriber> create(event_bus& bus, std::size_t queue_capacity) noexcept
+        {
+          auto subscription = bus.subscribe({
+              {events::detail::event_id<decltype(EventIds)>::base, static_cast<std::int32_t>(EventIds)}...
+            }, max_event_size, queue_capacity);
+          if (!subscription)
+            return {unexpect, subscription.error()};
+          return subscriber(*std::move(subscription));
+        }
+    };
+
+    event_bus() = default;
+    ~event_bus();
+
+    event_bus(const event_bus&) = delete;
+    event_bus& operator=(const event_bus&) = delete;
+
+    template <events::detail::EventIdEnum auto... EventIds>
+    auto subscribe(std::size_t queue_capacity = default_queue_capacity) noexcept
+    {
+      // use decltype() and call create() ourselves to avoid code-gen for the index_sequence overload
+      constexpr auto indices = events::detail::sort_indices<EventIds...>();
+      return std::remove_pointer_t<decltype(subscribe<indices, EventIds...>(std::make_index_sequence<indices.size()>()))>::create(*this, queue_capacity);
+    }
+
+    /**
+     * @param event_data_size largest payload of the subscribed to events, larger ones get truncated
+     */
+    expected<event_subscription> subscribe(
+        std::initializer_list<std::tuple<events::detail::event_base_t, std::int32_t>> events
+      , std::size_t event_data_size
+      , std::size_t queue_capacity = default_queue_capacity
+      ) noexcept;
+
+    // @returns the amount of subscriptions the event got queued for
+    std::size_t post(events::detail::event_base_t base, std::int32_t id, std::span<const std::byte> data = {}) noexcept;
+
+    template <events::detail::EventIdEnum auto EventId>
+    requires(std::is_void_v<events::detail::event_t<EventId>>)
+    std::size_t post() noexcept
+    {
+      return post(events::detail::event_id<decltype(EventId)>::base, static_cast<std::int32_t>(EventId));
+    }
+
+    template <events::detail::EventIdEnum auto EventId>
+    requires(!std::is_void_v<events::detail::event_t<EventId>>)
+    std::size_t post(const events::detail::event_t<EventId>& data) noexcept
+    {
+      static_assert(std::is_trivially_copyable_v<events::detail::event_t<EventId>>, "event payloads get copied byte-wise");
+      return post(events::detail::event_id<decltype(EventId)>::base, static_cast<std::int32_t>(EventId), as_bytes(std::span(&data, 1)));
+    }
+
+  private:
+    // helper that selects an instance of 'subscriber' with sorted and deduplicated EventIds to reduce instantiations
+    template <auto indices, events::detail::EventIdEnum auto... EventIds, std::size_t... Is>
+    static consteval auto subscribe(std::index_sequence<Is...>) noexcept
+    {
+      using input_t = std::tuple<std::integral_constant<decltype(EventIds), EventIds>...>;
+      return static_cast<subscriber<std::tuple_element_t<indices[Is], input_t>::value...>*>(nullptr);
+    }
+
+    friend class event_subscription;
+
+    std::mutex           _lock;
+    // intrusive list of our subscriptions' queues
+    detail::event_queue* _subscriptions = nullptr;
+};
+}  // namespace olifilo::io
@@ -8,6 +8,7 @@
 
 #include "types.hpp"
 
+#include <olifilo/coro/executor_stats.hpp>
 #include <olifilo/coro/future.hpp>
 #include <olifilo/io/types.hpp>
 
@@ -80,6 +81,13 @@ class file_descriptor
     future<std::span<std::byte>> read(std::span<std::byte> buf, eagerness eager = eagerness::eager) noexcept;
     future<void> write(std::span<const std::byte> buf, eagerness eager = eagerness::eager) noexcept;
 
+  protected:
+    // What transferred bytes get accounted as in executor_statistics()
+    virtual fd_class io_class() const noexcept
+    {
+      return fd_class::other;
+    }
+
   private:
     io::file_descriptor_handle _fd;
 };
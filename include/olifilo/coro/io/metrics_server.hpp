@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include "acceptor.hpp"
+#include "tcp_metrics.hpp"
+
+#include <olifilo/coro/executor_stats.hpp>
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+#include <olifilo/mqtt/stats.hpp>
+
+namespace olifilo::io
+{
+struct metrics_sources
+{
+  bool               executor = true;
+  bool               mqtt = true;
+  const tcp_metrics* tcp = nullptr;
+};
+
+struct metrics_snapshot
+{
+  std::optional<executor_stats_snapshot>                    executor;
+  std::optional<mqtt_stats_snapshot>                        mqtt;
+  std::vector<std::pair<std::string, tcp_endpoint_metrics>> tcp;
+};
+
+/**
+ * Renders a snapshot of already aggregated counters in the Prometheus text exposition format.
+ *
+ * Rendering is incremental: every render() call only produces the whole lines that fit in the
+ * provided buffer, so a caller can send and yield between chunks regardless of the amount of metrics.
+ */
+class prometheus_renderer
+{
+  public:
+    // Takes the snapshot to render
+    static expected<prometheus_renderer> create(const metrics_sources& sources) noexcept;
+
+    // Next chunk of output in 'buf', empty when done. Lines that don't fit in an empty 'buf' get skipped.
+    std::span<const char> render(std::span<char> buf) noexcept;
+
+    bool done() const noexcept;
+
+  private:
+    explicit prometheus_renderer(metrics_snapshot&& snapshot) noexcept
+      : _snapshot(std::move(snapshot))
+    {
+    }
+
+    metrics_snapshot _snapshot;
+    // position: metric family, line within that family (HELP, TYPE, samples...)
+    std::size_t      _family = 0;
+    std::size_t      _line = 0;
+};
+
+/**
+ * Minimal HTTP/1.1 server for Prometheus scrapes: answers "GET /metrics" with prometheus_renderer's
+ * output using chunked transfer encoding and closes the connection afterwards.
+ *
+ * Connections get handled one at a time. Every chunk is sent lazily, i.e. through the executor,
+ * so a scrape is interleaved with other coroutines instead of stalling them.
+ */
+class metrics_server
+{
+  public:
+    static expected<metrics_server> create(const ::sockaddr* addr, std::size_t addrlen, metrics_sources sources) noexcept;
+
+    // Serves scrapes until accepting fails. Failing scrapes only close their own connection.
+    future<void> serve() noexcept;
+
+    // Maximum time a single client gets for sending its request and receiving the response
+    std::chrono::milliseconds client_timeout{5000};
+
+  private:
+    metrics_server(acceptor&& listener, metrics_sources sources) noexcept
+      : _listener(std::move(listener))
+      , _sources(sources)
+    {
+    }
+
+    future<void> serve_client(stream_socket client) noexcept;
+
+    acceptor        _listener;
+    metrics_sources _sources;
+};
+}  // namespace olifilo::io
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include <sys/types.h>
+
+#include "file_descriptor.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+
+namespace olifilo::io
+{
+// Regular files are always 'ready' according to select(), but reading or writing them can still
+// block on the disk. So instead of polling, the system calls get executed on a pool of worker threads
+// and only their completion notification is polled for.
+class regular_file : public file_descriptor
+{
+  public:
+    regular_file() = default;
+
+    static expected<regular_file> open(const char* path, int flags, ::mode_t mode = 0666) noexcept;
+
+    /**
+     * @returns the part of 'buf' that got filled, which is only shorter than 'buf' at EOF.
+     */
+    future<std::span<std::byte>> pread(std::span<std::byte> buf, ::off_t offset) noexcept;
+    future<void> pwrite(std::span<const std::byte> buf, ::off_t offset) noexcept;
+
+    future<void> fsync() noexcept;
+    future<void> fdatasync() noexcept;
+
+  protected:
+    fd_class io_class() const noexcept override
+    {
+      return fd_class::regular_file;
+    }
+
+  private:
+    regular_file(file_descriptor_handle fd, file_descriptor_handle completion) noexcept
+      : file_descriptor(fd)
+      , _completion(completion)
+    {
+    }
+
+    // eventfd signalled by the worker threads when they complete an operation for this file
+    file_descriptor _completion;
+};
+}  // olifilo::io
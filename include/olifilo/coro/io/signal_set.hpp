@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <initializer_list>
+
+#include <signal.h>
+
+#include "file_descriptor.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+
+namespace olifilo::io
+{
+// Receives signals as regular events in the executor instead of via asynchronous handlers
+class signal_set : public file_descriptor
+{
+  public:
+    signal_set() = default;
+
+    /**
+     * Blocks delivery of 'signals' for the calling thread and makes them available through next() instead.
+     *
+     * @note signals stay blocked after destruction: another signal_set, or a thread that was
+     *       created after this one, may still depend on that.
+     * @note create this before starting any other thread: those inherit the blocked signal mask.
+     *       Otherwise the kernel may deliver the signal to a thread that didn't block it.
+     */
+    static expected<signal_set> create(std::initializer_list<int> signals) noexcept;
+
+    /**
+     * @returns the number of the next received signal
+     */
+    future<int> next() noexcept;
+
+  private:
+    explicit constexpr signal_set(file_descriptor_handle fd) noexcept
+      : file_descriptor(fd)
+    {
+    }
+};
+}  // olifilo::io
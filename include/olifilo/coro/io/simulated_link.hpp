@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "stream_socket.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+
+namespace olifilo::io
+{
+// Shaping applied to one direction of a simulated_link
+struct link_conditions
+{
+  // one way propagation delay
+  std::chrono::nanoseconds latency{};
+  // uniformly distributed extra delay in [0, jitter] per segment
+  std::chrono::nanoseconds jitter{};
+  // serialization rate, 0 means unlimited
+  std::uint64_t            bytes_per_second = 0;
+  // probability of a segment getting lost, every loss delays it by 'retransmit_timeout'
+  double                   loss = 0;
+  std::chrono::nanoseconds retransmit_timeout = std::chrono::milliseconds(200);
+  // probability of a segment arriving 'reorder_delay' late
+  double                   reorder = 0;
+  std::chrono::nanoseconds reorder_delay = std::chrono::milliseconds(10);
+  std::size_t              segment_size = 1448;
+  // bytes accepted into the link before the sender gets back pressure
+  std::size_t              window = 64 * 1024;
+  std::uint64_t            seed = 1;
+};
+
+struct link_statistics
+{
+  std::uint64_t segments = 0;
+  std::uint64_t bytes = 0;
+  std::uint64_t lost = 0;
+  std::uint64_t reordered = 0;
+};
+
+/**
+ * In-process stand-in for a network connection: two connected stream_sockets ('a' and 'b') with
+ * configurable latency, bandwidth, loss and reordering in between.
+ *
+ * Each end is one side of a socketpair, so it supports everything a connected stream_socket does.
+ * run() carries the data across between the other sides of both pairs, in segments of at most
+ * 'segment_size', each delivered when the simulated link would have delivered it. The link behaves
+ * like TCP does for its user: data is never lost or reordered, lost segments (retransmitted after
+ * 'retransmit_timeout') and reordered segments instead delay the data behind them too.
+ *
+ * All timing uses executor_clock, so with an io::virtual_time in scope WAN conditions get simulated
+ * without waiting for them.
+ */
+class simulated_link
+{
+  public:
+    static expected<simulated_link> create(const link_conditions& a_to_b, const link_conditions& b_to_a) noexcept;
+
+    static expected<simulated_link> create(const link_conditions& conditions = {}) noexcept
+    {
+      return create(conditions, conditions);
+    }
+
+    /**
+     * Carries data in both directions. A direction ends, by shutting down the receiver's write side,
+     * when the sender's end got shut down or closed. Only completes when both directions ended,
+     * so run it next to the users of 'a' and 'b' with when_all or when_any.
+     *
+     * This object has to stay in place for as long as run() is running.
+     */
+    future<void> run() noexcept;
+
+    const link_statistics& a_to_b_statistics() const noexcept
+    {
+      return _a_to_b_stats;
+    }
+
+    const link_statistics& b_to_a_statistics() const noexcept
+    {
+      return _b_to_a_stats;
+    }
+
+    // The user visible ends of the link, move them out to use them
+    stream_socket a;
+    stream_socket b;
+
+  private:
+    simulated_link() = default;
+
+    // the other sides of the socketpairs of 'a' and 'b'
+    stream_socket   _a_inner;
+    stream_socket   _b_inner;
+    link_conditions _a_to_b;
+    link_conditions _b_to_a;
+    link_statistics _a_to_b_stats;
+    link_statistics _b_to_a_stats;
+};
+}  // namespace olifilo::io
@@ -27,5 +27,11 @@ class socket_descriptor : public file_descriptor
     {
       return send(std::span<const std::span<const std::byte>>(bufs), eager);
     }
+
+  protected:
+    fd_class io_class() const noexcept override
+    {
+      return fd_class::socket;
+    }
 };
 }  // olifilo::io
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "stream_socket.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+#include <olifilo/io/sockopts/tcp.hpp>
+
+namespace olifilo::io
+{
+// TCP_INFO samples aggregated over every sampled connection to the same peer
+struct tcp_endpoint_metrics
+{
+  std::uint64_t             connections = 0;
+  std::uint64_t             samples = 0;
+  std::chrono::microseconds rtt_last{};
+  std::chrono::microseconds rtt_min = std::chrono::microseconds::max();
+  std::chrono::microseconds rtt_max{};
+  std::chrono::microseconds rtt_sum{};
+  std::chrono::microseconds rtt_variance_last{};
+  // increase of the connections' total_retransmits counters since they got sampled first (inclusive)
+  std::uint64_t             retransmits = 0;
+  std::uint32_t             congestion_window_last = 0;
+  std::uint32_t             congestion_window_min = std::numeric_limits<std::uint32_t>::max();
+  std::uint32_t             unacked_last = 0;
+  std::uint32_t             unacked_max = 0;
+  std::uint32_t             lost_max = 0;
+
+  constexpr std::chrono::microseconds rtt_mean() const noexcept
+  {
+    return samples ? rtt_sum / static_cast<std::chrono::microseconds::rep>(samples) : std::chrono::microseconds{};
+  }
+};
+
+// Thread safe registry of tcp_endpoint_metrics, keyed by the peer's "address:port"
+class tcp_metrics
+{
+  public:
+    /**
+     * @param new_retransmits retransmits that happened since the previous sample of the same connection
+     * @param first_sample    whether this is the first sample of a connection
+     */
+    expected<void> record(std::string_view endpoint, const tcp_connection_info& info, std::uint32_t new_retransmits, bool first_sample) noexcept;
+
+    std::vector<std::pair<std::string, tcp_endpoint_metrics>> snapshot() const;
+
+    void reset() noexcept;
+
+  private:
+    mutable std::mutex                                          _lock;
+    std::map<std::string, tcp_endpoint_metrics, std::less<>>   _endpoints;
+};
+
+// "address:port" ("[address]:port" for IPv6) of 'fd's peer, or the path of a unix socket
+expected<std::string> peer_name(file_descriptor_handle fd) noexcept;
+
+/**
+ * Samples TCP_INFO of 'socket' immediately and then every 'period' into the entry for its peer in 'metrics'.
+ * Only completes (with success) when the connection got closed, so run it next to the socket's user
+ * with when_any. Must be started on a connected socket.
+ */
+future<void> sample_tcp_info(const stream_socket& socket, tcp_metrics& metrics, std::chrono::milliseconds period) noexcept;
+}  // namespace olifilo::io
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "file_descriptor.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+#include <olifilo/io/poll.hpp>
+
+namespace olifilo::io
+{
+// Kernel timer (timerfd) with nanosecond resolution and absolute CLOCK_MONOTONIC deadlines.
+// Unlike a timeout on io::poll the deadline isn't converted to a relative timeout again on every
+// executor iteration, and periodic timers keep their cadence without being reprogrammed.
+// Being a kernel timer it always runs on real time, even with an io::virtual_time in scope.
+class timer : public file_descriptor
+{
+  public:
+    using clock = std::chrono::steady_clock;
+
+    timer() = default;
+
+    static expected<timer> create() noexcept;
+
+    /**
+     * @param deadline first expiration
+     * @param period   when non-zero: expire again every 'period' after 'deadline'
+     */
+    expected<void> arm(clock::time_point deadline, clock::duration period = {}) noexcept;
+    expected<void> disarm() noexcept;
+
+    /**
+     * @returns the amount of expirations since the last call to wait(). This is larger than 1 when
+     *          a periodic timer expired multiple times before we got around to waiting on it.
+     */
+    future<std::uint64_t> wait() noexcept;
+
+  private:
+    explicit constexpr timer(file_descriptor_handle fd) noexcept
+      : file_descriptor(fd)
+    {
+    }
+};
+}  // olifilo::io
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <linux/errqueue.h>
+
+#include "socket_descriptor.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+#include <olifilo/io/sockopts/socket.hpp>
+
+// Kernel timestamping of received and sent data. Enable it first with:
+//   io::setsockopt<io::sol_socket::timestamping>(fd, io::timestamping::rx_software | io::timestamping::software | ...)
+// Hardware timestamps additionally need the network interface to be configured for it (SIOCSHWTSTAMP).
+
+namespace olifilo::io
+{
+struct kernel_timestamps
+{
+  // CLOCK_REALTIME
+  std::optional<std::chrono::system_clock::time_point> software;
+  // the NIC's own clock, not synchronized with CLOCK_REALTIME
+  std::optional<std::chrono::nanoseconds>              hardware;
+};
+
+struct timestamped_read
+{
+  std::span<std::byte> data;
+  kernel_timestamps    timestamps;
+};
+
+enum class tx_stage : std::uint32_t
+{
+  scheduled    = SCM_TSTAMP_SCHED,   // entered the packet scheduler
+  sent         = SCM_TSTAMP_SND,     // handed to the driver (software) or put on the wire (hardware)
+  acknowledged = SCM_TSTAMP_ACK,     // TCP: all data up to 'id' got acknowledged by the peer
+};
+
+struct tx_timestamp
+{
+  tx_stage          stage;
+  // with timestamping::id: stream sockets: offset of the last byte of the send() it belongs to, datagram sockets: datagram number
+  std::uint32_t     id;
+  kernel_timestamps timestamps;
+};
+
+// Extracts SCM_TIMESTAMPING from a recvmsg() control buffer
+kernel_timestamps parse_timestamps(std::span<const std::byte> control) noexcept;
+
+// read_some() that also returns the kernel's receive timestamps of the data
+future<timestamped_read> read_some_timestamped(const socket_descriptor& socket, std::span<std::byte> buf, eagerness eager = eagerness::eager) noexcept;
+
+/**
+ * Takes the next TX timestamp from the socket's error queue, std::nullopt when there is none (yet).
+ *
+ * @note not awaitable: select() only reports a pending error queue as readability, so waiting for it
+ *       would spin for as long as regular data is pending. Poll this after the data got sent
+ *       (e.g. when its reply arrived) instead.
+ */
+expected<std::optional<tx_timestamp>> read_tx_timestamp(const socket_descriptor& socket) noexcept;
+}  // namespace olifilo::io
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+#include "stream_socket.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/expected.hpp>
+
+struct ssl_ctx_st;
+
+namespace olifilo::io
+{
+enum class tls_error
+{
+  handshake_failed = 1,
+  certificate_verify_failed,
+  ktls_unavailable,
+  invalid_certificate,
+};
+
+struct tls_error_category_t : std::error_category
+{
+  const char* name() const noexcept override;
+  std::string message(int ev) const override;
+};
+
+constexpr const tls_error_category_t& tls_error_category() noexcept
+{
+  static tls_error_category_t cat;
+  return cat;
+}
+
+inline std::error_code make_error_code(tls_error e)
+{
+  return {static_cast<int>(e), tls_error_category()};
+}
+
+class tls_context
+{
+  public:
+    enum class verify
+    {
+      none,
+      peer,
+    };
+
+    static expected<tls_context> create_client(verify verify_mode = verify::peer) noexcept;
+
+    expected<void> use_default_verify_paths() noexcept;
+    expected<void> add_trust_anchor(std::string_view pem) noexcept;
+
+    constexpr ::ssl_ctx_st* native_handle() const noexcept
+    {
+      return _ctx.get();
+    }
+
+  private:
+    struct deleter
+    {
+      void operator()(::ssl_ctx_st* ctx) const noexcept;
+    };
+
+    explicit tls_context(::ssl_ctx_st* ctx) noexcept
+      : _ctx(ctx)
+    {
+    }
+
+    std::unique_ptr<::ssl_ctx_st, deleter> _ctx;
+};
+
+/**
+ * Performs a TLS client handshake on an already connected socket in user space and subsequently
+ * hands the record layer for both directions to the kernel (Linux kTLS, TCP_ULP "tls").
+ *
+ * After successful completion 'sock' carries plain application data: 'send', 'read', 'write' etc.
+ * are used unchanged and get encrypted/decrypted by the kernel. Only TLS 1.2 gets negotiated for that
+ * reason: TLS 1.3's post-handshake messages would make plain reads fail with EIO.
+ *
+ * @param server_name used for SNI and, when verifying, for matching against the peer's certificate.
+ * @returns tls_error::ktls_unavailable when the kernel or negotiated cipher can't be offloaded.
+ *          The connection is unusable in that case as the handshake has already completed.
+ *
+ * @note the kernel doesn't send close_notify for us, so closing the connection is indistinguishable
+ *       from truncation at the TLS level. Protocols on top (like MQTT's DISCONNECT) need to handle
+ *       that themselves.
+ */
+future<void> start_ktls(stream_socket& sock, const tls_context& ctx, const char* server_name) noexcept;
+}  // namespace olifilo::io
+
+template <>
+struct std::is_error_code_enum<olifilo::io::tls_error> : true_type {};
@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+namespace olifilo
+{
+enum class memory_category : unsigned char
+{
+  coroutine_frame,
+  // promise_wait_callgraph::callees beyond their inline capacity
+  callee_list,
+  buffer,
+  queue,
+};
+
+inline constexpr std::size_t memory_category_count = 4;
+
+struct memory_usage
+{
+  std::size_t   current = 0;
+  std::size_t   high_water = 0;
+  std::uint64_t allocations = 0;
+  // allocations refused because they'd exceed the limit, or because upstream failed
+  std::uint64_t failures = 0;
+};
+
+class memory_budget;
+
+/**
+ * Sees every allocation a memory_budget grants, e.g. to attribute them to code in tests.
+ *
+ * 'caller' is an address inside the code that asked for the memory: for coroutine frames that's the
+ * coroutine's own (ramp) function, nullptr when unknown.
+ */
+class allocation_observer
+{
+  public:
+    virtual void allocated(memory_category category, std::size_t size, const void* caller) noexcept = 0;
+
+  protected:
+    ~allocation_observer() = default;
+};
+
+namespace detail
+{
+constinit inline thread_local memory_budget* this_thread_memory_budget = nullptr;
+}  // namespace detail
+
+/**
+ * Hard cap, with accounting per memory_category, on what gets allocated on behalf of the executor
+ * (i.e. future::get()) on the current thread while this is in scope.
+ *
+ * When built with OLIFILO_MEMORY_BUDGET, coroutine frames and callee lists of coroutines started
+ * while a budget is in scope get allocated from it. Exceeding the limit then fails like any other
+ * allocation failure does: the future reports error::coro_bad_alloc, waits report not_enough_memory.
+ * Every allocation remembers its budget, so the budget has to outlive them. With a
+ * static_pool_resource as upstream none of this touches the heap.
+ *
+ * Buffers and queues can be accounted too, by allocating them from resource(category), which works
+ * without OLIFILO_MEMORY_BUDGET as well.
+ *
+ * Not thread safe: a budget belongs to the thread (and so to the executor) that created it.
+ */
+class memory_budget : public std::pmr::memory_resource
+{
+  public:
+    explicit memory_budget(std::size_t limit, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) noexcept;
+    ~memory_budget() override;
+
+    memory_budget(const memory_budget&) = delete;
+    memory_budget& operator=(const memory_budget&) = delete;
+
+    // The innermost memory_budget in scope on this thread, if any
+    static memory_budget* current() noexcept
+    {
+      return detail::this_thread_memory_budget;
+    }
+
+    // nullptr when exceeding the limit or when upstream fails
+    void* allocate_for(memory_category category, std::size_t size, std::size_t alignment = alignof(std::max_align_t), const void* caller = nullptr) noexcept;
+    void deallocate_for(memory_category category, void* p, std::size_t size, std::size_t alignment = alignof(std::max_align_t)) noexcept;
+
+    // Allocates from this budget, accounted as 'category'. Throws std::bad_alloc when exceeding the limit.
+    std::pmr::memory_resource* resource(memory_category category) noexcept
+    {
+      return &_resources[static_cast<std::size_t>(category)];
+    }
+
+    std::size_t limit() const noexcept
+    {
+      return _limit;
+    }
+
+    std::size_t used() const noexcept
+    {
+      return _used;
+    }
+
+    std::size_t high_water() const noexcept
+    {
+      return _high_water;
+    }
+
+    const memory_usage& usage(memory_category category) const noexcept
+    {
+      return _usage[static_cast<std::size_t>(category)];
+    }
+
+    // Restarts high-water marks from the current usage
+    void reset_high_water() noexcept;
+
+    // Only one at a time, nullptr to stop observing
+    void observe(allocation_observer* observer) noexcept
+    {
+      _observer = observer;
+    }
+
+  private:
+    class category_resource : public std::pmr::memory_resource
+    {
+      public:
+        memory_budget*  budget = nullptr;
+        memory_category category = memory_category::buffer;
+
+      private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t size, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override;
+    };
+
+    // Directly used as memory_resource: accounted as buffer
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t size, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override;
+
+    std::pmr::memory_resource*                               _upstream;
+    std::size_t                                              _limit;
+    std::size_t                                              _used = 0;
+    std::size_t                                              _high_water = 0;
+    std::array<memory_usage, memory_category_count>          _usage{};
+    std::array<category_resource, memory_category_count>     _resources;
+    memory_budget*                                           _previous;
+    allocation_observer*                                     _observer = nullptr;
+};
+
+/**
+ * Allocator taking from the memory_budget that was current when it got created, or from the global
+ * heap without one. Failing allocations throw std::bad_alloc, or return nullptr without exceptions.
+ */
+template <typename T, memory_category Category>
+struct budget_allocator
+{
+  using value_type = T;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = budget_allocator<U, Category>;
+  };
+
+  memory_budget* budget = memory_budget::current();
+
+  budget_allocator() noexcept = default;
+
+  template <typename U>
+  budget_allocator(const budget_allocator<U, Category>& rhs) noexcept
+    : budget(rhs.budget)
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    if (!budget)
+      return std::allocator<T>().allocate(n);
+
+    if (auto* const p = budget->allocate_for(Category, n * sizeof(T), alignof(T)))
+      return static_cast<T*>(p);
+#if __cpp_exceptions
+    throw std::bad_alloc();
+#else
+    return nullptr;
+#endif
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    if (!budget)
+      std::allocator<T>().deallocate(p, n);
+    else
+      budget->deallocate_for(Category, p, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U>
+  friend bool operator==(const budget_allocator& lhs, const budget_allocator<U, Category>& rhs) noexcept
+  {
+    return lhs.budget == rhs.budget;
+  }
+};
+
+namespace detail
+{
+// Coroutine frame allocation: from the current memory_budget, if any. nullptr on failure.
+// 'caller' is the coroutine's ramp function, the one the frame belongs to.
+void* allocate_frame(std::size_t size, const void* caller) noexcept;
+void deallocate_frame(void* frame, std::size_t size) noexcept;
+}  // namespace detail
+}  // namespace olifilo
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <span>
+
+namespace olifilo
+{
+// One size class of a static_pool_resource
+struct pool_class
+{
+  std::size_t block_size;
+  std::size_t block_count;
+};
+
+struct pool_usage
+{
+  std::size_t   block_size = 0;
+  std::size_t   block_count = 0;
+  std::size_t   in_use = 0;
+  std::size_t   high_water = 0;
+  // times an allocation wanted a block from this size class after it got exhausted (it may still
+  // have been served by a larger class), for the largest class also allocations too large for any
+  std::uint64_t failures = 0;
+};
+
+namespace detail
+{
+struct block_pool
+{
+  std::size_t offset;
+  std::size_t block_size;
+  std::size_t block_count;
+  // blocks that got handed out at least once, the free list only contains those
+  std::size_t touched = 0;
+  void*       free_list = nullptr;
+  std::size_t in_use = 0;
+  std::size_t high_water = 0;
+  std::uint64_t failures = 0;
+};
+
+// nullptr when no block of at least 'size' bytes is free anymore
+void* pool_allocate(std::byte* storage, std::span<block_pool> pools, std::size_t size, std::size_t alignment) noexcept;
+void pool_deallocate(std::byte* storage, std::span<block_pool> pools, void* p) noexcept;
+}  // namespace detail
+
+/**
+ * Memory resource handing out fixed size blocks from storage that's part of this object, so the
+ * amount of memory available is fixed at compile time. Meant to be constinit and used as upstream
+ * of a memory_budget: with OLIFILO_MEMORY_BUDGET every coroutine frame and callee list then comes
+ * out of these pools instead of the heap, and exhaustion gets reported like any allocation failure.
+ *
+ * Allocations take a block of the smallest size class that fits and is not exhausted. Blocks never
+ * get split or merged, so there is no fragmentation beyond rounding up to the block size.
+ *
+ * Not thread safe, just like memory_budget.
+ */
+template <pool_class... Classes>
+requires(sizeof...(Classes) > 0)
+class static_pool_resource : public std::pmr::memory_resource
+{
+  public:
+    static_assert(((Classes.block_size % alignof(std::max_align_t) == 0 && Classes.block_size != 0) && ...),
+        "block sizes should be multiples of the maximum fundamental alignment");
+    static_assert([] {
+          const std::array<pool_class, sizeof...(Classes)> classes{Classes...};
+          for (std::size_t i = 1; i < classes.size(); ++i)
+            if (classes[i - 1].block_size >= classes[i].block_size)
+              return false;
+          return true;
+        }(), "size classes should be ordered from small to large blocks");
+
+    constexpr static_pool_resource() noexcept
+    {
+      std::size_t offset = 0;
+      std::size_t i = 0;
+      for (const auto& c : std::array<pool_class, sizeof...(Classes)>{Classes...})
+      {
+        _pools[i++] = {.offset = offset, .block_size = c.block_size, .block_count = c.block_count};
+        offset += c.block_size * c.block_count;
+      }
+    }
+
+    static_pool_resource(const static_pool_resource&) = delete;
+    static_pool_resource& operator=(const static_pool_resource&) = delete;
+
+    static constexpr std::size_t size_classes = sizeof...(Classes);
+    static constexpr std::size_t storage_size = ((Classes.block_size * Classes.block_count) + ...);
+
+    pool_usage usage(std::size_t size_class) const noexcept
+    {
+      const auto& pool = _pools[size_class];
+      return {
+        .block_size = pool.block_size,
+        .block_count = pool.block_count,
+        .in_use = pool.in_use,
+        .high_water = pool.high_water,
+        .failures = pool.failures,
+      };
+    }
+
+  private:
+    void* do_allocate(std::size_t size, std::size_t alignment) override
+    {
+      if (auto* const p = detail::pool_allocate(_storage, _pools, size, alignment))
+        return p;
+#if __cpp_exceptions
+      throw std::bad_alloc();
+#else
+      return nullptr;
+#endif
+    }
+
+    void do_deallocate(void* p, std::size_t, std::size_t) override
+    {
+      detail::pool_deallocate(_storage, _pools, p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+    {
+      return this == &rhs;
+    }
+
+    std::array<detail::block_pool, sizeof...(Classes)> _pools{};
+    alignas(std::max_align_t) std::byte                 _storage[storage_size]{};
+};
+}  // namespace olifilo
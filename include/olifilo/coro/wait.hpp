@@ -2,27 +2,32 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <concepts>
 #include <cstddef>
 #include <optional>
 #include <ranges>
+#include <span>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "future.hpp"
 #include <olifilo/detail/small_vector.hpp>
+#include <olifilo/io/clock.hpp>
 
 namespace olifilo
 {
 namespace detail
 {
-using wait_clock = std::chrono::steady_clock;
+using wait_clock = io::executor_clock;
 
 template <typename T>
 constexpr bool is_time_point = false;
 
 template <typename Duration>
-constexpr bool is_time_point<std::chrono::time_point<wait_clock, Duration>> = true;
+constexpr bool is_time_point<std::chrono::time_point<wait_clock::time_point::clock, Duration>> = true;
 
 template <typename T>
 constexpr bool is_time_point<std::optional<T>> = is_time_point<T>;
@@ -70,14 +75,82 @@ enum class until
   first_completed,
 };
 
+namespace detail
+{
+/**
+ * Non-template core of wait, when_all and when_any: makes the coroutine it lives in wait on a set of
+ * promises, so that every combination of future types only costs its caller a suspension loop
+ * instead of another coroutine.
+ *
+ * Usage from within coroutine 'me', which has to stay suspended until poll() returns a result:
+ *
+ *   detail::wait_core waiter(me_promise, me);
+ *   if (auto r = waiter.start(...); !r) ...
+ *   std::optional<expected<std::size_t>> r;
+ *   while (!(r = waiter.poll()))
+ *     co_await std::suspend_always();
+ *
+ * Once poll() returns a result the promises aren't waited on anymore, so the futures may be
+ * consumed or destroyed. Destruction takes care of that when 'me' gets destroyed early.
+ */
+class wait_core
+{
+  public:
+    explicit wait_core(promise_wait_callgraph& me_promise, std::coroutine_handle<> me) noexcept
+      : _me_promise(me_promise)
+      , _me(me)
+    {
+    }
+
+    ~wait_core();
+
+    wait_core(const wait_core&) = delete;
+    wait_core& operator=(const wait_core&) = delete;
+
+    /**
+     * @param promises nullptr represents a future that's done(). Only has to stay valid until this
+     *                 returns: it's copied into the waiting promise's callee list.
+     */
+    expected<void> start(
+        until                                            wait_until
+      , std::span<promise_wait_callgraph* const>         promises
+      , std::optional<wait_clock::time_point>            timeout
+      ) noexcept;
+
+    template <typename... Ts>
+    expected<void> start(until wait_until, std::optional<wait_clock::time_point> timeout, future<Ts>&... futures) noexcept;
+
+    /**
+     * @returns std::nullopt while still waiting. Otherwise the *first* index into 'promises' that
+     *          represents a ready future, 0 for until::all_completed, or the error that ended waiting
+     *          (i.e. timing out).
+     */
+    std::optional<expected<std::size_t>> poll() noexcept;
+
+  private:
+    // Restores the promises to not being waited on
+    void stop() noexcept;
+
+    promise_wait_callgraph&       _me_promise;
+    std::coroutine_handle<>       _me;
+    until                         _until = until::all_completed;
+    bool                          _started = false;
+    std::optional<awaitable_poll> _timeout_event;
+};
+}  // namespace detail
+
 struct wait_t
 {
   using clock = detail::wait_clock;
   using duration = clock::duration;
 
   /**
+   * The one coroutine doing all the waiting: every other overload only collects promises for it, so
+   * that waiting on a new combination of future types doesn't instantiate yet another coroutine.
+   *
    * @param promises list of promise-pointers representing futures to wait on
    *                 nullptr represents a future that's done().
+   *                 Only has to stay valid until this returns: it's copied before suspending.
    * @note it would be lovely if we could use the futures' coroutine_handle,
    *       and their .done() member, directly, but unfortunately conversion between coroutine_handle
    *       and promises is dependent on the alignment of the promise type (https://gcc.gnu.org/bugzilla/show_bug.cgi?id=118014).
@@ -93,11 +166,18 @@ struct wait_t
    */
   future<std::size_t>
     static operator()(
-      decltype(detail::promise_wait_callgraph::callees)&        promises
-    , until                                                     wait_until
+      until                                                     wait_until
+    , std::span<detail::promise_wait_callgraph* const>          promises
     , std::optional<clock::time_point>                          timeout
     ) noexcept;
 
+  template <typename T>
+  static constexpr detail::promise_wait_callgraph* _promise_of(future<T>& future) noexcept
+  {
+    return future && !future.done() ? &future.handle.promise() : nullptr;
+  }
+
+  // Not a coroutine: only collects the promises on the stack
   template <typename... Ts>
   requires(detail::timeout<std::decay_t<detail::last_type_of<Ts...>>>
        && detail::all_are_future<detail::everything_except_last<std::remove_reference_t<Ts>...>>
@@ -108,39 +188,22 @@ struct wait_t
     , Ts&&...                          futures_with_timeout_at_end
     ) noexcept
   {
-    auto my_timeout = detail::to_timeout_point(detail::forward_last(futures_with_timeout_at_end...));
-    auto& my_promise = co_await detail::current_promise();
-    decltype(my_promise.callees) promises;
-    struct scope_exit
-    {
-      decltype(my_promise.alloc)& alloc_;
-      decltype(promises)& promises_;
-      ~scope_exit()
+    return [wait_until]<typename... NTs, std::size_t... NIs>(
+          std::index_sequence<NIs...>
+        , std::optional<clock::time_point> timeout
+        , std::tuple<NTs&...> futures) noexcept
       {
-        promises_.destroy(alloc_);
-      }
-    } scope_exit(my_promise.alloc, promises);
-    {
-      if (auto r = promises.reserve(sizeof...(futures_with_timeout_at_end) - (my_timeout ? 0 : 1), my_promise.alloc);
-            !r)
-        co_return {unexpect, r.error()};
-      [&promises, &my_promise]<typename... NTs, std::size_t... NIs>(
-            std::index_sequence<NIs...>
-          , std::tuple<NTs&...> futures) noexcept
-        {
-          // push every parameter from the tuple for which we have an index
-          (((void)promises.push_back(
-               static_cast<olifilo::detail::promise_wait_callgraph*>(
-                 std::get<NIs>(futures) && !std::get<NIs>(futures).done() ? &std::get<NIs>(futures).handle.promise() : nullptr
-               ), my_promise.alloc)), ...);
-        }(
-          // ensure the last parameter in the pack doesn't have an index for it
-          std::make_index_sequence<sizeof...(Ts) - 1>()
-        , std::forward_as_tuple(futures_with_timeout_at_end...)
-        );
-    }
-
-    co_return co_await wait_t::operator()(promises, wait_until, my_timeout);
+        const std::array<detail::promise_wait_callgraph*, sizeof...(NIs)> promises{
+          // every parameter from the tuple for which we have an index
+          wait_t::_promise_of(std::get<NIs>(futures))...
+        };
+        return wait_t::operator()(wait_until, std::span(promises), timeout);
+      }(
+        // ensure the last parameter in the pack doesn't have an index for it
+        std::make_index_sequence<sizeof...(Ts) - 1>()
+      , detail::to_timeout_point(detail::forward_last(futures_with_timeout_at_end...))
+      , std::forward_as_tuple(futures_with_timeout_at_end...)
+      );
   }
 
   template <typename... Ts>
@@ -164,9 +227,8 @@ struct wait_t
     , Timeout                          timeout = {}
     ) noexcept
   {
-    auto my_timeout = detail::to_timeout_point(timeout);
     auto& my_promise = co_await detail::current_promise();
-    decltype(my_promise.callees) promises;
+    detail::sbo_vector<detail::promise_wait_callgraph*> promises;
     struct scope_exit
     {
       decltype(my_promise.alloc)& alloc_;
@@ -176,17 +238,14 @@ struct wait_t
         promises_.destroy(alloc_);
       }
     } scope_exit(my_promise.alloc, promises);
-    if (auto r = promises.reserve(std::ranges::distance(first, last) + !!my_timeout, my_promise.alloc);
+    if (auto r = promises.reserve(static_cast<std::size_t>(std::ranges::distance(first, last)), my_promise.alloc);
           !r)
       co_return {unexpect, r.error()};
 
     for (auto i = first; i != last; ++i)
-      (void)promises.push_back(
-          static_cast<olifilo::detail::promise_wait_callgraph*>(
-            *i && !i->done() ? &i->handle.promise() : nullptr
-          ), my_promise.alloc);
+      (void)promises.push_back(wait_t::_promise_of(*i), my_promise.alloc);
 
-    if (auto r = co_await wait_t::operator()(promises, wait_until, my_timeout);
+    if (auto r = co_await wait_t::operator()(wait_until, std::span(promises.begin(), promises.end()), detail::to_timeout_point(timeout));
         !r)
       co_return {unexpect, r.error()};
     else
@@ -215,5 +274,14 @@ struct wait_t
   }
 };
 
+template <typename... Ts>
+expected<void> detail::wait_core::start(until wait_until, std::optional<wait_clock::time_point> timeout, future<Ts>&... futures) noexcept
+{
+  const std::array<promise_wait_callgraph*, sizeof...(Ts)> promises{
+    wait_t::_promise_of(futures)...
+  };
+  return start(wait_until, std::span(promises), timeout);
+}
+
 inline constexpr wait_t wait [[maybe_unused]];
 }  // namespace olifilo
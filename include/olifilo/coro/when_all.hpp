@@ -2,9 +2,11 @@
 
 #pragma once
 
+#include <coroutine>
 #include <cstddef>
 #include <iterator>
 #include <new>
+#include <optional>
 #include <ranges>
 #include <tuple>
 #include <type_traits>
@@ -21,19 +23,34 @@ namespace olifilo
 {
 struct when_all_t
 {
-  template <detail::timeout Timeout, typename... Ts, std::size_t... Is>
+  /**
+   * The only part that's instantiated per combination of future types: owning the futures and
+   * assembling the result. Waiting and its failure are detail::wait_core's, which runs in this same
+   * coroutine instead of another one awaited by it.
+   */
+  template <typename... Ts, std::size_t... Is>
   requires(sizeof...(Ts) == sizeof...(Is))
   future<std::tuple<expected<Ts>...>>
-    static constexpr _apply_with_indices(std::index_sequence<Is...>, Timeout const timeout, future<Ts>&&... futures) noexcept
+    static constexpr _apply_with_indices(std::index_sequence<Is...>, std::optional<wait_t::clock::time_point> const timeout, future<Ts>&&... futures) noexcept
   {
+    auto& my_promise = co_await detail::current_promise();
+
     // Take ownership of the futures *before* we first suspend to ensure they stay alive for the entire duration of this coroutine
     // Not taking them by value to ensure that allocation failure for the coroutine frame doesn't destroy them...
     std::tuple my_futures(std::move(futures)...);
-    if (const auto r = co_await wait(until::all_completed, std::get<Is>(my_futures)..., timeout);
-        !r)
+
+    detail::wait_core waiter(my_promise, std::coroutine_handle<std::remove_cvref_t<decltype(my_promise)>>::from_promise(my_promise));
+    if (auto r = waiter.start(until::all_completed, timeout, std::get<Is>(my_futures)...); !r)
       co_return {unexpect, r.error()};
 
-    co_return {std::in_place, (co_await std::get<Is>(my_futures))...};
+    std::optional<expected<std::size_t>> r;
+    while (!(r = waiter.poll()))
+      co_await std::suspend_always();
+    if (!*r)
+      co_return {unexpect, r->error()};
+
+    // All completed: taking their results doesn't need to suspend
+    co_return {std::in_place, std::get<Is>(my_futures).await_resume()...};
   }
 
   template <typename... Ts>
@@ -49,7 +66,7 @@ struct when_all_t
       {
         return when_all_t::_apply_with_indices(
             is
-          , timeout
+          , detail::to_timeout_point(timeout)
           // forward every parameter from the tuple for which we have an index
           , std::get<NIs>(std::move(futures))...
           );
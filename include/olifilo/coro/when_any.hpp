@@ -2,8 +2,10 @@
 
 #pragma once
 
+#include <coroutine>
 #include <cstddef>
 #include <iterator>
+#include <optional>
 #include <ranges>
 #include <tuple>
 #include <type_traits>
@@ -32,10 +34,11 @@ struct when_any_result
 
 struct when_any_t
 {
-  template <detail::timeout Timeout, typename... Ts, std::size_t... Is>
+  // Only owns the futures and reports the index per combination of future types: waiting is detail::wait_core's
+  template <typename... Ts, std::size_t... Is>
   requires(sizeof...(Ts) == sizeof...(Is))
   future<when_any_result<std::tuple<future<Ts>...>>>
-    static constexpr _apply_with_indices(std::index_sequence<Is...>, Timeout timeout, future<Ts>&&... futures) noexcept
+    static constexpr _apply_with_indices(std::index_sequence<Is...>, std::optional<wait_t::clock::time_point> const timeout, future<Ts>&&... futures) noexcept
   {
     auto& my_promise = co_await detail::current_promise();
 
@@ -44,11 +47,16 @@ struct when_any_t
     // Not taking them by value to ensure that allocation failure for the coroutine frame doesn't destroy them...
     rv.emplace(std::move(futures)...);
 
-    if (const auto r = co_await wait(until::first_completed, std::get<Is>(rv->futures)..., timeout);
-        !r)
+    detail::wait_core waiter(my_promise, std::coroutine_handle<std::remove_cvref_t<decltype(my_promise)>>::from_promise(my_promise));
+    if (auto r = waiter.start(until::first_completed, timeout, std::get<Is>(rv->futures)...); !r)
       co_return {unexpect, r.error()};
-    else
-      rv->index = *r == sizeof...(futures) ? static_cast<std::size_t>(-1) : *r;
+
+    std::optional<expected<std::size_t>> r;
+    while (!(r = waiter.poll()))
+      co_await std::suspend_always();
+    if (!*r)
+      co_return {unexpect, r->error()};
+    rv->index = **r == sizeof...(futures) ? static_cast<std::size_t>(-1) : **r;
 
     co_return rv;
   }
@@ -66,7 +74,7 @@ struct when_any_t
       {
         return when_any_t::_apply_with_indices(
             is
-          , timeout
+          , detail::to_timeout_point(timeout)
           // forward every parameter from the tuple for which we have an index
           , std::get<NIs>(std::move(futures))...
           );
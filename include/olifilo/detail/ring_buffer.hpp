@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <system_error>
+#include <type_traits>
+
+#include <olifilo/expected.hpp>
+
+namespace olifilo::detail
+{
+// What to do when pushing into a full record_ring
+enum class overflow_policy : std::uint8_t
+{
+  // keep what's queued, discard the record being pushed
+  drop_newest,
+  // discard the oldest queued record to make room
+  drop_oldest,
+};
+
+/**
+ * Bounded single-producer/single-consumer queue of fixed size records. Storage gets allocated by
+ * reset() only: neither push() nor pop() allocate, block or take a lock.
+ *
+ * With drop_oldest the producer may take away the record a concurrent pop() is copying. pop()
+ * detects that the way a seqlock reader does: it only claims the record after copying it, and when
+ * that fails discards its (possibly torn) copy and retries with the new oldest record.
+ */
+class record_ring
+{
+  public:
+    record_ring() = default;
+    record_ring(const record_ring&) = delete;
+    record_ring& operator=(const record_ring&) = delete;
+
+    /**
+     * (Re)allocates storage and empties the queue.
+     *
+     * Not thread safe: neither producer nor consumer may be using this ring concurrently.
+     */
+    expected<void> reset(std::size_t record_size, std::size_t capacity, overflow_policy policy) noexcept
+    {
+      if (capacity == 0
+       || record_size > std::size_t(-1) / capacity)
+        return {unexpect, make_error_code(std::errc::invalid_argument)};
+
+      if (!_storage || record_size * capacity != _record_size * _capacity)
+      {
+        _storage.reset(new (std::nothrow) std::byte[record_size * capacity]);
+        if (!_storage)
+        {
+          _record_size = _capacity = 0;
+          return {unexpect, make_error_code(std::errc::not_enough_memory)};
+        }
+      }
+
+      _record_size = record_size;
+      _capacity = capacity;
+      _policy = policy;
+      _read.store(0, std::memory_order_relaxed);
+      _write.store(0, std::memory_order_relaxed);
+      _dropped.store(0, std::memory_order_relaxed);
+      return {};
+    }
+
+    constexpr std::size_t record_size() const noexcept
+    {
+      return _record_size;
+    }
+
+    constexpr std::size_t capacity() const noexcept
+    {
+      return _capacity;
+    }
+
+    bool empty() const noexcept
+    {
+      return _read.load(std::memory_order_acquire) == _write.load(std::memory_order_acquire);
+    }
+
+    // Records that got discarded because the ring was full
+    std::size_t dropped() const noexcept
+    {
+      return _dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Producer side: lets 'fill' write the new record into the ring's storage.
+     *
+     * @returns false when the record got dropped instead
+     */
+    template <typename F>
+    requires(std::is_nothrow_invocable_v<F&, std::span<std::byte>>)
+    bool push(F&& fill) noexcept
+    {
+      if (!_capacity)
+        return false;
+
+      const auto write = _write.load(std::memory_order_relaxed);
+      if (auto read = _read.load(std::memory_order_acquire);
+          write - read == _capacity)
+      {
+        if (_policy == overflow_policy::drop_newest)
+        {
+          _dropped.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+
+        // Failing means the consumer just took 'read' itself: that made room just the same
+        if (_read.compare_exchange_strong(read, read + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+          _dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      fill(record(write));
+      _write.store(write + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Consumer side: copies the oldest record into 'out' and removes it from the ring.
+     *
+     * @returns false when empty
+     */
+    bool pop(std::span<std::byte> out) noexcept
+    {
+      assert(out.size() >= _record_size);
+
+      auto read = _read.load(std::memory_order_acquire);
+      while (read != _write.load(std::memory_order_acquire))
+      {
+        std::memcpy(out.data(), record(read).data(), _record_size);
+        if (_read.compare_exchange_weak(read, read + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+          return true;
+        // Dropped by the producer while copying (or a spurious failure): 'read' is the oldest again
+      }
+      return false;
+    }
+
+    // Consumer side: drops every queued record
+    void clear() noexcept
+    {
+      _read.store(_write.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+  private:
+    std::span<std::byte> record(std::size_t index) const noexcept
+    {
+      return {&_storage[index % _capacity * _record_size], _record_size};
+    }
+
+    std::unique_ptr<std::byte[]> _storage;
+    std::size_t                  _record_size = 0;
+    std::size_t                  _capacity    = 0;
+    overflow_policy              _policy      = overflow_policy::drop_newest;
+    // monotonic counters: the amount of records ever taken out of and put into the ring
+    std::atomic<std::size_t>     _read        = 0;
+    std::atomic<std::size_t>     _write       = 0;
+    std::atomic<std::size_t>     _dropped     = 0;
+};
+}  // namespace olifilo::detail
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+#include <sys/select.h>
+
+namespace olifilo::detail
+{
+// A select() call waiting for an fd, which it should be woken up for with 'waker'
+template <typename Waker>
+struct select_waiter
+{
+  ::fd_set* readers = nullptr;
+  ::fd_set* errors  = nullptr;
+  Waker     waker   = {};
+};
+
+// Bit 'fd * max_selects_per_fd + slot' is set for every waiter slot armed by a select() call
+using armed_select_slots = std::uintptr_t;
+
+/**
+ * The start_select/end_select pair of a VFS driver for queue backed fds that are readable only, like
+ * ESP-IDF's, which wakes select() with a trigger function. Every context of the fds 0..FdCount needs:
+ *  - 'lock': a mutex that protects waking (vs. disarming) 'waiters'
+ *  - 'queue': with an 'empty()' check that's safe to call concurrently with its producer
+ *  - 'waiters': a waiter_slots of select_waiter
+ *  - 'opened': an atomic<bool>, reading fails when false
+ *
+ * Neither allocates nor locks to start: end_select reports readiness from the armed slots.
+ */
+template <typename Context, std::size_t FdCount>
+struct select_driver
+{
+  using waiter_t = std::remove_cvref_t<decltype(std::declval<const Context&>().waiters[0])>;
+
+  static constexpr std::size_t max_selects_per_fd = decltype(Context::waiters)::capacity;
+  static_assert(FdCount * max_selects_per_fd <= std::numeric_limits<armed_select_slots>::digits);
+  static_assert(sizeof(armed_select_slots) <= sizeof(void*), "passed along as the driver's void* data");
+
+  static void end_select(std::array<Context, FdCount>& contexts, armed_select_slots armed) noexcept
+  {
+    for (std::size_t bit = 0; bit < std::numeric_limits<armed_select_slots>::digits; ++bit)
+    {
+      if (!(armed & (armed_select_slots(1) << bit)))
+        continue;
+
+      const auto fd = static_cast<int>(bit / max_selects_per_fd);
+      const auto slot = bit % max_selects_per_fd;
+      auto&& context = contexts[static_cast<std::size_t>(fd)];
+      std::scoped_lock _(context.lock);
+
+      const auto& waiter = context.waiters[slot];
+      if (context.opened)
+      {
+        if (waiter.readers && !context.queue.empty())
+          FD_SET(fd, waiter.readers);
+      }
+      else
+      {
+        // closed: reading will fail
+        if (waiter.readers)
+          FD_SET(fd, waiter.readers);
+        if (waiter.errors)
+          FD_SET(fd, waiter.errors);
+      }
+      context.waiters.disarm(slot);
+    }
+  }
+
+  /**
+   * Arms a waiter slot for every fd in 'readfds' and 'exceptfds' (either may be null) and clears it
+   * from them: end_select sets it again when ready. Calls 'trigger(waker)' when already ready.
+   *
+   * @returns false when an fd had no free waiter slot left, nothing is armed then
+   */
+  template <typename Waker, typename Trigger>
+  static bool start_select(
+      std::array<Context, FdCount>& contexts
+    , int                           nfds
+    , ::fd_set*                     readfds
+    , ::fd_set*                     writefds
+    , ::fd_set*                     exceptfds
+    , const Waker&                  waker
+    , Trigger&&                     trigger
+    , armed_select_slots&           armed
+    ) noexcept
+  {
+    nfds = std::min(nfds, static_cast<int>(FdCount));
+
+    bool should_awake = false;
+    armed = 0;
+    for (int fd = 0; fd < nfds; ++fd)
+    {
+      // these fds are never writable
+      // thus everything in writefds is always 'ready' (to fail with ENOSYS)
+      if (writefds && FD_ISSET(fd, writefds))
+        should_awake = true;
+
+      const bool read = readfds && FD_ISSET(fd, readfds);
+      const bool except = exceptfds && FD_ISSET(fd, exceptfds);
+      if (!read && !except)
+        continue;
+
+      auto&& context = contexts[static_cast<std::size_t>(fd)];
+      const auto slot = context.waiters.arm(waiter_t{
+          .readers = read   ? readfds   : nullptr,
+          .errors  = except ? exceptfds : nullptr,
+          .waker   = waker,
+        });
+      if (slot == context.waiters.capacity)
+      {
+        end_select(contexts, armed);
+        armed = 0;
+        return false;
+      }
+      armed |= armed_select_slots(1) << (static_cast<std::size_t>(fd) * max_selects_per_fd + slot);
+      if (read)
+        FD_CLR(fd, readfds);
+      if (except)
+        FD_CLR(fd, exceptfds);
+
+      // Only after arming: posting checks for armed waiters after queueing
+      if (!context.queue.empty() || !context.opened)
+        should_awake = true;
+    }
+
+    if (should_awake)
+      trigger(waker);
+    return true;
+  }
+
+  // Wakes the select() calls waiting for 'context' after queueing into it: lock-free unless one is waiting
+  template <typename Trigger>
+  static void notify(Context& context, Trigger&& trigger) noexcept
+  {
+    if (!context.waiters.notify_needed())
+      return;
+
+    // only keeps a select() from finishing while we wake it
+    std::scoped_lock _(context.lock);
+    context.waiters.for_each_armed([&trigger] (const waiter_t& waiter) noexcept {
+        trigger(waiter.waker);
+      });
+  }
+};
+}  // namespace olifilo::detail
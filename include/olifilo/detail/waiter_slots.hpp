@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace olifilo::detail
+{
+/**
+ * Preallocated slots for the waiters (e.g. select() calls) of a single file descriptor. Arming and
+ * disarming a slot never allocates nor locks: slots get claimed with a compare-and-swap.
+ *
+ * Arming pairs with notify_needed() like Dekker's algorithm does: waiters arm before checking for
+ * readiness, notifiers become ready before checking for armed waiters. A sequentially consistent
+ * fence on both sides ensures at least one of them notices the other, so no wake-up gets lost.
+ *
+ * Waking an armed waiter while it gets disarmed is up to the user to prevent: for_each_armed() and
+ * disarm() need to be mutually excluded when a disarmed waiter may not be touched anymore.
+ */
+template <typename Waiter, std::size_t N>
+class waiter_slots
+{
+  public:
+    static constexpr std::size_t capacity = N;
+
+    /**
+     * @returns the index of the slot 'waiter' got stored in, or 'capacity' when all are in use
+     */
+    std::size_t arm(const Waiter& waiter) noexcept
+    {
+      for (std::size_t i = 0; i < N; ++i)
+      {
+        auto expected = state::free;
+        if (!_states[i].compare_exchange_strong(expected, state::claimed, std::memory_order_acquire, std::memory_order_relaxed))
+          continue;
+
+        _waiters[i] = waiter;
+        _states[i].store(state::armed, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return i;
+      }
+      return N;
+    }
+
+    void disarm(std::size_t i) noexcept
+    {
+      assert(i < N && _states[i].load(std::memory_order_relaxed) == state::armed);
+      _states[i].store(state::free, std::memory_order_release);
+    }
+
+    const Waiter& operator[](std::size_t i) const noexcept
+    {
+      return _waiters[i];
+    }
+
+    // Lock-free check for notifiers: whether there's anyone to wake up at all
+    bool notify_needed() const noexcept
+    {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      for (const auto& s : _states)
+        if (s.load(std::memory_order_relaxed) == state::armed)
+          return true;
+      return false;
+    }
+
+    bool any_claimed() const noexcept
+    {
+      for (const auto& s : _states)
+        if (s.load(std::memory_order_acquire) != state::free)
+          return true;
+      return false;
+    }
+
+    template <typename F>
+    void for_each_armed(F&& f) const noexcept(noexcept(f(std::declval<const Waiter&>())))
+    {
+      for (std::size_t i = 0; i < N; ++i)
+        if (_states[i].load(std::memory_order_acquire) == state::armed)
+          f(_waiters[i]);
+    }
+
+  private:
+    enum class state : std::uint8_t
+    {
+      free,
+      // being armed: its waiter isn't complete yet
+      claimed,
+      armed,
+    };
+
+    std::array<std::atomic<state>, N> _states{};
+    std::array<Waiter, N>             _waiters{};
+};
+}  // namespace olifilo::detail
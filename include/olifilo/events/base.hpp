@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace olifilo::events::detail
+{
+// Identifies a family of events by address, not by content: the same type as ESP-IDF's esp_event_base_t
+using event_base_t = const char*;
+
+template <typename T>
+concept EventIdEnumBase =
+    std::is_enum<T>::value
+ && std::integral<std::underlying_type_t<T>>
+ && sizeof(std::underlying_type_t<T>) <= sizeof(std::int32_t);
+
+/**
+ * To be specialized for every event id enum, providing:
+ *  - base:     the event_base_t its events are posted with
+ *  - sort_key: unique among all event id enums, orders them in parameter packs (and so the ABI)
+ *  - min, max: the range of ids that may be posted
+ */
+template <EventIdEnumBase Base>
+struct event_id;
+
+template <typename T>
+concept EventIdEnum =
+    EventIdEnumBase<T>
+ && std::is_same_v<std::decay_t<decltype(event_id<T>::base)>, event_base_t>
+ && std::is_same_v<std::decay_t<decltype(event_id<T>::sort_key)>, std::size_t>
+ && std::is_same_v<std::remove_cvref_t<decltype(event_id<T>::max)>, std::underlying_type_t<T>>
+ && (event_id<T>::min >= std::numeric_limits<std::int32_t>::min() || event_id<T>::min >= 0)
+ &&  event_id<T>::max <= std::numeric_limits<std::int32_t>::max();
+
+// To be specialized for events with a payload
+template <EventIdEnum auto EventId>
+struct event
+{
+  // Defaulting to 'void' because there are plenty of events without payload
+  using type = void;
+};
+
+template <EventIdEnum auto EventId>
+using event_t = typename event<EventId>::type;
+}  // namespace olifilo::events::detail
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <olifilo/expected.hpp>
+
+#include "base.hpp"
+#include "detail.hpp"
+
+namespace olifilo::events
+{
+/**
+ * What a subscription to EventIds receives, decoded from the raw (base, id, payload) an event got
+ * posted with: see README.md for the shape of result_t. Shared by every event subscriber
+ * implementation (ESP-IDF's event loop, Linux' io::event_bus).
+ */
+template <detail::EventIdEnum auto... EventIds>
+struct decoder
+{
+  using var_event_id_t = detail::unique_t<std::variant<decltype(EventIds)...>>;
+  using var_event_t = std::conditional_t<
+      detail::contains_void<detail::event_t<EventIds>...>
+    , detail::unique_t<std::variant<
+        // ensure std::monostate is the *first* alternative in our variant
+        std::monostate
+      , std::conditional_t<
+          std::is_void_v<detail::event_t<EventIds>>
+        , std::monostate
+        , detail::event_t<EventIds>
+        >...
+      >>
+    , detail::unique_t<std::variant<detail::event_t<EventIds>...>>
+    >;
+  static_assert(std::tuple_size_v<detail::unique_t<std::tuple<std::integral_constant<std::size_t, detail::event_id<decltype(EventIds)>::sort_key>...>>>
+      == std::variant_size_v<var_event_id_t>, "non-unique sort-key found for used event id enums!");
+
+  using event_id_t = std::conditional_t<
+      std::variant_size_v<var_event_id_t> == 1
+    , std::variant_alternative_t<0, var_event_id_t>
+    , var_event_id_t
+    >;
+  using event_t = std::conditional_t<
+      std::variant_size_v<var_event_t> == 1
+    , std::conditional_t<
+        detail::contains_void<detail::event_t<EventIds>...>
+        && std::is_same_v<std::variant_alternative_t<0, var_event_t>, std::monostate>
+      , void
+      , std::variant_alternative_t<0, var_event_t>
+      >
+    , var_event_t
+    >;
+
+  static constexpr auto max_event_size = std::max({
+      detail::size_of<detail::event_t<EventIds>>...
+    });
+
+  using result_t = std::conditional_t<
+        sizeof...(EventIds) == 1
+      , event_t
+      , std::conditional_t<
+          std::is_void_v<event_t>
+        , event_id_t
+        , std::pair<event_id_t, event_t>
+        >
+      >;
+
+  // @returns errc::bad_message for events not subscribed to, errc::no_buffer_space for truncated payloads
+  static constexpr expected<result_t> decode(detail::event_base_t base, std::int32_t id, std::span<const std::byte> event_data) noexcept
+  {
+    return detail::decode_event<result_t, event_t, var_event_id_t, 0, EventIds...>(base, id, event_data);
+  }
+};
+}  // namespace olifilo::events
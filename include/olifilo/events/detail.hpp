@@ -3,12 +3,22 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <ranges>
+#include <span>
+#include <system_error>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <variant>
 
-namespace olifilo::esp::detail
+#include <olifilo/expected.hpp>
+
+#include "base.hpp"
+
+namespace olifilo::events::detail
 {
 template <template <typename...> class Pack, typename MaybePack, typename UniquePack = Pack<>>
 struct unique_pack;
@@ -242,7 +252,7 @@ constexpr expected<R> decode_event_for_base(std::int32_t id, std::span<const std
 }
 
 template <typename R, typename Event, typename var_event_id_t, std::size_t Base, detail::EventIdEnum auto... EventIds>
-constexpr expected<R> decode_event(::esp_event_base_t base, std::int32_t id, std::span<const std::byte> event_data) noexcept
+constexpr expected<R> decode_event(event_base_t base, std::int32_t id, std::span<const std::byte> event_data) noexcept
 {
   constexpr auto Max = std::variant_size_v<var_event_id_t>;
 
@@ -301,4 +311,4 @@ constexpr expected<R> decode_event(::esp_event_base_t base, std::int32_t id, std
 
   return {unexpect, make_error_code(std::errc::bad_message)};
 }
-}  // namespace olifilo::esp::detail
+}  // namespace olifilo::events::detail
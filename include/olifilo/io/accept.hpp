@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cerrno>
+#include <system_error>
+
+#include <sys/socket.h>
+
+#include "../expected.hpp"
+#include "types.hpp"
+
+namespace olifilo::io
+{
+/**
+ * @param flags SOCK_NONBLOCK/SOCK_CLOEXEC for the accepted socket, only supported where accept4() exists
+ */
+inline expected<file_descriptor_handle> accept(file_descriptor_handle fd, [[maybe_unused]] int flags = 0) noexcept
+{
+#if __linux__ || __FreeBSD__ || __NetBSD__ || __OpenBSD__
+  file_descriptor_handle rv(::accept4(fd, nullptr, nullptr, flags));
+#else
+  if (flags)
+    return make_error_code(std::errc::invalid_argument);
+  file_descriptor_handle rv(::accept(fd, nullptr, nullptr));
+#endif
+  if (!rv)
+    return std::error_code(errno, std::system_category());
+  return rv;
+}
+}  // namespace olifilo::io
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace olifilo::io
+{
+class virtual_time;
+
+namespace detail
+{
+constinit inline thread_local virtual_time* this_thread_virtual_time = nullptr;
+}  // namespace detail
+
+/**
+ * Clock of every timeout handled by the executor: steady_clock, unless the current thread has a
+ * virtual_time in scope. Uses steady_clock's time_point so deadlines stay interchangeable.
+ */
+struct executor_clock
+{
+  using duration = std::chrono::steady_clock::duration;
+  using rep = duration::rep;
+  using period = duration::period;
+  using time_point = std::chrono::steady_clock::time_point;
+
+  static constexpr bool is_steady = true;
+
+  static time_point now() noexcept;
+};
+
+/**
+ * Simulated time for the executors (i.e. future::get()) on the current thread while in scope.
+ *
+ * Instead of blocking until the earliest timeout when no file descriptor is ready, the executor
+ * makes time jump straight to that timeout. So minutes of keep-alive, timeout or back-off logic
+ * complete in however much real time the work in between takes. File descriptors are still polled
+ * for real: in-memory transports (pipes, socketpairs, eventfds) work as usual. Because time only
+ * jumps when nothing is ready *right now*, work being done by another thread, or by the kernel,
+ * won't get waited for when there's a pending timeout.
+ *
+ * Kernel timers (io::timer) keep running on real time.
+ */
+class virtual_time
+{
+  public:
+    explicit virtual_time(executor_clock::time_point start = std::chrono::steady_clock::now()) noexcept
+      : _now(start)
+      , _previous(detail::this_thread_virtual_time)
+    {
+      detail::this_thread_virtual_time = this;
+    }
+
+    ~virtual_time()
+    {
+      detail::this_thread_virtual_time = _previous;
+    }
+
+    virtual_time(const virtual_time&) = delete;
+    virtual_time& operator=(const virtual_time&) = delete;
+
+    // The innermost virtual_time in scope on this thread, if any
+    static virtual_time* current() noexcept
+    {
+      return detail::this_thread_virtual_time;
+    }
+
+    executor_clock::time_point now() const noexcept
+    {
+      return _now;
+    }
+
+    // Moves time forward, never backward
+    void advance_to(executor_clock::time_point time) noexcept
+    {
+      if (time > _now)
+      {
+        _now = time;
+        ++_jumps;
+      }
+    }
+
+    void advance(executor_clock::duration time) noexcept
+    {
+      advance_to(_now + time);
+    }
+
+    // amount of times time moved forward
+    std::uint64_t jumps() const noexcept
+    {
+      return _jumps;
+    }
+
+  private:
+    executor_clock::time_point _now;
+    std::uint64_t              _jumps = 0;
+    virtual_time*              _previous;
+};
+
+inline executor_clock::time_point executor_clock::now() noexcept
+{
+  if (const auto* const sim = virtual_time::current())
+    return sim->now();
+  return std::chrono::steady_clock::now();
+}
+}  // namespace olifilo::io
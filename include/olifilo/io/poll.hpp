@@ -5,13 +5,14 @@
 #include <chrono>
 #include <optional>
 
+#include "clock.hpp"
 #include "types.hpp"
 
 namespace olifilo::io
 {
 struct poll
 {
-  using timeout_clock = std::chrono::steady_clock;
+  using timeout_clock = executor_clock;
 
   using enum poll_event;
 
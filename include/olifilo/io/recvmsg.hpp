@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <system_error>
+
+#include <sys/socket.h>
+
+#include "../expected.hpp"
+#include "types.hpp"
+
+namespace olifilo::io
+{
+struct recvmsg_result
+{
+  std::size_t          size;
+  // the part of the provided control buffer that got filled with control messages
+  std::span<std::byte> control;
+  int                  flags;    // MSG_TRUNC, MSG_CTRUNC, ...
+};
+
+inline expected<recvmsg_result> recvmsg(file_descriptor_handle fd, std::span<const std::span<std::byte>> bufs, std::span<std::byte> control, int flags) noexcept
+{
+  // While this is size_t on POSIX, it's a custom type on lwIP
+  using iovlen_t = decltype(::msghdr::msg_iovlen);
+  using controllen_t = decltype(::msghdr::msg_controllen);
+
+  if (bufs.size() > static_cast<std::size_t>(std::numeric_limits<iovlen_t>::max())
+   || control.size() > static_cast<std::size_t>(std::numeric_limits<controllen_t>::max()))
+    return {olifilo::unexpect, make_error_code(std::errc::message_size)};
+
+  // FIXME: this relies on 'struct iovec' and 'std::span<T>' having the same layout, just like sendmsg()
+  ::msghdr msg = {
+    .msg_iov = const_cast<::iovec*>(reinterpret_cast<const ::iovec*>(bufs.data())),
+    .msg_iovlen = static_cast<iovlen_t>(bufs.size()),
+    .msg_control = control.empty() ? nullptr : control.data(),
+    .msg_controllen = static_cast<controllen_t>(control.size()),
+  };
+
+  if (auto rv = ::recvmsg(fd, &msg, flags);
+      rv == -1)
+    return std::error_code(errno, std::system_category());
+  else
+    return recvmsg_result{
+      .size = static_cast<std::size_t>(rv),
+      .control = control.first(static_cast<std::size_t>(msg.msg_controllen)),
+      .flags = msg.msg_flags,
+    };
+}
+}  // namespace olifilo::io
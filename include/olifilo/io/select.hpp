@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
 #include <limits>
@@ -60,7 +61,8 @@ expected<unsigned> select(
   ) noexcept
 {
   const auto now = Clock::now();
-  const auto time_left = std::chrono::duration_cast<std::chrono::microseconds>(timeout - now);
+  // Round up: waking up early would just cause another round trip through select()
+  const auto time_left = std::max(std::chrono::ceil<std::chrono::microseconds>(timeout - now), std::chrono::microseconds::zero());
   return select(nfds, readfds, writefds, exceptfds, time_left);
 }
 
@@ -91,4 +93,59 @@ expected<unsigned> select(
   else
     return select(nfds, readfds, writefds, exceptfds);
 }
+
+#if _POSIX_C_SOURCE >= 200112L
+inline expected<unsigned> pselect(
+    unsigned nfds
+  , ::fd_set* readfds
+  , ::fd_set* writefds
+  , ::fd_set* exceptfds
+  , const struct ::timespec* timeout = nullptr
+  , const ::sigset_t* sigmask = nullptr
+  ) noexcept
+{
+  if (nfds > static_cast<unsigned>(std::numeric_limits<int>::max()))
+    return std::make_error_code(std::errc::invalid_argument);
+
+  if (nfds > FD_SETSIZE)
+    return std::make_error_code(std::errc::bad_file_descriptor);
+
+  if (auto rv = ::pselect(static_cast<int>(nfds), readfds, writefds, exceptfds, timeout, sigmask); rv < 0)
+    return std::error_code(errno, std::system_category());
+  else
+    return rv;
+}
+
+inline expected<unsigned> pselect(
+    unsigned nfds
+  , ::fd_set* readfds
+  , ::fd_set* writefds
+  , ::fd_set* exceptfds
+  , std::chrono::nanoseconds timeout
+  ) noexcept
+{
+  const struct ::timespec ts{
+    .tv_sec = static_cast<decltype(ts.tv_sec)>(timeout.count() / 1000000000L),
+    .tv_nsec = static_cast<decltype(ts.tv_nsec)>(timeout.count() % 1000000000L),
+  };
+  return pselect(nfds, readfds, writefds, exceptfds, &ts);
+}
+
+// Same as select() but without truncating 'timeout' to microseconds
+template <typename Clock, typename Duration = typename Clock::duration>
+expected<unsigned> pselect(
+    unsigned nfds
+  , ::fd_set* readfds
+  , ::fd_set* writefds
+  , ::fd_set* exceptfds
+  , std::optional<std::chrono::time_point<Clock, Duration>> timeout
+  ) noexcept
+{
+  if (!timeout)
+    return pselect(nfds, readfds, writefds, exceptfds);
+
+  const auto time_left = std::max(std::chrono::ceil<std::chrono::nanoseconds>(*timeout - Clock::now()), std::chrono::nanoseconds::zero());
+  return pselect(nfds, readfds, writefds, exceptfds, time_left);
+}
+#endif
 }  // namespace olifilo::io
@@ -3,8 +3,12 @@
 #pragma once
 
 #include <system_error>
+#include <utility>
 
 #include <sys/socket.h>
+#ifdef SO_TIMESTAMPING
+#include <linux/net_tstamp.h>
+#endif
 
 #include "base.hpp"
 
@@ -21,8 +25,42 @@ enum class sol_socket : int
   receive_buffer_size = SO_RCVBUF,
   send_buffer_size = SO_SNDBUF,
   linger = SO_LINGER,
+#ifdef SO_TIMESTAMPING
+  timestamping = SO_TIMESTAMPING,
+#endif
 };
 
+#ifdef SO_TIMESTAMPING
+// What the kernel timestamps and reports (SOF_TIMESTAMPING_*)
+enum class timestamping : unsigned
+{
+  none            = 0,
+  // generation
+  tx_hardware     = SOF_TIMESTAMPING_TX_HARDWARE,
+  tx_software     = SOF_TIMESTAMPING_TX_SOFTWARE,
+  tx_scheduled    = SOF_TIMESTAMPING_TX_SCHED,
+  tx_acknowledged = SOF_TIMESTAMPING_TX_ACK,
+  rx_hardware     = SOF_TIMESTAMPING_RX_HARDWARE,
+  rx_software     = SOF_TIMESTAMPING_RX_SOFTWARE,
+  // reporting
+  software        = SOF_TIMESTAMPING_SOFTWARE,
+  raw_hardware    = SOF_TIMESTAMPING_RAW_HARDWARE,
+  // options
+  id              = SOF_TIMESTAMPING_OPT_ID,          // number TX timestamps by byte (stream) or datagram
+  timestamp_only  = SOF_TIMESTAMPING_OPT_TSONLY,      // don't loop sent data back with TX timestamps
+};
+
+constexpr timestamping operator|(timestamping lhs, timestamping rhs) noexcept
+{
+  return static_cast<timestamping>(std::to_underlying(lhs) | std::to_underlying(rhs));
+}
+
+constexpr timestamping operator&(timestamping lhs, timestamping rhs) noexcept
+{
+  return static_cast<timestamping>(std::to_underlying(lhs) & std::to_underlying(rhs));
+}
+#endif
+
 namespace detail
 {
 template <>
@@ -56,5 +94,24 @@ struct socket_opt<sol_socket::linger>
   using type = struct ::linger;
   using return_type = type;
 };
+
+#ifdef SO_TIMESTAMPING
+template <>
+struct socket_opt<sol_socket::timestamping>
+{
+  using type = int;
+  using return_type = timestamping;
+
+  static constexpr return_type transform(type val) noexcept
+  {
+    return static_cast<return_type>(val);
+  }
+
+  static constexpr type transform(return_type val) noexcept
+  {
+    return static_cast<type>(val);
+  }
+};
+#endif
 }  // namespace detail
 }  // namespace olifilo::io
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -29,8 +30,27 @@ enum class sol_ip_tcp : int
 #endif
   ,
   keep_alive_interval = TCP_KEEPINTVL,
+
+#ifdef TCP_INFO
+  info = TCP_INFO,
+#endif
 };
 
+#ifdef TCP_INFO
+// Subset of TCP_INFO that's relevant for explaining latency
+struct tcp_connection_info
+{
+  std::uint8_t              state;               // TCP_ESTABLISHED, TCP_CLOSE_WAIT, ...
+  std::chrono::microseconds rtt;                 // smoothed round trip time
+  std::chrono::microseconds rtt_variance;
+  std::chrono::microseconds retransmit_timeout;
+  std::uint32_t             total_retransmits;   // over the connection's lifetime
+  std::uint32_t             congestion_window;   // in segments
+  std::uint32_t             unacked;             // segments in flight
+  std::uint32_t             lost;                // segments considered lost
+};
+#endif
+
 namespace detail
 {
 template <>
@@ -88,5 +108,28 @@ struct socket_opt<sol_ip_tcp::keep_alive_interval>
     return val.count();
   }
 };
+
+#ifdef TCP_INFO
+template <>
+struct socket_opt<sol_ip_tcp::info>
+{
+  using type = ::tcp_info;
+  using return_type = tcp_connection_info;
+
+  static constexpr return_type transform(const type& val) noexcept
+  {
+    return {
+      .state = val.tcpi_state,
+      .rtt = std::chrono::microseconds(val.tcpi_rtt),
+      .rtt_variance = std::chrono::microseconds(val.tcpi_rttvar),
+      .retransmit_timeout = std::chrono::microseconds(val.tcpi_rto),
+      .total_retransmits = val.tcpi_total_retrans,
+      .congestion_window = val.tcpi_snd_cwnd,
+      .unacked = val.tcpi_unacked,
+      .lost = val.tcpi_lost,
+    };
+  }
+};
+#endif
 }  // namespace detail
 }  // namespace olifilo::io
@@ -31,4 +31,17 @@ inline expected<std::span<const std::byte>> write_some(file_descriptor_handle fd
   else
     return buf.subspan(*rv);
 }
+
+// Blocking: only for fds in blocking mode, retries short writes and EINTR
+inline expected<void> write_all(file_descriptor_handle fd, std::span<const std::byte> buf) noexcept
+{
+  while (!buf.empty())
+  {
+    if (auto rv = write_some(fd, buf); !rv && rv.error() != std::errc::interrupted)
+      return {unexpect, rv.error()};
+    else if (rv)
+      buf = *rv;
+  }
+  return {};
+}
 }  // namespace olifilo::io
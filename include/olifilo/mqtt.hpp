@@ -33,7 +33,9 @@ class mqtt
       disconnect  = 14,
     };
 
-    std::chrono::duration<std::uint16_t> keep_alive{15};
+    static constexpr std::chrono::duration<std::uint16_t> default_keep_alive{15};
+
+    std::chrono::duration<std::uint16_t> keep_alive{default_keep_alive};
 
     static future<mqtt> connect(
         const char*                     host
@@ -41,6 +43,12 @@ class mqtt
       , std::uint8_t                    id
       , std::optional<std::string_view> username = {}
       , std::optional<std::string_view> password = {}) noexcept;
+    // Over an already connected stream, e.g. one end of an io::simulated_link
+    static future<mqtt> connect(
+        stream_socket                   sock
+      , std::uint8_t                    id
+      , std::optional<std::string_view> username = {}
+      , std::optional<std::string_view> password = {}) noexcept;
     future<void> disconnect() noexcept;
     future<void> ping() noexcept;
 
@@ -48,7 +56,16 @@ class mqtt
     mqtt& operator=(mqtt&&) = default;
 
   private:
-    mqtt() = default;
+    explicit mqtt(std::uint8_t id) noexcept
+      : keep_alive(static_cast<std::uint16_t>(default_keep_alive.count() << (id & 1)))
+    {
+    }
+
+    static future<mqtt> handshake(
+        mqtt                            con
+      , std::uint8_t                    id
+      , std::optional<std::string_view> username
+      , std::optional<std::string_view> password) noexcept;
 
     stream_socket _sock;
 };
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <olifilo/coro/executor_stats.hpp>
+
+namespace olifilo::io
+{
+struct mqtt_stats_snapshot
+{
+  std::uint64_t            connects_attempted = 0;
+  std::uint64_t            connects_succeeded = 0;
+  std::uint64_t            pings_sent = 0;
+  std::uint64_t            pings_answered = 0;
+  // PINGREQ -> PINGRESP round trip
+  std::uint64_t            ping_rtt_samples = 0;
+  std::chrono::nanoseconds ping_rtt_p50{};
+  std::chrono::nanoseconds ping_rtt_p99{};
+  std::chrono::nanoseconds ping_rtt_max{};
+};
+
+// Process wide MQTT client counters, updated with relaxed atomics just like executor_stats
+class mqtt_stats
+{
+  public:
+    mqtt_stats_snapshot snapshot() const noexcept
+    {
+      return {
+        .connects_attempted = _connects_attempted.load(std::memory_order_relaxed),
+        .connects_succeeded = _connects_succeeded.load(std::memory_order_relaxed),
+        .pings_sent = _pings_sent.load(std::memory_order_relaxed),
+        .pings_answered = _pings_answered.load(std::memory_order_relaxed),
+        .ping_rtt_samples = _ping_rtts.count(),
+        .ping_rtt_p50 = _ping_rtts.quantile(0.50),
+        .ping_rtt_p99 = _ping_rtts.quantile(0.99),
+        .ping_rtt_max = _ping_rtts.max(),
+      };
+    }
+
+    void reset() noexcept
+    {
+      for (auto* counter : {&_connects_attempted, &_connects_succeeded, &_pings_sent, &_pings_answered})
+        counter->store(0, std::memory_order_relaxed);
+      _ping_rtts.reset();
+    }
+
+    void add_connect_attempt() noexcept
+    {
+      _connects_attempted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add_connect_succeeded() noexcept
+    {
+      _connects_succeeded.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add_ping_sent() noexcept
+    {
+      _pings_sent.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void add_ping_answered(std::chrono::nanoseconds rtt) noexcept
+    {
+      _pings_answered.fetch_add(1, std::memory_order_relaxed);
+      _ping_rtts.add(rtt);
+    }
+
+  private:
+    std::atomic<std::uint64_t> _connects_attempted{0};
+    std::atomic<std::uint64_t> _connects_succeeded{0};
+    std::atomic<std::uint64_t> _pings_sent{0};
+    std::atomic<std::uint64_t> _pings_answered{0};
+    duration_histogram         _ping_rtts;
+};
+
+mqtt_stats& mqtt_statistics() noexcept;
+}  // namespace olifilo::io
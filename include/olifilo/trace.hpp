@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <olifilo/expected.hpp>
+#include <olifilo/io/types.hpp>
+
+// Bit mask of trace::category values that get recorded. Events in other categories compile to nothing.
+#ifndef OLIFILO_TRACE_CATEGORIES
+#define OLIFILO_TRACE_CATEGORIES 0
+#endif
+
+// Amount of records per thread, must be a power of two
+#ifndef OLIFILO_TRACE_BUFFER_RECORDS
+#define OLIFILO_TRACE_BUFFER_RECORDS 4096
+#endif
+
+namespace olifilo::trace
+{
+enum class category : std::uint32_t
+{
+  executor = 1u << 0,
+  promise  = 1u << 1,
+  io       = 1u << 2,
+  app      = 1u << 3,
+};
+
+// X(category, event, arg0, arg1, arg2): argument names are for the decoder only, "" for unused ones.
+// Only ever append to this list: the decoder identifies events by their position.
+#define OLIFILO_TRACE_EVENTS(X) \
+  X(executor, poll_register,      "handler",     "fd|events<<32", "timeout_in_ns") \
+  X(executor, poll_timed_out,     "handler",     "fd",            "late_ns")       \
+  X(executor, poll_ready,         "handler",     "fd",            "events")        \
+  X(executor, poll_resume,        "handler",     "waiter",        "")              \
+  X(promise,  poll_suspend,       "handler",     "fd",            "promise")       \
+  X(io,       fd_read_some,       "fd",          "size",          "")              \
+  X(io,       fd_write_some,      "fd",          "size",          "")              \
+  X(io,       fd_read,            "fd",          "size",          "")              \
+  X(io,       fd_write,           "fd",          "size",          "")              \
+  X(io,       socket_create,      "domain",      "protocol",      "")              \
+  X(io,       socket_connect,     "fd",          "",              "")              \
+  X(app,      sleep_until,        "deadline_ns", "timeout_in_ns", "")              \
+  X(app,      mqtt_step,          "id",          "step",          "error")         \
+  X(promise,  promise_create,     "promise",     "",              "")              \
+  X(promise,  promise_final,      "promise",     "error",         "")              \
+  X(promise,  promise_destroy,    "promise",     "",              "")              \
+  X(promise,  await_future,       "caller",      "callee",        "")              \
+  X(promise,  wait_begin,         "caller",      "count",         "until")         \
+  X(promise,  wait_edge,          "caller",      "callee",        "")              \
+  X(promise,  wait_end,           "caller",      "",              "")              \
+  X(executor, iteration_begin,    "fd_waits",    "timeout_in_ns", "")              \
+  X(executor, iteration_end,      "blocked_ns",  "resumed",       "")
+
+enum class event : std::uint16_t
+{
+#define OLIFILO_TRACE_X(cat, name, a0, a1, a2) name,
+  OLIFILO_TRACE_EVENTS(OLIFILO_TRACE_X)
+#undef OLIFILO_TRACE_X
+};
+
+struct event_info
+{
+  category    cat;
+  const char* name;
+  const char* args[3];
+};
+
+inline constexpr event_info events[] = {
+#define OLIFILO_TRACE_X(cat, name, a0, a1, a2) {category::cat, #name, {a0, a1, a2}},
+  OLIFILO_TRACE_EVENTS(OLIFILO_TRACE_X)
+#undef OLIFILO_TRACE_X
+};
+
+// Fixed size binary record. Formatting is left to the offline decoder (olifilo-trace-decode).
+struct record
+{
+  std::uint64_t timestamp_ns; // steady_clock
+  std::uint16_t id;           // event
+  std::uint16_t reserved;
+  std::uint32_t thread;       // sequence number of the recording thread
+  std::uint64_t args[3];
+};
+static_assert(sizeof(record) == 40 && std::is_trivially_copyable_v<record>);
+
+// Layout of a dump: file_header, followed by 'record_count' records in recording order per thread
+struct file_header
+{
+  char          magic[8] = {'O', 'L', 'F', 'T', 'R', 'A', 'C', 'E'};
+  std::uint32_t version = 1;
+  std::uint32_t record_size = sizeof(record);
+  std::uint32_t event_count = static_cast<std::uint32_t>(std::size(events));
+  std::uint32_t reserved = 0;
+  std::uint64_t record_count = 0;
+};
+
+inline constexpr std::uint32_t enabled_categories = OLIFILO_TRACE_CATEGORIES;
+inline constexpr std::size_t buffer_records = OLIFILO_TRACE_BUFFER_RECORDS;
+static_assert((buffer_records & (buffer_records - 1)) == 0, "OLIFILO_TRACE_BUFFER_RECORDS must be a power of two");
+
+constexpr bool enabled(event e) noexcept
+{
+  return enabled_categories & std::to_underlying(events[std::to_underlying(e)].cat);
+}
+
+namespace detail
+{
+struct ring
+{
+  std::uint64_t head = 0;
+  std::uint32_t thread = 0;
+  ring*         next = nullptr;
+  record        records[buffer_records];
+};
+
+constinit inline thread_local ring* current_ring = nullptr;
+
+// Allocates and registers this thread's ring. nullptr when out of memory.
+ring* register_thread() noexcept;
+
+inline void write(event e, std::uint64_t a0 = 0, std::uint64_t a1 = 0, std::uint64_t a2 = 0) noexcept
+{
+  ring* r = current_ring;
+  if (!r && !(r = register_thread())) [[unlikely]]
+    return;
+
+  auto& rec = r->records[r->head & (buffer_records - 1)];
+  rec.timestamp_ns = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  rec.id = std::to_underlying(e);
+  rec.thread = r->thread;
+  rec.args[0] = a0;
+  rec.args[1] = a1;
+  rec.args[2] = a2;
+  // published with release semantics so snapshot() doesn't see the head move before the record got written
+  std::atomic_ref(r->head).store(r->head + 1, std::memory_order_release);
+}
+
+template <typename T>
+constexpr std::uint64_t to_arg(T value) noexcept
+{
+  if constexpr (std::is_pointer_v<T>)
+    return reinterpret_cast<std::uintptr_t>(value);
+  else if constexpr (std::is_enum_v<T>)
+    return static_cast<std::uint64_t>(std::to_underlying(value));
+  else if constexpr (std::is_same_v<T, io::file_descriptor_handle>)
+    return static_cast<std::uint64_t>(static_cast<int>(value));
+  else if constexpr (requires { value.address(); })
+    return reinterpret_cast<std::uintptr_t>(value.address());
+  else if constexpr (requires { value.count(); })
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(value).count());
+  else if constexpr (requires { value.time_since_epoch(); })
+    return to_arg(value.time_since_epoch());
+  else
+    return static_cast<std::uint64_t>(value);
+}
+}  // namespace detail
+
+/**
+ * Records 'E' with up to three arguments in the calling thread's ring buffer, overwriting the oldest
+ * record when full. Compiles to nothing unless E's category is in OLIFILO_TRACE_CATEGORIES.
+ * Pointers, coroutine handles, fds, enums, durations and time points are stored as integers.
+ */
+template <event E, typename... Args>
+requires(sizeof...(Args) <= 3)
+inline void emit([[maybe_unused]] Args... args) noexcept
+{
+  if constexpr (enabled(E))
+    detail::write(E, detail::to_arg(args)...);
+}
+
+// Copy of all threads' records, oldest first per thread. Records written concurrently may be torn.
+std::vector<record> snapshot();
+
+// Writes a file_header and snapshot() to 'fd', for decoding with olifilo-trace-decode
+expected<void> dump(io::file_descriptor_handle fd) noexcept;
+}  // namespace olifilo::trace
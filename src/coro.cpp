@@ -1,12 +1,14 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include <olifilo/coro/future.hpp>
+#include <olifilo/coro/interval.hpp>
 #include <olifilo/coro/when_all.hpp>
 #include <olifilo/coro/when_any.hpp>
 #include <olifilo/expected.hpp>
 #include <olifilo/io/poll.hpp>
 #include <olifilo/io/types.hpp>
 #include <olifilo/mqtt.hpp>
+#include <olifilo/trace.hpp>
 
 #include "logging-stuff.hpp"
 
@@ -43,8 +45,7 @@ namespace olifilo
 {
 future<void> sleep_until(io::poll::timeout_clock::time_point time) noexcept
 {
-  ////auto timeout = time - io::poll::timeout_clock::now();
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}({}@{})\n", ts(), __LINE__, "sleep_until", std::chrono::duration_cast<std::chrono::milliseconds>(timeout), std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()));
+  trace::emit<trace::event::sleep_until>(time, time - io::poll::timeout_clock::now());
 
   if (auto r = co_await io::poll(time);
       !r && r.error() != std::errc::timed_out)
@@ -59,11 +60,21 @@ future<void> sleep(io::poll::timeout_clock::duration time) noexcept
 }
 }  // namespace olifilo
 
+// 'step' argument of trace::event::mqtt_step
+enum class mqtt_step
+{
+  start,
+  connect,
+  tick,
+  ping,
+  disconnect,
+};
+
 olifilo::future<void> do_mqtt(std::uint8_t id) noexcept
 {
   using namespace std::literals::chrono_literals;
 
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}({})\n", ts(), __LINE__, "do_mqtt", id);
+  olifilo::trace::emit<olifilo::trace::event::mqtt_step>(id, mqtt_step::start, 0);
 
   static constexpr char mqtt_default_host[] = "fdce:1234:5678::1";
   std::string_view host = mqtt_default_host;
@@ -201,7 +212,7 @@ olifilo::future<void> do_mqtt(std::uint8_t id) noexcept
 #endif
 
   auto r = co_await olifilo::io::mqtt::connect(host.data(), port, id, username, password);
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}({}) r = {}\n", ts(), __LINE__, "do_mqtt", id, static_cast<bool>(r));
+  olifilo::trace::emit<olifilo::trace::event::mqtt_step>(id, mqtt_step::connect, r ? 0 : r.error().value());
   if (!r)
     co_return r;
 
@@ -210,26 +221,25 @@ olifilo::future<void> do_mqtt(std::uint8_t id) noexcept
   const auto start = clock::now() - ts();
   constexpr auto run_time = 120s;
 
-  clock::time_point now;
-  while ((now = clock::now()) - start < run_time)
+  olifilo::interval keep_alive(keep_alive_wait_time, start);
+  while (clock::now() - start < run_time)
   {
-    const auto sleep_time = keep_alive_wait_time - (now - start) % keep_alive_wait_time;
-    auto err = co_await olifilo::sleep_until(now + sleep_time);
-    ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}({}) err = {}\n", ts(), __LINE__, "do_mqtt", id, (err ? std::error_code() : err.error()).message());
-    if (!err)
-      co_return err;
+    auto tick = co_await keep_alive.tick();
+    olifilo::trace::emit<olifilo::trace::event::mqtt_step>(id, mqtt_step::tick, tick ? 0 : tick.error().value());
+    if (!tick)
+      co_return tick.error();
 
     if (clock::now() - start >= run_time)
       break;
 
-    err = co_await r->ping();
-    ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}({}) err = {}\n", ts(), __LINE__, "do_mqtt", id, (err ? std::error_code() : err.error()).message());
+    auto err = co_await r->ping();
+    olifilo::trace::emit<olifilo::trace::event::mqtt_step>(id, mqtt_step::ping, err ? 0 : err.error().value());
     if (!err)
       co_return err;
   }
 
   auto err = co_await r->disconnect();
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}({}) err = {}\n", ts(), __LINE__, "do_mqtt", id, (err ? std::error_code() : err.error()).message());
+  olifilo::trace::emit<olifilo::trace::event::mqtt_step>(id, mqtt_step::disconnect, err ? 0 : err.error().value());
   co_return err;
 }
 
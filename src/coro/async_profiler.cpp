@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/async_profiler.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <olifilo/coro/async_stack.hpp>
+#include <olifilo/io/write.hpp>
+
+namespace olifilo
+{
+struct detail::async_profile
+{
+  struct sample
+  {
+    std::atomic<bool> complete = false;
+    bool              truncated = false;
+    std::size_t       depth = 0;
+    // async_frame_function() of every frame, outermost first
+    const void*       functions[async_stack_depth];
+  };
+
+  std::unique_ptr<sample[]>     samples;
+  std::size_t                   capacity = 0;
+  std::atomic<std::size_t>      next = 0;
+  std::atomic<std::size_t>      dropped = 0;
+  struct ::sigaction            previous_action;
+  bool                          running = false;
+};
+
+namespace
+{
+std::atomic<detail::async_profile*> active = nullptr;
+// Signal handlers that may be using 'active' on any thread. Announced *before* loading 'active', so
+// that once it's cleared waiting for this to drop to zero ensures nobody uses the old profile anymore.
+std::atomic<unsigned>               in_handler = 0;
+
+void record_sample(detail::async_profile& prof) noexcept
+{
+  const auto i = prof.next.fetch_add(1, std::memory_order_relaxed);
+  if (i >= prof.capacity)
+  {
+    prof.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto& sample = prof.samples[i];
+  const auto stack = current_async_stack();
+  sample.depth = stack.size();
+  sample.truncated = current_async_stack_truncated();
+  for (std::size_t frame = 0; frame < stack.size(); ++frame)
+    sample.functions[frame] = async_frame_function(stack[frame]);
+  sample.complete.store(true, std::memory_order_release);
+}
+
+void on_sigprof(int) noexcept
+{
+  const int saved_errno = errno;
+  in_handler.fetch_add(1, std::memory_order_seq_cst);
+  if (auto* const prof = active.load(std::memory_order_seq_cst))
+    record_sample(*prof);
+  in_handler.fetch_sub(1, std::memory_order_release);
+  errno = saved_errno;
+}
+
+::timeval to_timeval(std::chrono::microseconds period) noexcept
+{
+  const auto secs = std::chrono::duration_cast<std::chrono::seconds>(period);
+  return {
+    .tv_sec = static_cast<decltype(::timeval::tv_sec)>(secs.count()),
+    .tv_usec = static_cast<decltype(::timeval::tv_usec)>((period - secs).count()),
+  };
+}
+}  // anonymous namespace
+
+std::string coroutine_name(const void* function)
+{
+  if (!function)
+    return "[unknown]";
+
+  std::string name;
+  if (::Dl_info info; ::dladdr(function, &info) && info.dli_sname)
+  {
+    int status;
+    std::unique_ptr<char, decltype(&std::free)> demangled(abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status), &std::free);
+    name = status == 0 ? demangled.get() : info.dli_sname;
+
+    // Name the coroutine, not the compiler generated function resuming it
+    for (const std::string_view suffix : {" [clone .actor]", " (.resume)", ".resume", ".actor"})
+    {
+      if (name.ends_with(suffix))
+      {
+        name.resize(name.size() - suffix.size());
+        break;
+      }
+    }
+  }
+  else if (info.dli_fname)
+  {
+    const std::string_view module(info.dli_fname);
+    char offset[24];
+    std::snprintf(offset, sizeof(offset), "+0x%" PRIxPTR, reinterpret_cast<std::uintptr_t>(function) - reinterpret_cast<std::uintptr_t>(info.dli_fbase));
+    name = module.substr(module.rfind('/') + 1);
+    name += offset;
+  }
+  else
+  {
+    char address[24];
+    std::snprintf(address, sizeof(address), "0x%" PRIxPTR, reinterpret_cast<std::uintptr_t>(function));
+    name = address;
+  }
+
+  return name;
+}
+
+async_profiler::async_profiler(std::unique_ptr<detail::async_profile> profile) noexcept
+  : _state(std::move(profile))
+{
+}
+
+async_profiler& async_profiler::operator=(async_profiler&& rhs) noexcept
+{
+  stop();
+  _state = std::move(rhs._state);
+  return *this;
+}
+
+async_profiler::~async_profiler()
+{
+  stop();
+}
+
+expected<async_profiler> async_profiler::start(std::chrono::microseconds period, std::size_t max_samples) noexcept
+{
+  if (period <= period.zero())
+    return {unexpect, make_error_code(std::errc::invalid_argument)};
+
+  std::unique_ptr<detail::async_profile> s(new (std::nothrow) detail::async_profile);
+  if (!s)
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+  s->samples.reset(new (std::nothrow) detail::async_profile::sample[max_samples]);
+  if (!s->samples)
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+  s->capacity = max_samples;
+
+  detail::async_profile* expected_idle = nullptr;
+  if (!active.compare_exchange_strong(expected_idle, s.get(), std::memory_order_acq_rel))
+    return {unexpect, make_error_code(std::errc::device_or_resource_busy)};
+
+  struct ::sigaction action{};
+  action.sa_handler = on_sigprof;
+  action.sa_flags = SA_RESTART;
+  ::sigemptyset(&action.sa_mask);
+  if (::sigaction(SIGPROF, &action, &s->previous_action) == -1)
+  {
+    const int error = errno;
+    active.store(nullptr, std::memory_order_release);
+    return {unexpect, error, std::system_category()};
+  }
+  s->running = true;
+
+  const ::itimerval timer{
+    .it_interval = to_timeval(period),
+    .it_value = to_timeval(period),
+  };
+  if (::setitimer(ITIMER_PROF, &timer, nullptr) == -1)
+  {
+    const int error = errno;
+    async_profiler(std::move(s)).stop();
+    return {unexpect, error, std::system_category()};
+  }
+
+  return async_profiler(std::move(s));
+}
+
+void async_profiler::stop() noexcept
+{
+  if (!_state || !_state->running)
+    return;
+
+  const ::itimerval disarmed{};
+  (void)::setitimer(ITIMER_PROF, &disarmed, nullptr);
+  active.store(nullptr, std::memory_order_seq_cst);
+  // Handlers that loaded 'active' before we cleared it have announced themselves already
+  while (in_handler.load(std::memory_order_seq_cst))
+    ;
+  (void)::sigaction(SIGPROF, &_state->previous_action, nullptr);
+  _state->running = false;
+}
+
+std::size_t async_profiler::samples() const noexcept
+{
+  return _state ? std::min(_state->next.load(std::memory_order_relaxed), _state->capacity) : 0;
+}
+
+std::size_t async_profiler::dropped_samples() const noexcept
+{
+  return _state ? _state->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+expected<void> async_profiler::write_folded(io::file_descriptor_handle fd) const noexcept
+{
+  std::string out;
+#if __cpp_exceptions
+  try
+#endif
+  {
+    std::unordered_map<const void*, std::string> names;
+    std::map<std::string, std::uint64_t> stacks;
+
+    std::string stack;
+    for (const auto& sample : std::span(_state ? _state->samples.get() : nullptr, samples()))
+    {
+      if (!sample.complete.load(std::memory_order_acquire))
+        continue;
+
+      stack.clear();
+      for (std::size_t i = 0; i < sample.depth; ++i)
+      {
+        auto name = names.find(sample.functions[i]);
+        if (name == names.end())
+        {
+          auto frame = coroutine_name(sample.functions[i]);
+          // ';' separates frames in the folded format
+          for (auto& c : frame)
+            if (c == ';')
+              c = ',';
+          name = names.emplace(sample.functions[i], std::move(frame)).first;
+        }
+        if (i)
+          stack += ';';
+        stack += name->second;
+      }
+      if (sample.depth == 0)
+        stack = "[no coroutine]";
+      else if (sample.truncated)
+        stack += ";[truncated]";
+
+      ++stacks[stack];
+    }
+
+    for (const auto& [frames, count] : stacks)
+    {
+      out += frames;
+      out += ' ';
+      out += std::to_string(count);
+      out += '\n';
+    }
+  }
+#if __cpp_exceptions
+  catch (const std::bad_alloc&)
+  {
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+  }
+#endif
+
+  return io::write_all(fd, as_bytes(std::span(out)));
+}
+}  // namespace olifilo
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/executor_stats.hpp>
+
+namespace olifilo
+{
+namespace
+{
+executor_stats stats;
+}  // anonymous namespace
+
+void executor_stats::reset() noexcept
+{
+  for (auto* counter : {
+        &_loop_iterations,
+        &_blocked_ns,
+        &_fds_registered,
+        &_handlers_resumed,
+        &_max_handlers_resumed,
+        &_timers_armed,
+        &_timers_expired,
+        &_eager_io_completed,
+        &_eager_io_would_block,
+        &_eager_io_failed,
+      })
+    counter->store(0, std::memory_order_relaxed);
+  for (std::size_t i = 0; i < fd_class_count; ++i)
+  {
+    _bytes_read[i].store(0, std::memory_order_relaxed);
+    _bytes_written[i].store(0, std::memory_order_relaxed);
+  }
+  _resume_delays.reset();
+}
+
+executor_stats& executor_statistics() noexcept
+{
+  return stats;
+}
+}  // namespace olifilo
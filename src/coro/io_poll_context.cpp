@@ -4,22 +4,35 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <optional>
 #include <ranges>
 #include <utility>
 
+#if OLIFILO_EXECUTOR_TIMERFD
+#include <cerrno>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+#include <olifilo/coro/async_stack.hpp>
 #include <olifilo/coro/detail/promise.hpp>
+#include <olifilo/coro/executor_stats.hpp>
 #include <olifilo/expected.hpp>
+#include <olifilo/io/clock.hpp>
 #include <olifilo/io/poll.hpp>
 #include <olifilo/io/select.hpp>
 #include <olifilo/io/types.hpp>
+#include <olifilo/trace.hpp>
 
 namespace olifilo::detail
 {
 namespace
 {
-expected<unsigned> extract_events(promise_wait_callgraph& polled, ::fd_set& readfds, ::fd_set& writefds, ::fd_set& exceptfds, std::optional<std::chrono::steady_clock::time_point>& timeout, const std::chrono::steady_clock::time_point now) noexcept
+expected<unsigned> extract_events(promise_wait_callgraph& polled, ::fd_set& readfds, ::fd_set& writefds, ::fd_set& exceptfds, std::optional<std::chrono::steady_clock::time_point>& timeout, const std::chrono::steady_clock::time_point now, const std::chrono::steady_clock::time_point ready_at, std::uint64_t& fd_waits) noexcept
 {
   unsigned nfds = 0;
 
@@ -35,21 +48,24 @@ expected<unsigned> extract_events(promise_wait_callgraph& polled, ::fd_set& read
           [&] (promise_wait_callgraph* const callee)
           {
             // Recurse into 
-            return extract_events(*callee, readfds, writefds, exceptfds, timeout, now);
+            return extract_events(*callee, readfds, writefds, exceptfds, timeout, now, ready_at, fd_waits);
           },
-          [&i, &next, &to_resume, &readfds, &writefds, &exceptfds, &timeout, now]
+          [&i, &next, &to_resume, &readfds, &writefds, &exceptfds, &timeout, now, ready_at, &fd_waits]
           (awaitable_poll* const handlerp) -> expected<unsigned>
           {
             auto& handler = *handlerp;
 
             assert(!handler.wait_result && handler.wait_result.error() == error::uninitialized && "event with pending result should have been dispatched");
 
-            ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}[{}](event@{}=({}, fd={}, timeout={}, waiter={}))\n", ts(), __LINE__, func_name, idx++, static_cast<const void*>(&handler), handler.events, handler.fd, handler.timeout.transform([&] (auto time) { return std::chrono::duration_cast<std::chrono::microseconds>(time - now); }), handler.waiter.address());
+            trace::emit<trace::event::poll_register>(handlerp
+              , static_cast<std::uint32_t>(static_cast<int>(handler.fd)) | (std::uint64_t(std::to_underlying(handler.events)) << 32)
+              , handler.timeout ? *handler.timeout - now : std::chrono::steady_clock::duration::max());
 
             if (!(0 <= handler.fd && handler.fd < FD_SETSIZE) && !handler.timeout)
             {
               // Because we're using select() which has a very limited range of acceptable file descriptors (usually [0:1024))
               handler.wait_result = unexpected(std::make_error_code(std::errc::bad_file_descriptor));
+              handler.ready_at = ready_at;
               std::ranges::iter_swap(i, --to_resume);
               next = i;
               return {std::in_place, 0};
@@ -59,7 +75,9 @@ expected<unsigned> extract_events(promise_wait_callgraph& polled, ::fd_set& read
             {
               if (*handler.timeout < now)
               {
+                executor_statistics().add_timer_expired();
                 handler.wait_result = unexpected(std::make_error_code(std::errc::timed_out));
+                handler.ready_at = ready_at;
                 std::ranges::iter_swap(i, --to_resume);
                 next = i;
                 return {std::in_place, 0};
@@ -74,6 +92,7 @@ expected<unsigned> extract_events(promise_wait_callgraph& polled, ::fd_set& read
             if (!handler.fd)
               return {std::in_place, 0};
 
+            ++fd_waits;
             unsigned nfds = 0;
             if (std::to_underlying(handler.events & io::poll::read))
             {
@@ -109,9 +128,8 @@ expected<unsigned> extract_events(promise_wait_callgraph& polled, ::fd_set& read
   return nfds;
 }
 
-void mark_events(promise_wait_callgraph& polled, const ::fd_set& readfds, const ::fd_set& writefds, const ::fd_set& exceptfds, const std::optional<std::chrono::steady_clock::time_point> timeout) noexcept
+void mark_events(promise_wait_callgraph& polled, const ::fd_set& readfds, const ::fd_set& writefds, const ::fd_set& exceptfds, const std::optional<std::chrono::steady_clock::time_point> timeout, const std::chrono::steady_clock::time_point ready_at) noexcept
 {
-  ////unsigned idx = 0;
   auto to_resume = std::ranges::find_if(polled.callees, [] (const auto& callee) {
       return visit(
           overloaded{
@@ -133,21 +151,22 @@ void mark_events(promise_wait_callgraph& polled, const ::fd_set& readfds, const
         overloaded{
           [&] (promise_wait_callgraph* const callee)
           {
-            return mark_events(*callee, readfds, writefds, exceptfds, timeout);
+            return mark_events(*callee, readfds, writefds, exceptfds, timeout, ready_at);
           },
-          [&i, &next, &to_resume, &readfds, &writefds, &exceptfds, timeout]
+          [&i, &next, &to_resume, &readfds, &writefds, &exceptfds, timeout, ready_at]
           (awaitable_poll* const handlerp)
           {
             auto& handler = *handlerp;
-            ////idx++;
 
             if (timeout)
             {
               if (!handler.timeout || timeout < *handler.timeout)
                 return;
 
-              ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}[{}](event@{}=({}, fd={}, timeout={}, waiter={}))\n", ts(), __LINE__, func_name, idx - 1, static_cast<const void*>(&handler), handler.events, handler.fd, handler.timeout.transform([&] (auto time) { return std::chrono::duration_cast<std::chrono::microseconds>(time - *timeout); }), handler.waiter.address());
+              trace::emit<trace::event::poll_timed_out>(handlerp, handler.fd, *timeout - *handler.timeout);
+              executor_statistics().add_timer_expired();
               handler.wait_result = unexpected(std::make_error_code(std::errc::timed_out));
+              handler.ready_at = ready_at;
               std::ranges::iter_swap(i, --to_resume);
               next = i;
               return;
@@ -161,8 +180,9 @@ void mark_events(promise_wait_callgraph& polled, const ::fd_set& readfds, const
              && !(std::to_underlying(handler.events & io::poll::priority) && FD_ISSET(handler.fd, &exceptfds)))
               return;
 
-            ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}[{}](event@{}=({}, fd={}, timeout={}, waiter={}))\n", ts(), __LINE__, func_name, idx - 1, static_cast<const void*>(&handler), handler.events, handler.fd, handler.timeout.transform([&] (auto time) { return std::chrono::duration_cast<std::chrono::microseconds>(time - now); }), handler.waiter.address());
+            trace::emit<trace::event::poll_ready>(handlerp, handler.fd, handler.events);
             handler.wait_result.emplace(); // no polling error (may be an error event but that's for checking downstream)
+            handler.ready_at = ready_at;
             std::ranges::iter_swap(i, --to_resume);
             next = i;
           },
@@ -171,7 +191,8 @@ void mark_events(promise_wait_callgraph& polled, const ::fd_set& readfds, const
   }
 }
 
-std::coroutine_handle<> pop_ready_completion_handler(promise_wait_callgraph& polled) noexcept
+// 'level' is polled's distance from the root, the path to the returned handler is recorded as async stack
+std::coroutine_handle<> pop_ready_completion_handler(promise_wait_callgraph& polled, std::size_t level = 0) noexcept
 {
   // recursing into children who's event handlers may cause them to be destroyed!
   // Only the root node is safe from destruction (at worst it's waiting at its final suspend point)
@@ -193,7 +214,9 @@ std::coroutine_handle<> pop_ready_completion_handler(promise_wait_callgraph& pol
       auto waiter = std::exchange(handler->waits_on_me, nullptr);
       assert(waiter);
       polled.callees.erase(ready_poll);
-      ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}[{}]resume(waiter={}))\n", ts(), __LINE__, func_name, ready_poll - std::ranges::begin(polled.callees), waiter.address());
+      executor_statistics().add_resume_delay(std::chrono::steady_clock::now() - handler->ready_at);
+      trace::emit<trace::event::poll_resume>(handler, waiter);
+      record_async_leaf(level, waiter);
       return waiter;
     }
   }
@@ -204,11 +227,14 @@ std::coroutine_handle<> pop_ready_completion_handler(promise_wait_callgraph& pol
     assert(*i != nullptr);
     if (auto handler = visit(
         overloaded{
-          [] (promise_wait_callgraph* const callee)
+          [level] (promise_wait_callgraph* const callee)
           {
-            return pop_ready_completion_handler(*callee);
+            auto handler = pop_ready_completion_handler(*callee, level + 1);
+            if (handler)
+              record_async_frame(level, callee->waits_on_me);
+            return handler;
           },
-          [i, &polled] (awaitable_poll* const handlerp) -> std::coroutine_handle<>
+          [i, &polled, level] (awaitable_poll* const handlerp) -> std::coroutine_handle<>
           {
             auto& handler = *handlerp;
             if (handler.wait_result.error() == error::uninitialized)
@@ -217,7 +243,9 @@ std::coroutine_handle<> pop_ready_completion_handler(promise_wait_callgraph& pol
             auto waiter = std::exchange(handler.waits_on_me, nullptr);
             assert(waiter);
             polled.callees.erase(i);
-            ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}[{}]resume(waiter={}))\n", ts(), __LINE__, func_name, i, waiter.address());
+            executor_statistics().add_resume_delay(std::chrono::steady_clock::now() - handler.ready_at);
+            trace::emit<trace::event::poll_resume>(handlerp, waiter);
+            record_async_leaf(level, waiter);
             return waiter;
           },
         }
@@ -229,6 +257,19 @@ std::coroutine_handle<> pop_ready_completion_handler(promise_wait_callgraph& pol
 }
 }  // anonymous namespace
 
+#if OLIFILO_EXECUTOR_TIMERFD
+io_poll_context::io_poll_context() noexcept
+  : _timer(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+{
+}
+
+io_poll_context::~io_poll_context()
+{
+  if (_timer != -1)
+    ::close(_timer);
+}
+#endif
+
 std::error_code io_poll_context::operator()(promise_wait_callgraph& polled)
 {
   fd_set readfds, writefds, exceptfds;
@@ -237,27 +278,116 @@ std::error_code io_poll_context::operator()(promise_wait_callgraph& polled)
   FD_ZERO(&exceptfds);
   unsigned nfds;
   std::optional<std::chrono::steady_clock::time_point> timeout;
+  std::uint64_t fd_waits = 0;
+  std::chrono::steady_clock::duration blocked{};
 
-  if (auto r = extract_events(polled, readfds, writefds, exceptfds, timeout, std::chrono::steady_clock::now()); !r)
+  // Timeouts are on executor_clock, which may be simulated. Statistics always use real time.
+  auto* const sim = io::virtual_time::current();
+  const auto real_now = std::chrono::steady_clock::now();
+  const auto now = sim ? sim->now() : real_now;
+  if (auto r = extract_events(polled, readfds, writefds, exceptfds, timeout, now, real_now, fd_waits); !r)
     return r.error();
   else
     nfds = *r;
 
+  trace::emit<trace::event::iteration_begin>(fd_waits, timeout ? *timeout - now : std::chrono::steady_clock::duration::max());
+
   if (nfds || timeout)
   {
-    if (const auto r = io::select(nfds, nfds ? &readfds : nullptr, nfds ? &writefds : nullptr, nfds ? &exceptfds : nullptr, timeout); !r)
+#if OLIFILO_EXECUTOR_TIMERFD
+    const bool use_timer = !sim && timeout && _timer != -1 && _timer < FD_SETSIZE;
+    if (use_timer)
+    {
+      if (*timeout != _armed_deadline)
+      {
+        // steady_clock is CLOCK_MONOTONIC on Linux, so its epoch matches what TFD_TIMER_ABSTIME expects
+        const auto deadline = timeout->time_since_epoch();
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(deadline);
+        const ::itimerspec spec{
+          .it_value = {
+            .tv_sec = static_cast<decltype(spec.it_value.tv_sec)>(secs.count()),
+            .tv_nsec = static_cast<decltype(spec.it_value.tv_nsec)>(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - secs).count()),
+          },
+        };
+        if (::timerfd_settime(_timer, TFD_TIMER_ABSTIME, &spec, nullptr) == -1)
+          return std::error_code(errno, std::system_category());
+        _armed_deadline = *timeout;
+      }
+
+      FD_SET(_timer, &readfds);
+      nfds = std::max(nfds, static_cast<unsigned>(_timer) + 1);
+    }
+#endif
+
+    const auto select_start = std::chrono::steady_clock::now();
+    const auto r =
+        // Simulated time: only pick up what's ready right now, time jumps to the timeout instead of waiting for it
+        sim && timeout ? io::select(nfds, nfds ? &readfds : nullptr, nfds ? &writefds : nullptr, nfds ? &exceptfds : nullptr, std::chrono::microseconds::zero()) :
+#if OLIFILO_EXECUTOR_TIMERFD
+        use_timer ? io::select(nfds, &readfds, &writefds, &exceptfds) :
+#endif
+#if _POSIX_C_SOURCE >= 200112L
+        io::pselect(nfds, nfds ? &readfds : nullptr, nfds ? &writefds : nullptr, nfds ? &exceptfds : nullptr, timeout);
+#else
+        io::select(nfds, nfds ? &readfds : nullptr, nfds ? &writefds : nullptr, nfds ? &exceptfds : nullptr, timeout);
+#endif
+    const auto woken = std::chrono::steady_clock::now();
+    blocked = woken - select_start;
+
+    if (!r && r.error() == std::errc::interrupted)
+    {
+      // Interrupted by a signal handler: the fd sets' content is unspecified now, so don't mark anything.
+      // Still dispatch what extract_events resolved already, the rest gets picked up next iteration.
+    }
+    else if (!r)
       return r.error();
-    else if (*r == 0)
-      timeout.emplace(std::chrono::steady_clock::now());
+    else if (sim && timeout && *r == 0)
+    {
+      sim->advance_to(*timeout);
+      mark_events(polled, readfds, writefds, exceptfds, timeout, woken);
+    }
+#if OLIFILO_EXECUTOR_TIMERFD
+    else if (use_timer)
+    {
+      const bool expired = FD_ISSET(_timer, &readfds);
+      FD_CLR(_timer, &readfds);
+      if (expired)
+      {
+        std::uint64_t expirations;
+        (void)::read(_timer, &expirations, sizeof(expirations));
+        // the timerfd is one-shot: ensure we re-arm it even if the next deadline happens to be the same
+        _armed_deadline = {};
+      }
+
+      // The timer may expire together with other fds becoming ready: dispatch both
+      if (*r > (expired ? 1u : 0u))
+        mark_events(polled, readfds, writefds, exceptfds, std::nullopt, woken);
+      if (expired)
+        mark_events(polled, readfds, writefds, exceptfds, std::chrono::steady_clock::now(), woken);
+    }
+#endif
     else
-      timeout.reset();
+    {
+      if (*r == 0)
+        timeout.emplace(woken);
+      else
+        timeout.reset();
 
-    mark_events(polled, readfds, writefds, exceptfds, timeout);
+      mark_events(polled, readfds, writefds, exceptfds, timeout, woken);
+    }
   }
 
+  std::uint64_t resumed = 0;
   while (auto handler = pop_ready_completion_handler(polled))
+  {
+    ++resumed;
+    publish_async_stack();
     handler();
+    clear_async_stack();
+  }
 
+  executor_statistics().add_iteration(std::chrono::duration_cast<std::chrono::nanoseconds>(blocked), fd_waits, resumed);
+  trace::emit<trace::event::iteration_end>(blocked, resumed);
   return {};
 }
 }  // namespace olifilo::detail
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/memory_budget.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace olifilo
+{
+namespace
+{
+// Precedes every coroutine frame to find its budget back on deallocation
+struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_header
+{
+  memory_budget* budget;
+};
+}  // anonymous namespace
+
+memory_budget::memory_budget(std::size_t limit, std::pmr::memory_resource* upstream) noexcept
+  : _upstream(upstream)
+  , _limit(limit)
+  , _previous(detail::this_thread_memory_budget)
+{
+  for (std::size_t i = 0; i < memory_category_count; ++i)
+  {
+    _resources[i].budget = this;
+    _resources[i].category = static_cast<memory_category>(i);
+  }
+  detail::this_thread_memory_budget = this;
+}
+
+memory_budget::~memory_budget()
+{
+  assert(_used == 0 && "memory_budget destroyed while some of its memory is still allocated");
+  detail::this_thread_memory_budget = _previous;
+}
+
+void* memory_budget::allocate_for(memory_category category, std::size_t size, std::size_t alignment, const void* caller) noexcept
+{
+  auto& usage = _usage[static_cast<std::size_t>(category)];
+  if (size > _limit - _used)
+  {
+    ++usage.failures;
+    return nullptr;
+  }
+
+  void* p = nullptr;
+#if __cpp_exceptions
+  try
+#endif
+  {
+    p = _upstream->allocate(size, alignment);
+  }
+#if __cpp_exceptions
+  catch (const std::bad_alloc&)
+  {
+  }
+#endif
+  if (!p)
+  {
+    ++usage.failures;
+    return nullptr;
+  }
+
+  _used += size;
+  _high_water = std::max(_high_water, _used);
+  ++usage.allocations;
+  usage.current += size;
+  usage.high_water = std::max(usage.high_water, usage.current);
+  if (_observer)
+    _observer->allocated(category, size, caller);
+  return p;
+}
+
+void memory_budget::deallocate_for(memory_category category, void* p, std::size_t size, std::size_t alignment) noexcept
+{
+  if (!p)
+    return;
+
+  auto& usage = _usage[static_cast<std::size_t>(category)];
+  assert(usage.current >= size && _used >= size);
+  _upstream->deallocate(p, size, alignment);
+  usage.current -= size;
+  _used -= size;
+}
+
+void memory_budget::reset_high_water() noexcept
+{
+  _high_water = _used;
+  for (auto& usage : _usage)
+    usage.high_water = usage.current;
+}
+
+void* memory_budget::do_allocate(std::size_t size, std::size_t alignment)
+{
+  return resource(memory_category::buffer)->allocate(size, alignment);
+}
+
+void memory_budget::do_deallocate(void* p, std::size_t size, std::size_t alignment)
+{
+  deallocate_for(memory_category::buffer, p, size, alignment);
+}
+
+bool memory_budget::do_is_equal(const std::pmr::memory_resource& rhs) const noexcept
+{
+  return this == &rhs;
+}
+
+void* memory_budget::category_resource::do_allocate(std::size_t size, std::size_t alignment)
+{
+  if (auto* const p = budget->allocate_for(category, size, alignment))
+    return p;
+#if __cpp_exceptions
+  throw std::bad_alloc();
+#else
+  return nullptr;
+#endif
+}
+
+void memory_budget::category_resource::do_deallocate(void* p, std::size_t size, std::size_t alignment)
+{
+  budget->deallocate_for(category, p, size, alignment);
+}
+
+bool memory_budget::category_resource::do_is_equal(const std::pmr::memory_resource& rhs) const noexcept
+{
+  return this == &rhs;
+}
+
+void* detail::allocate_frame(std::size_t size, const void* caller) noexcept
+{
+  auto* const budget = memory_budget::current();
+  const auto total = size + sizeof(frame_header);
+  void* const p = budget
+    ? budget->allocate_for(memory_category::coroutine_frame, total, alignof(frame_header), caller)
+    : ::operator new(total, std::nothrow);
+  if (!p)
+    return nullptr;
+
+  return ::new (p) frame_header{budget} + 1;
+}
+
+void detail::deallocate_frame(void* frame, std::size_t size) noexcept
+{
+  auto* const header = static_cast<frame_header*>(frame) - 1;
+  const auto total = size + sizeof(frame_header);
+  if (auto* const budget = header->budget)
+    budget->deallocate_for(memory_category::coroutine_frame, header, total, alignof(frame_header));
+  else
+    ::operator delete(header, total);
+}
+}  // namespace olifilo
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/static_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace olifilo::detail
+{
+void* pool_allocate(std::byte* const storage, std::span<block_pool> pools, std::size_t size, std::size_t alignment) noexcept
+{
+  bool fits_some_class = false;
+  for (auto& pool : pools)
+  {
+    // every block is aligned to at least its own size's largest power of two divisor
+    if (pool.block_size < size || (pool.offset | pool.block_size) % alignment != 0)
+      continue;
+    fits_some_class = true;
+
+    void* block = nullptr;
+    if (pool.free_list)
+    {
+      block = std::exchange(pool.free_list, *static_cast<void**>(pool.free_list));
+    }
+    else if (pool.touched < pool.block_count)
+    {
+      block = storage + pool.offset + pool.touched * pool.block_size;
+      ++pool.touched;
+    }
+    else
+    {
+      // exhausted: fall back to a larger size class
+      ++pool.failures;
+      continue;
+    }
+
+    ++pool.in_use;
+    pool.high_water = std::max(pool.high_water, pool.in_use);
+    return block;
+  }
+
+  if (!fits_some_class && !pools.empty())
+    ++pools.back().failures;
+  return nullptr;
+}
+
+void pool_deallocate(std::byte* const storage, std::span<block_pool> pools, void* const p) noexcept
+{
+  if (!p)
+    return;
+
+  const auto offset = static_cast<std::size_t>(static_cast<std::byte*>(p) - storage);
+  const auto pool = std::ranges::find_if(pools, [offset] (const block_pool& pool) {
+      return pool.offset <= offset && offset < pool.offset + pool.block_size * pool.block_count;
+    });
+  assert(pool != pools.end() && (offset - pool->offset) % pool->block_size == 0 && "not a block from this pool");
+
+  *static_cast<void**>(p) = pool->free_list;
+  pool->free_list = p;
+  --pool->in_use;
+}
+}  // namespace olifilo::detail
@@ -5,67 +5,74 @@
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <span>
+#include <utility>
 
 #include <olifilo/io/poll.hpp>
+#include <olifilo/trace.hpp>
 
 namespace olifilo
 {
-future<std::size_t>
-  wait_t::operator()(
-    decltype(detail::promise_wait_callgraph::callees)&         promises
-  , until                                                const wait_until
-  , std::optional<std::chrono::steady_clock::time_point> const timeout
-  ) noexcept
+namespace
 {
-  // Special case because the code below assumes that .begin() + 1 and .end() - 1 are valid iterators.
-  if (promises.empty())
-    co_return {std::in_place, 0};
+// Placeholder that's safe for our executors while still occupying a slot to ensure a one-to-one mapping of positions in 'callees' and 'promises'.
+constinit const detail::promise_wait_callgraph nop_always_ready_promise;
+}  // anonymous namespace
 
-  auto& my_promise = co_await detail::current_promise();
+detail::wait_core::~wait_core()
+{
+  stop();
+}
 
-  // Placeholder that's safe for our executors while still occupying a slot to ensure a one-to-one mapping of positions in 'callees' and 'promises'.
-  static constinit const detail::promise_wait_callgraph nop_always_ready_promise;
+void detail::wait_core::stop() noexcept
+{
+  if (!std::exchange(_started, false))
+    return;
 
-  /*****************************************************************************************
-   * Prepare our own promise to be ready for the executor to find all events and resume us *
-   *****************************************************************************************/
+  trace::emit<trace::event::wait_end>(&_me_promise);
 
-  // Borrow input promises list as our own promise's callee list to avoid allocating
-  unsafe_swap(my_promise.callees, promises);
-  struct scope_exit
+  for (const auto& future : _me_promise.callees)
   {
-    decltype(my_promise.callees)& callees_;
-    decltype(promises)& futures_;
-    ~scope_exit()
-    {
-      unsafe_swap(callees_, futures_);
-
-      for (auto& future : futures_)
-      {
-        // Hide our NOP future from callers and restore the nullptr they gave us
-        if (future == &nop_always_ready_promise)
-          future = nullptr;
-        if (!future)
-          continue;
-
-        // Restore promises to being the top of their respective await call graphs with nothing waiting on them (anymore)
-        visit([] (auto callee) { callee->waits_on_me = nullptr; }, future);
-      }
-    }
-  } scope_exit(my_promise.callees, promises);
+    if (future == &nop_always_ready_promise)
+      continue;
 
-  constexpr auto ready = []<typename T>(this auto self, T future) noexcept {
-    if constexpr (std::is_pointer_v<T>)
-      return future->waits_on_me == nullptr;
-    else
-      return visit(self, future);
-  };
+    // Restore promises to being the top of their respective await call graphs with nothing waiting on them (anymore)
+    visit([] (auto callee) { callee->waits_on_me = nullptr; }, future);
+  }
 
-  assert(ready(&nop_always_ready_promise));
+  // Not our callees in the await_transform sense: our promise' destructor shouldn't touch them
+  _me_promise.callees.clear();
+}
+
+expected<void> detail::wait_core::start(
+    until                                                  const wait_until
+  , std::span<detail::promise_wait_callgraph* const>       const promises
+  , std::optional<wait_clock::time_point>                  const timeout
+  ) noexcept
+{
+  assert(!_started && "may only wait once");
+  assert(_me_promise.callees.empty() && "waiting promise shouldn't be awaiting anything else");
+
+  // Nothing to wait on: done without a timeout
+  _until = wait_until;
+  if (promises.empty())
+    return {};
+
+  /*****************************************************************************************
+   * Prepare our own promise to be ready for the executor to find all events and resume us *
+   *****************************************************************************************/
+
+  // 'promises' may live on our caller's stack: copy before we first suspend
+  if (auto r = _me_promise.callees.reserve(promises.size() + !!timeout, _me_promise.alloc);
+      !r)
+    return r;
+  for (const auto future : promises)
+    (void)_me_promise.callees.push_back(future, _me_promise.alloc);
+  _started = true;
 
   // Simulate promise.await_transform(promises)... We can't use co_await because it would wait on *all* promises (in order, one by one).
-  const auto me = std::coroutine_handle<std::remove_cvref_t<decltype(my_promise)>>::from_promise(my_promise);
-  for (auto& callee : my_promise.callees)
+  trace::emit<trace::event::wait_begin>(&_me_promise, _me_promise.callees.size(), wait_until);
+  for (auto& callee : _me_promise.callees)
   {
     assert(contains<detail::promise_wait_callgraph*>(callee));
     const auto future = get<detail::promise_wait_callgraph*>(callee);
@@ -81,53 +88,88 @@ future<std::size_t>
 
     assert(future->waits_on_me == nullptr && "internal logic error: not allowed to await promises already being awaited");
     assert(future->caller == nullptr && "stealing a future someone else is waiting on");
-    future->waits_on_me = me;
+    future->waits_on_me = _me;
+    trace::emit<trace::event::wait_edge>(&_me_promise, future);
   }
 
-  std::optional<detail::awaitable_poll> timeout_event;
   if (timeout)
   {
-    timeout_event.emplace(io::poll(*timeout));
-    timeout_event->waits_on_me = me;
+    _timeout_event.emplace(io::poll(*timeout));
+    _timeout_event->waits_on_me = _me;
 
-    if (auto r = my_promise.callees.push_back(&*timeout_event, my_promise.alloc);
+    if (auto r = _me_promise.callees.push_back(&*_timeout_event, _me_promise.alloc);
         !r)
-      co_return {unexpect, r.error()};
+      return r;
+  }
+
+  return {};
+}
+
+std::optional<expected<std::size_t>> detail::wait_core::poll() noexcept
+{
+  constexpr auto ready = []<typename T>(this auto self, T future) noexcept {
+    if constexpr (std::is_pointer_v<T>)
+      return future->waits_on_me == nullptr;
+    else
+      return visit(self, future);
+  };
+
+  assert(ready(&nop_always_ready_promise));
+
+  if (_timeout_event
+   && _timeout_event->waits_on_me == nullptr)
+  {
+    // Timeout occurred
+    assert(std::ranges::find(_me_promise.callees, &*_timeout_event) == _me_promise.callees.end() && "executor should have removed timeout event from our wait list");
+    stop();
+    return expected<std::size_t>(unexpect, _timeout_event->wait_result.error());
   }
 
   /***************************************************************************************************
-   * Scan the list of promises to see if enough are ready, suspend ourselves, detect timeout, repeat *
+   * Scan the list of promises to see if enough are ready, otherwise our coroutine suspends, repeat  *
    ***************************************************************************************************/
 
-  while (true)
+  bool all_ready = true;
+  for (auto callee = _me_promise.callees.begin(); callee != _me_promise.callees.end(); ++callee)
   {
-    bool all_ready = true;
-    for (auto callee = my_promise.callees.begin(); callee != my_promise.callees.end(); ++callee)
-    {
-      // Timeout gets removed from the list by the executor when it becomes ready
-      // Skip it to prevent it from setting all_ready to 'false'
-      if (*callee == &*timeout_event)
-        continue;
-
-      if (!ready(*callee))
-        all_ready = false;
-      else if (const auto index = static_cast<std::size_t>(callee - my_promise.callees.begin());
-          wait_until == until::first_completed)
-        co_return {std::in_place, index};
-    }
-    if (all_ready)
-      co_return {std::in_place, 0};
-
-    // Now allow this future's .get() to handle the actual I/O multiplexing
-    co_await std::suspend_always();
+    // Timeout gets removed from the list by the executor when it becomes ready
+    // Skip it to prevent it from setting all_ready to 'false'
+    if (_timeout_event && *callee == &*_timeout_event)
+      continue;
 
-    if (timeout_event
-     && timeout_event->waits_on_me == nullptr)
+    if (!ready(*callee))
+      all_ready = false;
+    else if (const auto index = static_cast<std::size_t>(callee - _me_promise.callees.begin());
+        _until == until::first_completed)
     {
-      // Timeout occurred
-      assert(std::ranges::find(my_promise.callees, &*timeout_event) == my_promise.callees.end() && "executor should have removed timeout event from our wait list");
-      co_return {unexpect, timeout_event->wait_result.error()};
+      stop();
+      return expected<std::size_t>(std::in_place, index);
     }
   }
+  if (all_ready)
+  {
+    stop();
+    return expected<std::size_t>(std::in_place, 0);
+  }
+
+  return std::nullopt;
+}
+
+future<std::size_t>
+  wait_t::operator()(
+    until                                                  const wait_until
+  , std::span<detail::promise_wait_callgraph* const>       const promises
+  , std::optional<clock::time_point>                       const timeout
+  ) noexcept
+{
+  auto& my_promise = co_await detail::current_promise();
+  detail::wait_core waiter(my_promise, std::coroutine_handle<std::remove_cvref_t<decltype(my_promise)>>::from_promise(my_promise));
+  if (auto r = waiter.start(wait_until, promises, timeout); !r)
+    co_return {unexpect, r.error()};
+
+  std::optional<expected<std::size_t>> r;
+  while (!(r = waiter.poll()))
+    co_await std::suspend_always();
+  co_return std::move(*r);
 }
 }  // namespace olifilo
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/acceptor.hpp>
+
+#include <limits>
+#include <system_error>
+
+#include <fcntl.h>
+
+#include <olifilo/errors.hpp>
+#include <olifilo/io/accept.hpp>
+#include <olifilo/io/bind.hpp>
+#include <olifilo/io/fcntl.hpp>
+#include <olifilo/io/listen.hpp>
+#include <olifilo/io/poll.hpp>
+#include <olifilo/io/sockopt.hpp>
+#include <olifilo/io/sockopts/socket.hpp>
+
+namespace olifilo::io
+{
+namespace
+{
+constexpr int accept_non_block = 0
+#if __linux__ || __FreeBSD__ || __NetBSD__ || __OpenBSD__
+  // Some OSs allow us to accept non-blocking sockets with a single syscall
+  | SOCK_NONBLOCK | SOCK_CLOEXEC
+#endif
+;
+
+expected<stream_socket> accept_non_blocking(file_descriptor_handle fd) noexcept
+{
+  return io::accept(fd, accept_non_block)
+    .transform([] (auto accepted) { return stream_socket(accepted); })
+    .and_then([] (auto sock) {
+      if constexpr (!accept_non_block)
+        return io::fcntl_get_file_status_flags(sock.handle())
+          .and_then([&] (auto flags) { return io::fcntl_set_file_status_flags(sock.handle(), flags | O_NONBLOCK); })
+          .transform([&] { return std::move(sock); })
+          ;
+      else
+        return expected<stream_socket>(std::move(sock));
+    })
+  ;
+}
+}  // anonymous namespace
+
+expected<acceptor> acceptor::create(const ::sockaddr* addr, std::size_t addrlen, int backlog) noexcept
+{
+  if (addrlen > static_cast<std::size_t>(std::numeric_limits<::socklen_t>::max()))
+    return {unexpect, make_error_code(std::errc::argument_out_of_domain)};
+
+  // stream_socket::create takes care of making it non-blocking
+  auto sock = stream_socket::create(addr->sa_family);
+  if (!sock)
+    return {unexpect, sock.error()};
+
+  acceptor rv(sock->release());
+  if (auto r = setsockopt<sol_socket::reuse_addr>(rv.handle(), 1); !r)
+    return {unexpect, r.error()};
+  if (auto r = io::bind(rv.handle(), addr, static_cast<::socklen_t>(addrlen)); !r)
+    return {unexpect, r.error()};
+  if (auto r = io::listen(rv.handle(), backlog); !r)
+    return {unexpect, r.error()};
+
+  return rv;
+}
+
+future<stream_socket> acceptor::accept(eagerness eager) noexcept
+{
+  const auto fd = handle();
+
+  if (eager == eagerness::eager)
+  {
+    if (auto rv = accept_non_blocking(fd); rv || rv.error() != condition::operation_not_ready)
+      co_return rv;
+  }
+
+  while (true)
+  {
+    if (auto wait = co_await io::poll(fd, io::poll::read); !wait)
+      co_return wait.error();
+
+    // Another acceptor on the same socket may have raced us to it
+    if (auto rv = accept_non_blocking(fd); rv || rv.error() != condition::operation_not_ready)
+      co_return rv;
+  }
+}
+}  // namespace olifilo::io
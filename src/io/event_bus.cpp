@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/event_bus.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <olifilo/coro/io/file_descriptor.hpp>
+#include <olifilo/io/poll.hpp>
+
+namespace olifilo::io
+{
+struct detail::event_queue
+{
+  using key = std::tuple<events::detail::event_base_t, std::int32_t>;
+
+  struct slot
+  {
+    event_subscription::header header;
+    std::size_t                size;
+  };
+
+  event_bus*                   bus = nullptr;
+  event_queue*                 next = nullptr;
+  // readable (i.e. non-zero) while events are queued
+  file_descriptor              notify;
+  std::unique_ptr<key[]>       events;
+  std::size_t                  event_count = 0;
+  std::size_t                  event_data_size = 0;
+  // every slot is a 'slot' followed by event_data_size bytes of payload
+  std::unique_ptr<std::byte[]> storage;
+  std::size_t                  slot_size = 0;
+  std::size_t                  capacity = 0;
+  std::size_t                  head = 0;
+  std::size_t                  count = 0;
+  std::uint64_t                dropped = 0;
+
+  bool subscribed_to(events::detail::event_base_t base, std::int32_t id) const noexcept
+  {
+    const std::span keys(events.get(), event_count);
+    return std::ranges::find(keys, key(base, id)) != keys.end();
+  }
+
+  slot& at(std::size_t i) noexcept
+  {
+    return *std::launder(reinterpret_cast<slot*>(&storage[(i % capacity) * slot_size]));
+  }
+
+  std::byte* payload(slot& s) noexcept
+  {
+    return reinterpret_cast<std::byte*>(&s + 1);
+  }
+};
+
+event_subscription::event_subscription() noexcept = default;
+event_subscription::event_subscription(event_subscription&& rhs) noexcept = default;
+
+event_subscription::event_subscription(std::unique_ptr<detail::event_queue> queue) noexcept
+  : _queue(std::move(queue))
+{
+}
+
+event_subscription& event_subscription::operator=(event_subscription&& rhs) noexcept
+{
+  if (&rhs != this)
+  {
+    unsubscribe();
+    _queue = std::move(rhs._queue);
+  }
+  return *this;
+}
+
+event_subscription::~event_subscription()
+{
+  unsubscribe();
+}
+
+void event_subscription::unsubscribe() noexcept
+{
+  if (!_queue)
+    return;
+
+  std::scoped_lock _(_queue->bus->_lock);
+  for (auto** q = &_queue->bus->_subscriptions; *q; q = &(*q)->next)
+  {
+    if (*q == _queue.get())
+    {
+      *q = _queue->next;
+      break;
+    }
+  }
+  _queue.reset();
+}
+
+future<std::span<std::byte>> event_subscription::receive(header& event, std::span<std::byte> payload) noexcept
+{
+  if (!_queue)
+    co_return make_error_code(std::errc::bad_file_descriptor);
+
+  auto& queue = *_queue;
+  while (true)
+  {
+    {
+      std::scoped_lock _(queue.bus->_lock);
+      if (queue.count)
+      {
+        auto& slot = queue.at(queue.head);
+        const auto size = std::min(slot.size, payload.size());
+        event = slot.header;
+        if (size)
+          std::memcpy(payload.data(), queue.payload(slot), size);
+        queue.head = (queue.head + 1) % queue.capacity;
+
+        // Keep the eventfd readable exactly while events are queued
+        if (--queue.count == 0)
+        {
+          std::uint64_t posted;
+          (void)::read(queue.notify.handle(), &posted, sizeof(posted));
+        }
+        co_return payload.first(size);
+      }
+    }
+
+    if (auto wait = co_await io::poll(queue.notify.handle(), io::poll::read); !wait)
+      co_return wait.error();
+  }
+}
+
+std::uint64_t event_subscription::dropped() const noexcept
+{
+  if (!_queue)
+    return 0;
+
+  std::scoped_lock _(_queue->bus->_lock);
+  return _queue->dropped;
+}
+
+event_bus::~event_bus()
+{
+  assert(_subscriptions == nullptr && "event_bus destroyed while some of its subscriptions still exist");
+}
+
+expected<event_subscription> event_bus::subscribe(
+    std::initializer_list<std::tuple<events::detail::event_base_t, std::int32_t>> events
+  , std::size_t event_data_size
+  , std::size_t queue_capacity
+  ) noexcept
+{
+  if (queue_capacity == 0)
+    return {unexpect, make_error_code(std::errc::invalid_argument)};
+
+  std::unique_ptr<detail::event_queue> queue(new (std::nothrow) detail::event_queue);
+  if (!queue)
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+
+  queue->bus = this;
+  queue->event_data_size = event_data_size;
+  queue->slot_size = (sizeof(detail::event_queue::slot) + event_data_size + alignof(std::max_align_t) - 1)
+    / alignof(std::max_align_t) * alignof(std::max_align_t);
+  queue->capacity = queue_capacity;
+
+  queue->events.reset(new (std::nothrow) detail::event_queue::key[events.size()]);
+  queue->storage.reset(new (std::nothrow) std::byte[queue->slot_size * queue->capacity]);
+  if (!queue->events || !queue->storage)
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+  std::ranges::copy(events, queue->events.get());
+  queue->event_count = events.size();
+  for (std::size_t i = 0; i < queue->capacity; ++i)
+    ::new (&queue->storage[i * queue->slot_size]) detail::event_queue::slot{};
+
+  if (file_descriptor_handle fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)); !fd)
+    return {unexpect, errno, std::system_category()};
+  else
+    queue->notify = file_descriptor(fd);
+
+  std::scoped_lock _(_lock);
+  queue->next = std::exchange(_subscriptions, queue.get());
+  return event_subscription(std::move(queue));
+}
+
+std::size_t event_bus::post(events::detail::event_base_t base, std::int32_t id, std::span<const std::byte> data) noexcept
+{
+  std::size_t queued = 0;
+  std::scoped_lock _(_lock);
+  for (auto* queue = _subscriptions; queue; queue = queue->next)
+  {
+    if (!queue->subscribed_to(base, id))
+      continue;
+
+    if (queue->count == queue->capacity)
+    {
+      ++queue->dropped;
+      continue;
+    }
+
+    auto& slot = queue->at(queue->head + queue->count);
+    slot.header = {base, id};
+    slot.size = std::min(data.size(), queue->event_data_size);
+    if (slot.size)
+      std::memcpy(queue->payload(slot), data.data(), slot.size);
+    ++queued;
+
+    if (queue->count++ == 0)
+    {
+      const std::uint64_t one = 1;
+      (void)::write(queue->notify.handle(), &one, sizeof(one));
+    }
+  }
+
+  return queued;
+}
+}  // namespace olifilo::io
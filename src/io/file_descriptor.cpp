@@ -1,59 +1,81 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#include <olifilo/coro/executor_stats.hpp>
 #include <olifilo/coro/io/file_descriptor.hpp>
 #include <olifilo/errors.hpp>
 #include <olifilo/io/read.hpp>
 #include <olifilo/io/write.hpp>
+#include <olifilo/trace.hpp>
 
 namespace olifilo::io
 {
 future<std::span<std::byte>> file_descriptor::read_some(std::span<std::byte> buf, eagerness eager) noexcept
 {
   const auto fd = handle();
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}(fd={}, buf=<size={}>)\n", ts(), __LINE__, "file_descriptor::read_some", fd, buf.size());
+  trace::emit<trace::event::fd_read_some>(fd, buf.size());
+
+  auto& stats = executor_statistics();
+  const auto cls = io_class();
 
   if (eager == eagerness::eager)
   {
-    if (auto rv = io::read_some(fd, buf);
-        rv || rv.error() != condition::operation_not_ready)
+    auto rv = io::read_some(fd, buf);
+    stats.add_eager_io(rv);
+    if (rv)
+      stats.add_bytes_read(cls, rv->size());
+    if (rv || rv.error() != condition::operation_not_ready)
       co_return rv;
   }
 
   co_return (
       co_await io::poll(fd, io::poll::read)
-    ).and_then([=] { return io::read_some(fd, buf); });
+    ).and_then([=] { return io::read_some(fd, buf); })
+     .transform([&stats, cls] (auto read) { stats.add_bytes_read(cls, read.size()); return read; });
 }
 
 future<std::span<const std::byte>> file_descriptor::write_some(std::span<const std::byte> buf, eagerness eager) noexcept
 {
   const auto fd = handle();
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}(fd={}, buf=<size={}>)\n", ts(), __LINE__, "file_descriptor::write_some", fd, buf.size());
+  trace::emit<trace::event::fd_write_some>(fd, buf.size());
+
+  auto& stats = executor_statistics();
+  const auto cls = io_class();
 
   if (eager == eagerness::eager)
   {
-    if (auto rv = io::write_some(fd, buf);
-        rv || rv.error() != condition::operation_not_ready)
+    auto rv = io::write_some(fd, buf);
+    stats.add_eager_io(rv);
+    if (rv)
+      stats.add_bytes_written(cls, buf.size() - rv->size());
+    if (rv || rv.error() != condition::operation_not_ready)
       co_return rv;
   }
 
   co_return (
       co_await io::poll(fd, io::poll::write)
-    ).and_then([=] { return io::write_some(fd, buf); });
+    ).and_then([=] { return io::write_some(fd, buf); })
+     .transform([&stats, cls, buf] (auto rest) { stats.add_bytes_written(cls, buf.size() - rest.size()); return rest; });
 }
 
 future<std::span<std::byte>> file_descriptor::read(std::span<std::byte> const buf, eagerness eager) noexcept
 {
   const auto fd = handle();
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}(fd={}, buf=<size={}>)\n", ts(), __LINE__, "file_descriptor::read", fd, buf.size());
+  trace::emit<trace::event::fd_read>(fd, buf.size());
   std::size_t read_so_far = 0;
+  auto& stats = executor_statistics();
+  const auto cls = io_class();
 
   if (eager == eagerness::eager)
   {
-    if (auto rv = io::read(fd, buf);
-        !rv && rv.error() != condition::operation_not_ready)
+    auto rv = io::read(fd, buf);
+    stats.add_eager_io(rv);
+    if (!rv && rv.error() != condition::operation_not_ready)
       co_return rv.error();
     else if (rv)
+    {
+      stats.add_bytes_read(cls, *rv);
       read_so_far += *rv;
+    }
   }
 
   while (read_so_far < buf.size())
@@ -66,7 +88,10 @@ future<std::span<std::byte>> file_descriptor::read(std::span<std::byte> const bu
     else if (*rv == 0) // HUP/EOF
       co_return buf.first(read_so_far);
     else
+    {
+      stats.add_bytes_read(cls, *rv);
       read_so_far += *rv;
+    }
   }
 
   co_return buf;
@@ -75,15 +100,22 @@ future<std::span<std::byte>> file_descriptor::read(std::span<std::byte> const bu
 future<void> file_descriptor::write(std::span<const std::byte> buf, eagerness eager) noexcept
 {
   const auto fd = handle();
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:128.128}(fd={}, buf=<size={}>)\n", ts(), __LINE__, "file_descriptor::write", fd, buf.size());
+  trace::emit<trace::event::fd_write>(fd, buf.size());
+
+  auto& stats = executor_statistics();
+  const auto cls = io_class();
 
   if (eager == eagerness::eager)
   {
-    if (auto rv = io::write_some(fd, buf);
-        !rv && rv.error() != condition::operation_not_ready)
+    auto rv = io::write_some(fd, buf);
+    stats.add_eager_io(rv);
+    if (!rv && rv.error() != condition::operation_not_ready)
       co_return rv;
     else if (rv)
+    {
+      stats.add_bytes_written(cls, buf.size() - rv->size());
       buf = *rv;
+    }
   }
 
   while (!buf.empty())
@@ -94,7 +126,10 @@ future<void> file_descriptor::write(std::span<const std::byte> buf, eagerness ea
     if (auto rv = io::write_some(fd, buf); !rv)
       co_return rv;
     else
+    {
+      stats.add_bytes_written(cls, buf.size() - rv->size());
       buf = *rv;
+    }
   }
 
   co_return {};
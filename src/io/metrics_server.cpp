@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/metrics_server.hpp>
+
+#include <cinttypes>
+#include <cstdio>
+#include <iterator>
+#include <new>
+#include <string_view>
+#include <system_error>
+
+#include <olifilo/errors.hpp>
+#include <olifilo/io/poll.hpp>
+#include <olifilo/io/read.hpp>
+#include <olifilo/io/sendmsg.hpp>
+
+namespace olifilo::io
+{
+namespace
+{
+using namespace std::literals::string_view_literals;
+
+// Whole line or nothing, like snprintf: >= out.size() when it doesn't fit
+template <typename... Args>
+int print(std::span<char> out, const char* format, Args... args) noexcept
+{
+  return std::snprintf(out.data(), out.size(), format, args...);
+}
+
+double seconds(std::chrono::nanoseconds d) noexcept
+{
+  return std::chrono::duration<double>(d).count();
+}
+
+struct family
+{
+  const char* name;
+  const char* type;
+  const char* help;
+  // amount of samples, no lines get rendered for families without samples
+  std::size_t (*samples)(const metrics_snapshot&) noexcept;
+  int (*sample)(const metrics_snapshot&, const char* name, std::size_t i, std::span<char> out) noexcept;
+};
+
+std::size_t executor_samples(const metrics_snapshot& s) noexcept { return s.executor ? 1 : 0; }
+std::size_t mqtt_samples(const metrics_snapshot& s) noexcept { return s.mqtt ? 1 : 0; }
+std::size_t tcp_samples(const metrics_snapshot& s) noexcept { return s.tcp.size(); }
+
+template <auto Member>
+constexpr family executor_value(const char* name, const char* type, const char* help) noexcept
+{
+  return {name, type, help, executor_samples,
+    [] (const metrics_snapshot& s, const char* name, std::size_t, std::span<char> out) noexcept {
+      return print(out, "%s %" PRIu64 "\n", name, static_cast<std::uint64_t>((*s.executor).*Member));
+    }};
+}
+
+template <auto Member>
+constexpr family mqtt_value(const char* name, const char* help) noexcept
+{
+  return {name, "counter", help, mqtt_samples,
+    [] (const metrics_snapshot& s, const char* name, std::size_t, std::span<char> out) noexcept {
+      return print(out, "%s %" PRIu64 "\n", name, static_cast<std::uint64_t>((*s.mqtt).*Member));
+    }};
+}
+
+// duration_histogram's quantiles followed by how many durations it recorded
+template <auto Snapshot, auto P50, auto P99, auto Max, auto Count>
+constexpr family summary(const char* name, const char* help) noexcept
+{
+  return {name, "summary", help, [] (const metrics_snapshot& s) noexcept -> std::size_t { return (s.*Snapshot) ? 4 : 0; },
+    [] (const metrics_snapshot& s, const char* name, std::size_t i, std::span<char> out) noexcept {
+      const auto& stats = *(s.*Snapshot);
+      if (i == 3)
+        return print(out, "%s_count %" PRIu64 "\n", name, static_cast<std::uint64_t>(stats.*Count));
+
+      constexpr const char* quantiles[] = {"0.5", "0.99", "1"};
+      const auto value = i == 0 ? stats.*P50 : i == 1 ? stats.*P99 : stats.*Max;
+      return print(out, "%s{quantile=\"%s\"} %.9f\n", name, quantiles[i], seconds(value));
+    }};
+}
+
+// Endpoint names come from peer_name(): addresses, which never need escaping in label values
+template <auto Member>
+constexpr family tcp_value(const char* name, const char* type, const char* help) noexcept
+{
+  return {name, type, help, tcp_samples,
+    [] (const metrics_snapshot& s, const char* name, std::size_t i, std::span<char> out) noexcept {
+      const auto& [endpoint, metrics] = s.tcp[i];
+      const auto value = metrics.*Member;
+      if constexpr (requires { value.count(); })
+        return print(out, "%s{endpoint=\"%s\"} %.6f\n", name, endpoint.c_str(), seconds(value));
+      else
+        return print(out, "%s{endpoint=\"%s\"} %" PRIu64 "\n", name, endpoint.c_str(), static_cast<std::uint64_t>(value));
+    }};
+}
+
+constexpr const char* fd_class_names[fd_class_count] = {"other", "socket", "regular_file"};
+
+constexpr family families[] = {
+  executor_value<&executor_stats_snapshot::loop_iterations>("olifilo_executor_loop_iterations_total", "counter", "Executor loop iterations"),
+  {"olifilo_executor_blocked_seconds_total", "counter", "Time the executor spent blocked waiting for events", executor_samples,
+    [] (const metrics_snapshot& s, const char* name, std::size_t, std::span<char> out) noexcept {
+      return print(out, "%s %.9f\n", name, seconds(s.executor->blocked_time));
+    }},
+  executor_value<&executor_stats_snapshot::fds_registered>("olifilo_executor_fds_registered", "gauge", "File descriptor waits in the most recent executor iteration"),
+  executor_value<&executor_stats_snapshot::handlers_resumed>("olifilo_executor_handlers_resumed_total", "counter", "Coroutines resumed by the executor"),
+  executor_value<&executor_stats_snapshot::max_handlers_resumed_per_iteration>("olifilo_executor_max_handlers_resumed_per_iteration", "gauge", "Most coroutines resumed by a single executor iteration"),
+  executor_value<&executor_stats_snapshot::timers_armed>("olifilo_executor_timers_armed_total", "counter", "Timeouts registered with the executor"),
+  executor_value<&executor_stats_snapshot::timers_expired>("olifilo_executor_timers_expired_total", "counter", "Timeouts that expired"),
+  {"olifilo_executor_eager_io_total", "counter", "Eager I/O attempts by result", [] (const metrics_snapshot& s) noexcept -> std::size_t { return s.executor ? 3 : 0; },
+    [] (const metrics_snapshot& s, const char* name, std::size_t i, std::span<char> out) noexcept {
+      constexpr const char* results[] = {"completed", "would_block", "failed"};
+      const std::uint64_t counts[] = {s.executor->eager_io_completed, s.executor->eager_io_would_block, s.executor->eager_io_failed};
+      return print(out, "%s{result=\"%s\"} %" PRIu64 "\n", name, results[i], counts[i]);
+    }},
+  {"olifilo_executor_read_bytes_total", "counter", "Bytes read by kind of file descriptor", [] (const metrics_snapshot& s) noexcept -> std::size_t { return s.executor ? fd_class_count : 0; },
+    [] (const metrics_snapshot& s, const char* name, std::size_t i, std::span<char> out) noexcept {
+      return print(out, "%s{class=\"%s\"} %" PRIu64 "\n", name, fd_class_names[i], s.executor->bytes_read[i]);
+    }},
+  {"olifilo_executor_written_bytes_total", "counter", "Bytes written by kind of file descriptor", [] (const metrics_snapshot& s) noexcept -> std::size_t { return s.executor ? fd_class_count : 0; },
+    [] (const metrics_snapshot& s, const char* name, std::size_t i, std::span<char> out) noexcept {
+      return print(out, "%s{class=\"%s\"} %" PRIu64 "\n", name, fd_class_names[i], s.executor->bytes_written[i]);
+    }},
+  summary<&metrics_snapshot::executor
+        , &executor_stats_snapshot::resume_delay_p50
+        , &executor_stats_snapshot::resume_delay_p99
+        , &executor_stats_snapshot::resume_delay_max
+        , &executor_stats_snapshot::resume_delay_samples
+        >("olifilo_executor_resume_delay_seconds", "Delay between the executor observing an event and resuming its waiter"),
+
+  mqtt_value<&mqtt_stats_snapshot::connects_attempted>("olifilo_mqtt_connects_total", "MQTT connection attempts"),
+  mqtt_value<&mqtt_stats_snapshot::connects_succeeded>("olifilo_mqtt_connects_succeeded_total", "MQTT connections that got accepted by the broker"),
+  mqtt_value<&mqtt_stats_snapshot::pings_sent>("olifilo_mqtt_pings_total", "PINGREQ packets sent"),
+  mqtt_value<&mqtt_stats_snapshot::pings_answered>("olifilo_mqtt_pings_answered_total", "PINGRESP packets received"),
+  summary<&metrics_snapshot::mqtt
+        , &mqtt_stats_snapshot::ping_rtt_p50
+        , &mqtt_stats_snapshot::ping_rtt_p99
+        , &mqtt_stats_snapshot::ping_rtt_max
+        , &mqtt_stats_snapshot::ping_rtt_samples
+        >("olifilo_mqtt_ping_rtt_seconds", "PINGREQ to PINGRESP round trip time"),
+
+  tcp_value<&tcp_endpoint_metrics::connections>("olifilo_tcp_connections_total", "counter", "Sampled connections per peer"),
+  tcp_value<&tcp_endpoint_metrics::samples>("olifilo_tcp_samples_total", "counter", "TCP_INFO samples per peer"),
+  tcp_value<&tcp_endpoint_metrics::rtt_last>("olifilo_tcp_rtt_seconds", "gauge", "Most recent smoothed round trip time"),
+  tcp_value<&tcp_endpoint_metrics::rtt_min>("olifilo_tcp_rtt_min_seconds", "gauge", "Lowest sampled smoothed round trip time"),
+  tcp_value<&tcp_endpoint_metrics::rtt_max>("olifilo_tcp_rtt_max_seconds", "gauge", "Highest sampled smoothed round trip time"),
+  {"olifilo_tcp_rtt_mean_seconds", "gauge", "Mean of the sampled smoothed round trip times", tcp_samples,
+    [] (const metrics_snapshot& s, const char* name, std::size_t i, std::span<char> out) noexcept {
+      return print(out, "%s{endpoint=\"%s\"} %.6f\n", name, s.tcp[i].first.c_str(), seconds(s.tcp[i].second.rtt_mean()));
+    }},
+  tcp_value<&tcp_endpoint_metrics::rtt_variance_last>("olifilo_tcp_rtt_variance_seconds", "gauge", "Most recent round trip time variance"),
+  tcp_value<&tcp_endpoint_metrics::retransmits>("olifilo_tcp_retransmits_total", "counter", "Retransmitted segments"),
+  tcp_value<&tcp_endpoint_metrics::congestion_window_last>("olifilo_tcp_congestion_window_segments", "gauge", "Most recent congestion window"),
+  tcp_value<&tcp_endpoint_metrics::congestion_window_min>("olifilo_tcp_congestion_window_min_segments", "gauge", "Smallest sampled congestion window"),
+  tcp_value<&tcp_endpoint_metrics::unacked_last>("olifilo_tcp_unacked_segments", "gauge", "Most recent amount of unacknowledged segments"),
+  tcp_value<&tcp_endpoint_metrics::unacked_max>("olifilo_tcp_unacked_max_segments", "gauge", "Most unacknowledged segments sampled"),
+};
+
+future<void> send_all(file_descriptor_handle fd, std::span<const std::byte> buf, executor_clock::time_point deadline) noexcept
+{
+  while (!buf.empty())
+  {
+    // Always wait first: gives other coroutines a turn between two chunks
+    if (auto wait = co_await io::poll(fd, io::poll::write, deadline); !wait)
+      co_return wait;
+
+    const std::span<const std::byte> bufs[] = {buf};
+    if (auto rv = io::sendmsg(fd, bufs, MSG_DONTWAIT | MSG_NOSIGNAL); !rv && rv.error() != condition::operation_not_ready)
+      co_return rv.error();
+    else if (rv)
+      buf = buf.subspan(*rv);
+  }
+
+  co_return {};
+}
+}  // anonymous namespace
+
+expected<prometheus_renderer> prometheus_renderer::create(const metrics_sources& sources) noexcept
+{
+  metrics_snapshot snapshot;
+  if (sources.executor)
+    snapshot.executor = executor_statistics().snapshot();
+  if (sources.mqtt)
+    snapshot.mqtt = mqtt_statistics().snapshot();
+  if (sources.tcp)
+  {
+#if __cpp_exceptions
+    try
+#endif
+    {
+      snapshot.tcp = sources.tcp->snapshot();
+    }
+#if __cpp_exceptions
+    catch (const std::bad_alloc&)
+    {
+      return {unexpect, make_error_code(std::errc::not_enough_memory)};
+    }
+#endif
+  }
+
+  return prometheus_renderer(std::move(snapshot));
+}
+
+bool prometheus_renderer::done() const noexcept
+{
+  return _family >= std::size(families);
+}
+
+std::span<const char> prometheus_renderer::render(std::span<char> buf) noexcept
+{
+  std::size_t used = 0;
+  while (!done())
+  {
+    const auto& f = families[_family];
+    const auto samples = f.samples(_snapshot);
+    if (_line >= samples + 2 || samples == 0)
+    {
+      ++_family;
+      _line = 0;
+      continue;
+    }
+
+    const auto out = buf.subspan(used);
+    const int len =
+        _line == 0 ? print(out, "# HELP %s %s\n", f.name, f.help)
+      : _line == 1 ? print(out, "# TYPE %s %s\n", f.name, f.type)
+      : f.sample(_snapshot, f.name, _line - 2, out);
+
+    if (len >= 0 && static_cast<std::size_t>(len) < out.size())
+      used += static_cast<std::size_t>(len);
+    else if (used != 0)
+      // continue with this line in the next chunk
+      break;
+    // else: doesn't even fit in an empty buffer: skip it
+
+    ++_line;
+  }
+
+  return buf.first(used);
+}
+
+expected<metrics_server> metrics_server::create(const ::sockaddr* addr, std::size_t addrlen, metrics_sources sources) noexcept
+{
+  auto listener = acceptor::create(addr, addrlen);
+  if (!listener)
+    return {unexpect, listener.error()};
+  return metrics_server(std::move(*listener), sources);
+}
+
+future<void> metrics_server::serve() noexcept
+{
+  while (true)
+  {
+    auto client = co_await _listener.accept();
+    if (!client && (client.error() == std::errc::connection_aborted || client.error() == condition::operation_not_ready))
+      continue;
+    else if (!client)
+      co_return client.error();
+
+    (void)co_await serve_client(std::move(*client));
+  }
+}
+
+future<void> metrics_server::serve_client(stream_socket client) noexcept
+{
+  const auto fd = client.handle();
+  const auto deadline = executor_clock::now() + client_timeout;
+
+  // Only the request line matters, but read up to the end of the headers before responding
+  char request[1024];
+  std::size_t received = 0;
+  while (!std::string_view(request, received).contains("\r\n\r\n"sv))
+  {
+    if (received == sizeof(request))
+      co_return make_error_code(std::errc::message_size);
+
+    if (auto wait = co_await io::poll(fd, io::poll::read, deadline); !wait)
+      co_return wait;
+
+    if (auto rv = io::read_some(fd, as_writable_bytes(std::span(request).subspan(received))); !rv && rv.error() != condition::operation_not_ready)
+      co_return rv.error();
+    else if (rv && rv->empty())
+      co_return make_error_code(std::errc::connection_reset);
+    else if (rv)
+      received += rv->size();
+  }
+
+  const std::string_view request_line(request, std::string_view(request, received).find("\r\n"));
+  if (!request_line.starts_with("GET /metrics "sv) && !request_line.starts_with("GET /metrics?"sv))
+  {
+    constexpr auto not_found = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"sv;
+    co_return co_await send_all(fd, as_bytes(std::span(not_found)), deadline);
+  }
+
+  auto renderer = prometheus_renderer::create(_sources);
+  if (!renderer)
+  {
+    constexpr auto unavailable = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"sv;
+    co_return co_await send_all(fd, as_bytes(std::span(unavailable)), deadline);
+  }
+
+  constexpr auto header =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Connection: close\r\n"
+    "\r\n"sv;
+  if (auto r = co_await send_all(fd, as_bytes(std::span(header)), deadline); !r)
+    co_return r;
+
+  // Chunk: hex size, CRLF, data, CRLF. The size gets formatted right in front of the data.
+  constexpr std::size_t size_room = 8 + 2;
+  char chunk[4096];
+  while (!renderer->done())
+  {
+    const auto data = renderer->render(std::span(chunk).subspan(size_room, sizeof(chunk) - size_room - 2));
+    if (data.empty())
+      continue;
+
+    char size[size_room + 1];
+    const auto size_len = static_cast<std::size_t>(std::snprintf(size, sizeof(size), "%zx\r\n", data.size()));
+    char* const start = chunk + size_room - size_len;
+    std::copy_n(size, size_len, start);
+    chunk[size_room + data.size()] = '\r';
+    chunk[size_room + data.size() + 1] = '\n';
+
+    if (auto r = co_await send_all(fd, as_bytes(std::span(start, size_len + data.size() + 2)), deadline); !r)
+      co_return r;
+  }
+
+  constexpr auto last_chunk = "0\r\n\r\n"sv;
+  if (auto r = co_await send_all(fd, as_bytes(std::span(last_chunk)), deadline); !r)
+    co_return r;
+
+  co_return client.shutdown(shutdown_how::write);
+}
+}  // namespace olifilo::io
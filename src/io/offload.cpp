@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "offload.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace olifilo::io::detail
+{
+namespace
+{
+class offload_pool
+{
+  public:
+    ~offload_pool()
+    {
+      {
+        std::scoped_lock _(lock);
+        for (auto& worker : workers)
+          worker.request_stop();
+      }
+      wakeup.notify_all();
+    }
+
+    expected<void> submit(offload_job& job) noexcept
+    {
+      {
+        std::scoped_lock _(lock);
+        if (auto r = start_workers(); !r)
+          return r;
+
+        job.next = nullptr;
+        *queue_tail = &job;
+        queue_tail = &job.next;
+      }
+      wakeup.notify_one();
+      return {};
+    }
+
+    void cancel(offload_job& job) noexcept
+    {
+      std::unique_lock l(lock);
+      for (auto i = &queue_head; *i; i = &(*i)->next)
+      {
+        if (*i != &job)
+          continue;
+
+        // Not picked up by a worker yet: no token will be produced for it
+        *i = job.next;
+        if (queue_tail == &job.next)
+          queue_tail = i;
+        return;
+      }
+
+      finished.wait(l, [&job] { return job.done.load(std::memory_order_acquire); });
+      l.unlock();
+
+      // Consume the token for this job to keep the count in the eventfd balanced
+      std::uint64_t token;
+      (void)::read(job.notify, &token, sizeof(token));
+    }
+
+  private:
+    expected<void> start_workers() noexcept
+    {
+      if (!workers.empty())
+        return {};
+
+      const auto count = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+#if __cpp_exceptions
+      try
+#endif
+      {
+        workers.reserve(count);
+        for (unsigned i = 0; i < count; ++i)
+          workers.emplace_back([this] (std::stop_token stop) { run(stop); });
+      }
+#if __cpp_exceptions
+      catch (const std::bad_alloc&)
+      {
+        return {unexpect, make_error_code(std::errc::not_enough_memory)};
+      }
+      catch (const std::system_error& exc)
+      {
+        if (workers.empty())
+          return {unexpect, exc.code()};
+      }
+#endif
+
+      return {};
+    }
+
+    void run(std::stop_token stop) noexcept
+    {
+      while (true)
+      {
+        offload_job* job;
+        {
+          std::unique_lock l(lock);
+          if (!wakeup.wait(l, stop, [this] { return queue_head != nullptr; }))
+            return;
+
+          job = std::exchange(queue_head, queue_head->next);
+          if (!queue_head)
+            queue_tail = &queue_head;
+        }
+
+        execute(*job);
+
+        const std::uint64_t token = 1;
+        (void)::write(job->notify, &token, sizeof(token));
+        {
+          // Under the lock to prevent cancel() from missing this notification
+          std::scoped_lock _(lock);
+          job->done.store(true, std::memory_order_release);
+        }
+        finished.notify_all();
+      }
+    }
+
+    static void execute(offload_job& job) noexcept
+    {
+      using enum offload_job::operation;
+
+      switch (job.op)
+      {
+        case pread:
+          job.result = ::pread(job.fd, job.data, job.size, job.offset);
+          break;
+        case pwrite:
+          job.result = ::pwrite(job.fd, job.data, job.size, job.offset);
+          break;
+        case fsync:
+          job.result = ::fsync(job.fd);
+          break;
+        case fdatasync:
+          job.result = ::fdatasync(job.fd);
+          break;
+      }
+
+      job.error = job.result == -1 ? errno : 0;
+    }
+
+    std::mutex                  lock;
+    std::condition_variable_any wakeup;
+    std::condition_variable     finished;
+    offload_job*                queue_head = nullptr;
+    offload_job**               queue_tail = &queue_head;
+    // declared last: stopping and joining the workers needs the members above
+    std::vector<std::jthread>   workers;
+};
+
+offload_pool pool;
+}  // anonymous namespace
+
+expected<void> offload_submit(offload_job& job) noexcept
+{
+  return pool.submit(job);
+}
+
+void offload_cancel(offload_job& job) noexcept
+{
+  pool.cancel(job);
+}
+}  // namespace olifilo::io::detail
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include <sys/types.h>
+
+#include <olifilo/expected.hpp>
+#include <olifilo/io/types.hpp>
+
+namespace olifilo::io::detail
+{
+// Blocking system call executed on a worker thread instead of the executor's thread.
+// Lives in the frame of the coroutine waiting for it: submitting doesn't allocate.
+struct offload_job
+{
+  enum class operation
+  {
+    pread,
+    pwrite,
+    fsync,
+    fdatasync,
+  };
+
+  operation              op;
+  file_descriptor_handle fd;
+  void*                  data   = nullptr;
+  std::size_t            size   = 0;
+  ::off_t                offset = 0;
+
+  // eventfd (in semaphore mode) that gets a single token written to it for every completed job
+  file_descriptor_handle notify;
+
+  ::ssize_t              result = -1;
+  int                    error  = 0;
+  // only set *after* the token has been written to 'notify'
+  std::atomic<bool>      done   = false;
+
+  offload_job*           next   = nullptr;
+};
+
+expected<void> offload_submit(offload_job& job) noexcept;
+
+// Ensures the pool no longer references 'job'. Blocks if it's currently executing.
+void offload_cancel(offload_job& job) noexcept;
+}  // namespace olifilo::io::detail
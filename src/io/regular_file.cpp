@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/regular_file.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <limits>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <olifilo/coro/executor_stats.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include "offload.hpp"
+
+namespace olifilo::io
+{
+namespace
+{
+future<std::size_t> offload(detail::offload_job::operation op, file_descriptor_handle fd, file_descriptor_handle completion, void* data = nullptr, std::size_t size = 0, ::off_t offset = 0) noexcept
+{
+  detail::offload_job job{
+    .op = op,
+    .fd = fd,
+    .data = data,
+    .size = size,
+    .offset = offset,
+    .notify = completion,
+  };
+
+  if (auto r = detail::offload_submit(job); !r)
+    co_return r.error();
+
+  struct scope_exit
+  {
+    detail::offload_job& job;
+    bool consumed = false;
+    ~scope_exit()
+    {
+      // Only when we're destroyed early: ensure the pool doesn't touch our frame anymore and our token gets consumed
+      if (!consumed)
+        detail::offload_cancel(job);
+    }
+  } guard(job);
+
+  // Multiple operations may share 'completion'. Every one of them consumes exactly one token, but only
+  // after observing its own completion. The token is written before 'done' gets set, so there always
+  // is one to take and the count can't drift.
+  while (!job.done.load(std::memory_order_acquire))
+  {
+    if (auto wait = co_await io::poll(completion, io::poll::read); !wait)
+      co_return wait.error();
+  }
+
+  std::uint64_t token;
+  if (::read(completion, &token, sizeof(token)) == -1)
+    co_return std::error_code(errno, std::system_category());
+  guard.consumed = true;
+
+  if (job.result == -1)
+    co_return std::error_code(job.error, std::system_category());
+  co_return static_cast<std::size_t>(job.result);
+}
+}  // anonymous namespace
+
+expected<regular_file> regular_file::open(const char* path, int flags, ::mode_t mode) noexcept
+{
+  file_descriptor file(file_descriptor_handle(::open(path, flags | O_CLOEXEC, mode)));
+  if (!file)
+    return {unexpect, errno, std::system_category()};
+
+  file_descriptor completion(file_descriptor_handle(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE)));
+  if (!completion)
+    return {unexpect, errno, std::system_category()};
+
+  return regular_file(file.release(), completion.release());
+}
+
+future<std::span<std::byte>> regular_file::pread(std::span<std::byte> const buf, ::off_t offset) noexcept
+{
+  std::size_t read_so_far = 0;
+  while (read_so_far < buf.size())
+  {
+    const auto rest = buf.subspan(read_so_far);
+    if (auto rv = co_await offload(detail::offload_job::operation::pread, handle(), _completion.handle(), rest.data(), rest.size(), offset); !rv)
+      co_return rv.error();
+    else if (*rv == 0) // EOF
+      break;
+    else
+    {
+      executor_statistics().add_bytes_read(fd_class::regular_file, *rv);
+      read_so_far += *rv;
+      offset += static_cast<::off_t>(*rv);
+    }
+  }
+
+  co_return buf.first(read_so_far);
+}
+
+future<void> regular_file::pwrite(std::span<const std::byte> buf, ::off_t offset) noexcept
+{
+  while (!buf.empty())
+  {
+    if (auto rv = co_await offload(detail::offload_job::operation::pwrite, handle(), _completion.handle(), const_cast<std::byte*>(buf.data()), buf.size(), offset); !rv)
+      co_return rv.error();
+    else
+    {
+      executor_statistics().add_bytes_written(fd_class::regular_file, *rv);
+      buf = buf.subspan(*rv);
+      offset += static_cast<::off_t>(*rv);
+    }
+  }
+
+  co_return {};
+}
+
+future<void> regular_file::fsync() noexcept
+{
+  if (auto rv = co_await offload(detail::offload_job::operation::fsync, handle(), _completion.handle()); !rv)
+    co_return rv.error();
+  co_return {};
+}
+
+future<void> regular_file::fdatasync() noexcept
+{
+  if (auto rv = co_await offload(detail::offload_job::operation::fdatasync, handle(), _completion.handle()); !rv)
+    co_return rv.error();
+  co_return {};
+}
+}  // namespace olifilo::io
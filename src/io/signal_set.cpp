@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/signal_set.hpp>
+
+#include <cerrno>
+#include <span>
+#include <system_error>
+
+#include <pthread.h>
+#include <sys/signalfd.h>
+
+#include <olifilo/errors.hpp>
+#include <olifilo/io/poll.hpp>
+#include <olifilo/io/read.hpp>
+
+namespace olifilo::io
+{
+expected<signal_set> signal_set::create(std::initializer_list<int> signals) noexcept
+{
+  ::sigset_t mask;
+  ::sigemptyset(&mask);
+  for (const auto signo : signals)
+    if (::sigaddset(&mask, signo) == -1)
+      return {unexpect, errno, std::system_category()};
+
+  ::sigset_t old_mask;
+  if (const auto err = ::pthread_sigmask(SIG_BLOCK, &mask, &old_mask); err != 0)
+    return {unexpect, err, std::system_category()};
+
+  if (file_descriptor_handle fd(::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)); !fd)
+  {
+    // Nothing to receive them through: don't leave them blocked
+    const auto err = errno;
+    ::pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    return {unexpect, err, std::system_category()};
+  }
+  else
+  {
+    return signal_set(fd);
+  }
+}
+
+future<int> signal_set::next() noexcept
+{
+  const auto fd = handle();
+  ::signalfd_siginfo info;
+  const auto buf = as_writable_bytes(std::span(&info, 1));
+
+  while (true)
+  {
+    if (auto rv = io::read(fd, buf); rv && *rv == sizeof(info))
+      co_return static_cast<int>(info.ssi_signo);
+    else if (rv)
+      co_return make_error_code(std::errc::message_size);
+    else if (rv.error() != condition::operation_not_ready)
+      co_return rv.error();
+
+    if (auto wait = co_await io::poll(fd, io::poll::read); !wait)
+      co_return wait.error();
+  }
+}
+}  // namespace olifilo::io
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/simulated_link.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <new>
+#include <optional>
+#include <random>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/errors.hpp>
+#include <olifilo/io/clock.hpp>
+#include <olifilo/io/poll.hpp>
+#include <olifilo/io/read.hpp>
+#include <olifilo/io/sendmsg.hpp>
+#include <olifilo/io/shutdown.hpp>
+
+namespace olifilo::io
+{
+namespace
+{
+struct segment
+{
+  executor_clock::time_point deliver_at;
+  std::vector<std::byte>     data;
+  std::size_t                delivered = 0;
+};
+
+bool peer_gone(const std::error_code& error) noexcept
+{
+  return error == std::errc::broken_pipe
+      || error == std::errc::connection_reset;
+}
+
+// Moves data from 'from' to 'to', in segments that get delayed as 'conditions' describes
+future<void> carry(file_descriptor_handle from, file_descriptor_handle to, link_conditions conditions, link_statistics& stats) noexcept
+{
+  std::mt19937_64 rng(conditions.seed);
+  std::bernoulli_distribution lose(conditions.loss);
+  std::bernoulli_distribution reorder(conditions.reorder);
+  std::uniform_int_distribution<std::chrono::nanoseconds::rep> jitter(0, conditions.jitter.count());
+
+  std::deque<segment> in_flight;
+  std::size_t in_flight_bytes = 0;
+  // when the link is done serializing the previous segment, and when that one gets delivered
+  executor_clock::time_point link_free{};
+  executor_clock::time_point last_delivery{};
+  bool sender_open = true;
+
+  while (sender_open || !in_flight.empty())
+  {
+    if (!in_flight.empty() && in_flight.front().deliver_at <= executor_clock::now())
+    {
+      auto& seg = in_flight.front();
+      const std::span<const std::byte> bufs[] = {std::span(seg.data).subspan(seg.delivered)};
+      if (auto rv = io::sendmsg(to, bufs, MSG_DONTWAIT | MSG_NOSIGNAL); !rv && rv.error() == condition::operation_not_ready)
+      {
+        // Receiver isn't reading: back pressure towards the sender, just like a full receive window
+        if (auto wait = co_await io::poll(to, io::poll::write); !wait)
+          co_return wait;
+      }
+      else if (!rv && peer_gone(rv.error()))
+      {
+        // Nobody left to deliver to
+        co_return {};
+      }
+      else if (!rv)
+      {
+        co_return rv.error();
+      }
+      else if ((seg.delivered += *rv) == seg.data.size())
+      {
+        in_flight_bytes -= seg.data.size();
+        in_flight.pop_front();
+      }
+      continue;
+    }
+
+    const auto next_delivery = in_flight.empty() ? std::nullopt : std::optional(in_flight.front().deliver_at);
+    if (!sender_open || in_flight_bytes >= conditions.window)
+    {
+      if (auto wait = co_await io::poll(*next_delivery); !wait && wait.error() != std::errc::timed_out)
+        co_return wait;
+      continue;
+    }
+
+    if (auto wait = co_await (next_delivery ? io::poll(from, io::poll::read, *next_delivery) : io::poll(from, io::poll::read));
+        !wait && wait.error() == std::errc::timed_out)
+      continue;
+    else if (!wait)
+      co_return wait;
+
+    segment seg;
+#if __cpp_exceptions
+    try
+#endif
+    {
+      seg.data.resize(std::min(conditions.segment_size, conditions.window - in_flight_bytes));
+    }
+#if __cpp_exceptions
+    catch (const std::bad_alloc&)
+    {
+      co_return make_error_code(std::errc::not_enough_memory);
+    }
+#endif
+
+    const auto rv = io::read_some(from, seg.data);
+    if (!rv && rv.error() == condition::operation_not_ready)
+      continue;
+    else if (!rv && !peer_gone(rv.error()))
+      co_return rv.error();
+    else if (!rv || rv->empty())
+    {
+      sender_open = false;
+      continue;
+    }
+    seg.data.resize(rv->size());
+
+    // Serialization, propagation and jitter
+    const auto now = executor_clock::now();
+    link_free = std::max(now, link_free);
+    if (conditions.bytes_per_second)
+      link_free += std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(seg.data.size() * 1'000'000'000ULL / conditions.bytes_per_second));
+    auto arrival = link_free + conditions.latency + std::chrono::nanoseconds(jitter(rng));
+
+    while (lose(rng))
+    {
+      arrival += conditions.retransmit_timeout;
+      ++stats.lost;
+    }
+    if (reorder(rng))
+    {
+      arrival += conditions.reorder_delay;
+      ++stats.reordered;
+    }
+
+    // A stream delivers in order: whatever arrives early waits for the segments in front of it
+    seg.deliver_at = last_delivery = std::max(arrival, last_delivery);
+    ++stats.segments;
+    stats.bytes += seg.data.size();
+    in_flight_bytes += seg.data.size();
+
+#if __cpp_exceptions
+    try
+#endif
+    {
+      in_flight.push_back(std::move(seg));
+    }
+#if __cpp_exceptions
+    catch (const std::bad_alloc&)
+    {
+      co_return make_error_code(std::errc::not_enough_memory);
+    }
+#endif
+  }
+
+  // Everything got delivered and the sender is done: pass that on
+  if (auto r = io::shutdown(to, shutdown_how::write); !r && !peer_gone(r.error()) && r.error() != std::errc::not_connected)
+    co_return r;
+  co_return {};
+}
+
+bool valid(const link_conditions& conditions) noexcept
+{
+  // a certain loss would retransmit forever
+  return 0 <= conditions.loss && conditions.loss < 1
+      && 0 <= conditions.reorder && conditions.reorder <= 1
+      && conditions.latency >= conditions.latency.zero()
+      && conditions.jitter >= conditions.jitter.zero()
+      && conditions.segment_size != 0
+      && conditions.window != 0;
+}
+}  // anonymous namespace
+
+expected<simulated_link> simulated_link::create(const link_conditions& a_to_b, const link_conditions& b_to_a) noexcept
+{
+  if (!valid(a_to_b) || !valid(b_to_a))
+    return {unexpect, make_error_code(std::errc::invalid_argument)};
+
+  simulated_link link;
+  link._a_to_b = a_to_b;
+  link._b_to_a = b_to_a;
+
+  for (auto [outer, inner] : {std::pair{&link.a, &link._a_inner}, std::pair{&link.b, &link._b_inner}})
+  {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == -1)
+      return {unexpect, errno, std::system_category()};
+    *outer = stream_socket(file_descriptor_handle(fds[0]));
+    *inner = stream_socket(file_descriptor_handle(fds[1]));
+  }
+
+  // Different seeds for both directions when both got the same conditions
+  if (link._b_to_a.seed == link._a_to_b.seed)
+    link._b_to_a.seed = ~link._b_to_a.seed;
+
+  return link;
+}
+
+future<void> simulated_link::run() noexcept
+{
+  auto directions = co_await when_all(
+      carry(_a_inner.handle(), _b_inner.handle(), _a_to_b, _a_to_b_stats)
+    , carry(_b_inner.handle(), _a_inner.handle(), _b_to_a, _b_to_a_stats)
+    );
+  if (!directions)
+    co_return directions.error();
+
+  auto& [a_to_b, b_to_a] = *directions;
+  if (!a_to_b)
+    co_return a_to_b;
+  co_return b_to_a;
+}
+}  // namespace olifilo::io
@@ -2,6 +2,8 @@
 
 #include <olifilo/coro/io/socket_descriptor.hpp>
 
+#include <olifilo/coro/executor_stats.hpp>
+
 #include <olifilo/io/sendmsg.hpp>
 #include <olifilo/io/write.hpp>
 
@@ -14,14 +16,20 @@ future<void> socket_descriptor::send(
 {
   const auto fd = handle();
 
+  auto& stats = executor_statistics();
+
   size_t sent = 0;
   if (eager == eagerness::eager)
   {
-    if (auto rv = sendmsg(fd, bufs, MSG_DONTWAIT);
-        !rv && rv.error() != condition::operation_not_ready)
+    auto rv = sendmsg(fd, bufs, MSG_DONTWAIT);
+    stats.add_eager_io(rv);
+    if (!rv && rv.error() != condition::operation_not_ready)
       co_return {olifilo::unexpect, rv.error()};
-    else
+    else if (rv)
+    {
+      stats.add_bytes_written(io_class(), *rv);
       sent = *rv;
+    }
   }
 
   while (!bufs.empty())
@@ -45,14 +53,20 @@ future<void> socket_descriptor::send(
       if (auto rv = io::write(fd, bufs.front().subspan(sent)); !rv)
         co_return {olifilo::unexpect, rv.error()};
       else
+      {
+        stats.add_bytes_written(io_class(), *rv);
         sent += *rv;
+      }
       continue;
     }
 
     if (auto rv = sendmsg(fd, bufs, MSG_DONTWAIT); !rv)
       co_return {olifilo::unexpect, rv.error()};
     else
+    {
+      stats.add_bytes_written(io_class(), *rv);
       sent += *rv;
+    }
   }
 
   co_return {};
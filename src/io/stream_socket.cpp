@@ -8,6 +8,7 @@
 #include <olifilo/io/socket.hpp>
 #include <olifilo/io/sockopt.hpp>
 #include <olifilo/io/sockopts/socket.hpp>
+#include <olifilo/trace.hpp>
 
 #include <netdb.h>
 
@@ -15,7 +16,7 @@ namespace olifilo::io
 {
 expected<stream_socket> stream_socket::create(int domain, int protocol) noexcept
 {
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:.128}\n", ts(), __LINE__, "stream_socket::create");
+  trace::emit<trace::event::socket_create>(domain, protocol);
 
   constexpr int sock_open_non_block = 0
 #if __linux__ || __FreeBSD__ || __NetBSD__ || __OpenBSD__
@@ -40,7 +41,7 @@ expected<stream_socket> stream_socket::create(int domain, int protocol) noexcept
 
 future<void> stream_socket::connect(const ::sockaddr* addr, std::size_t addrlen) noexcept
 {
-  ////std::format_to(std::ostreambuf_iterator(std::cout), "{:>7} {:4}: {:.128}\n", ts(), __LINE__, "stream_socket::connect");
+  trace::emit<trace::event::socket_connect>(handle());
 
   if (addrlen > static_cast<std::size_t>(std::numeric_limits<::socklen_t>::max()))
     co_return make_error_code(std::errc::argument_out_of_domain);
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/tcp_metrics.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <new>
+#include <optional>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <olifilo/coro/interval.hpp>
+#include <olifilo/io/sockopt.hpp>
+
+namespace olifilo::io
+{
+expected<void> tcp_metrics::record(std::string_view endpoint, const tcp_connection_info& info, std::uint32_t new_retransmits, bool first_sample) noexcept
+{
+  std::scoped_lock _(_lock);
+
+  auto entry = _endpoints.find(endpoint);
+  if (entry == _endpoints.end())
+  {
+#if __cpp_exceptions
+    try
+#endif
+    {
+      entry = _endpoints.emplace(endpoint, tcp_endpoint_metrics{}).first;
+    }
+#if __cpp_exceptions
+    catch (const std::bad_alloc&)
+    {
+      return {unexpect, make_error_code(std::errc::not_enough_memory)};
+    }
+#endif
+  }
+
+  auto& metrics = entry->second;
+  if (first_sample)
+    ++metrics.connections;
+  ++metrics.samples;
+  metrics.rtt_last = info.rtt;
+  metrics.rtt_min = std::min(metrics.rtt_min, info.rtt);
+  metrics.rtt_max = std::max(metrics.rtt_max, info.rtt);
+  metrics.rtt_sum += info.rtt;
+  metrics.rtt_variance_last = info.rtt_variance;
+  metrics.retransmits += new_retransmits;
+  metrics.congestion_window_last = info.congestion_window;
+  metrics.congestion_window_min = std::min(metrics.congestion_window_min, info.congestion_window);
+  metrics.unacked_last = info.unacked;
+  metrics.unacked_max = std::max(metrics.unacked_max, info.unacked);
+  metrics.lost_max = std::max(metrics.lost_max, info.lost);
+  return {};
+}
+
+std::vector<std::pair<std::string, tcp_endpoint_metrics>> tcp_metrics::snapshot() const
+{
+  std::scoped_lock _(_lock);
+  return {_endpoints.begin(), _endpoints.end()};
+}
+
+void tcp_metrics::reset() noexcept
+{
+  std::scoped_lock _(_lock);
+  _endpoints.clear();
+}
+
+expected<std::string> peer_name(file_descriptor_handle fd) noexcept
+{
+  ::sockaddr_storage addr;
+  auto addrlen = static_cast<::socklen_t>(sizeof(addr));
+  if (::getpeername(fd, reinterpret_cast<::sockaddr*>(&addr), &addrlen) == -1)
+    return {unexpect, errno, std::system_category()};
+
+  char name[INET6_ADDRSTRLEN + 8];
+  switch (addr.ss_family)
+  {
+    case AF_INET:
+    {
+      const auto& in = reinterpret_cast<const ::sockaddr_in&>(addr);
+      char host[INET_ADDRSTRLEN];
+      ::inet_ntop(AF_INET, &in.sin_addr, host, sizeof(host));
+      std::snprintf(name, sizeof(name), "%s:%u", host, static_cast<unsigned>(ntohs(in.sin_port)));
+      break;
+    }
+    case AF_INET6:
+    {
+      const auto& in6 = reinterpret_cast<const ::sockaddr_in6&>(addr);
+      char host[INET6_ADDRSTRLEN];
+      ::inet_ntop(AF_INET6, &in6.sin6_addr, host, sizeof(host));
+      std::snprintf(name, sizeof(name), "[%s]:%u", host, static_cast<unsigned>(ntohs(in6.sin6_port)));
+      break;
+    }
+    case AF_UNIX:
+    {
+      const auto& un = reinterpret_cast<const ::sockaddr_un&>(addr);
+      const std::size_t path_len = addrlen > offsetof(::sockaddr_un, sun_path) ? addrlen - offsetof(::sockaddr_un, sun_path) : 0;
+      std::snprintf(name, sizeof(name), "unix:%.*s", static_cast<int>(std::min(path_len, sizeof(name) - 6)), un.sun_path);
+      break;
+    }
+    default:
+      return {unexpect, make_error_code(std::errc::address_family_not_supported)};
+  }
+
+#if __cpp_exceptions
+  try
+#endif
+  {
+    return std::string(name);
+  }
+#if __cpp_exceptions
+  catch (const std::bad_alloc&)
+  {
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+  }
+#endif
+}
+
+future<void> sample_tcp_info(const stream_socket& socket, tcp_metrics& metrics, std::chrono::milliseconds period) noexcept
+{
+  const auto endpoint = peer_name(socket.handle());
+  if (!endpoint)
+    co_return endpoint.error();
+
+  olifilo::interval ticks(period);
+  std::optional<std::uint32_t> last_retransmits;
+  while (true)
+  {
+    const auto info = getsockopt<sol_ip_tcp::info>(socket.handle());
+    if (!info)
+      co_return info.error();
+
+    const auto new_retransmits = info->total_retransmits - last_retransmits.value_or(0);
+    if (auto r = metrics.record(*endpoint, *info, new_retransmits, !last_retransmits); !r)
+      co_return r;
+    last_retransmits = info->total_retransmits;
+
+    if (info->state == TCP_CLOSE)
+      co_return {};
+
+    if (auto tick = co_await ticks.tick(); !tick)
+      co_return tick.error();
+  }
+}
+}  // namespace olifilo::io
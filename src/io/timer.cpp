@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/timer.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <span>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/timerfd.h>
+
+#include <olifilo/errors.hpp>
+#include <olifilo/io/read.hpp>
+
+namespace olifilo::io
+{
+namespace
+{
+// On Linux steady_clock is CLOCK_MONOTONIC, so its epoch is the same as the one TFD_TIMER_ABSTIME uses
+static_assert(std::is_same_v<timer::clock, std::chrono::steady_clock>);
+
+constexpr ::timespec to_timespec(timer::clock::duration time) noexcept
+{
+  const auto secs = std::chrono::duration_cast<std::chrono::seconds>(time);
+  return {
+    .tv_sec = static_cast<decltype(::timespec::tv_sec)>(secs.count()),
+    .tv_nsec = static_cast<decltype(::timespec::tv_nsec)>(std::chrono::duration_cast<std::chrono::nanoseconds>(time - secs).count()),
+  };
+}
+}  // anonymous namespace
+
+expected<timer> timer::create() noexcept
+{
+  if (file_descriptor_handle fd(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)); !fd)
+    return {unexpect, errno, std::system_category()};
+  else
+    return timer(fd);
+}
+
+expected<void> timer::arm(clock::time_point deadline, clock::duration period) noexcept
+{
+  const ::itimerspec spec{
+    .it_interval = to_timespec(period),
+    .it_value = to_timespec(deadline.time_since_epoch()),
+  };
+
+  // a zero it_value would disarm instead
+  if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+    return {unexpect, make_error_code(std::errc::invalid_argument)};
+
+  if (::timerfd_settime(handle(), TFD_TIMER_ABSTIME, &spec, nullptr) == -1)
+    return {unexpect, errno, std::system_category()};
+  return {};
+}
+
+expected<void> timer::disarm() noexcept
+{
+  const ::itimerspec spec{};
+  if (::timerfd_settime(handle(), 0, &spec, nullptr) == -1)
+    return {unexpect, errno, std::system_category()};
+  return {};
+}
+
+future<std::uint64_t> timer::wait() noexcept
+{
+  const auto fd = handle();
+  std::uint64_t expirations;
+  const auto buf = as_writable_bytes(std::span(&expirations, 1));
+
+  while (true)
+  {
+    if (auto rv = io::read(fd, buf); rv && *rv == sizeof(expirations))
+      co_return expirations;
+    else if (rv)
+      co_return make_error_code(std::errc::message_size);
+    else if (rv.error() != condition::operation_not_ready)
+      co_return rv.error();
+
+    if (auto wait = co_await io::poll(fd, io::poll::read); !wait)
+      co_return wait.error();
+  }
+}
+}  // namespace olifilo::io
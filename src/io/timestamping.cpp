@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/timestamping.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <olifilo/coro/executor_stats.hpp>
+#include <olifilo/errors.hpp>
+#include <olifilo/io/poll.hpp>
+#include <olifilo/io/recvmsg.hpp>
+
+namespace olifilo::io
+{
+namespace
+{
+// SCM_TIMESTAMPING + an IP(V6)_RECVERR with the peer's address and some room for others (e.g. SCM_TIMESTAMPING_PKTINFO)
+constexpr std::size_t control_size = CMSG_SPACE(sizeof(::scm_timestamping)) + CMSG_SPACE(sizeof(::sock_extended_err) + sizeof(::sockaddr_in6)) + 64;
+
+std::chrono::nanoseconds to_duration(const ::timespec& ts) noexcept
+{
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+template <typename F>
+void for_each_cmsg(std::span<const std::byte> control, F&& f) noexcept
+{
+  ::msghdr msg{};
+  msg.msg_control = const_cast<std::byte*>(control.data());
+  msg.msg_controllen = control.size();
+  for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    f(*cmsg, std::span(reinterpret_cast<const std::byte*>(CMSG_DATA(cmsg)), cmsg->cmsg_len - CMSG_LEN(0)));
+}
+}  // anonymous namespace
+
+kernel_timestamps parse_timestamps(std::span<const std::byte> control) noexcept
+{
+  kernel_timestamps rv;
+  for_each_cmsg(control, [&rv] (const ::cmsghdr& cmsg, std::span<const std::byte> data) {
+      if (cmsg.cmsg_level != SOL_SOCKET || cmsg.cmsg_type != SCM_TIMESTAMPING || data.size() < sizeof(::scm_timestamping))
+        return;
+
+      ::scm_timestamping ts;
+      std::memcpy(&ts, data.data(), sizeof(ts));
+      // [0] = software, [1] = deprecated, [2] = raw hardware. Unset ones are zero.
+      if (ts.ts[0].tv_sec || ts.ts[0].tv_nsec)
+        rv.software.emplace(std::chrono::duration_cast<std::chrono::system_clock::duration>(to_duration(ts.ts[0])));
+      if (ts.ts[2].tv_sec || ts.ts[2].tv_nsec)
+        rv.hardware.emplace(to_duration(ts.ts[2]));
+    });
+  return rv;
+}
+
+future<timestamped_read> read_some_timestamped(const socket_descriptor& socket, std::span<std::byte> buf, eagerness eager) noexcept
+{
+  const auto fd = socket.handle();
+  auto& stats = executor_statistics();
+  alignas(::cmsghdr) std::byte control[control_size];
+  const std::span<std::byte> bufs[] = {buf};
+
+  if (eager == eagerness::lazy)
+  {
+    if (auto wait = co_await io::poll(fd, io::poll::read); !wait)
+      co_return wait.error();
+  }
+
+  while (true)
+  {
+    auto rv = io::recvmsg(fd, bufs, control, MSG_DONTWAIT);
+    if (eager == eagerness::eager)
+    {
+      stats.add_eager_io(rv);
+      eager = eagerness::lazy;
+    }
+
+    if (rv)
+    {
+      stats.add_bytes_read(fd_class::socket, rv->size);
+      co_return timestamped_read{
+        .data = buf.first(rv->size),
+        .timestamps = parse_timestamps(rv->control),
+      };
+    }
+    else if (rv.error() != condition::operation_not_ready)
+      co_return rv.error();
+
+    if (auto wait = co_await io::poll(fd, io::poll::read); !wait)
+      co_return wait.error();
+  }
+}
+
+expected<std::optional<tx_timestamp>> read_tx_timestamp(const socket_descriptor& socket) noexcept
+{
+  alignas(::cmsghdr) std::byte control[control_size];
+  // Without timestamping::timestamp_only the kernel loops the sent packet back: we don't need it
+  std::byte payload[1];
+  const std::span<std::byte> bufs[] = {payload};
+
+  while (true)
+  {
+    auto rv = io::recvmsg(socket.handle(), bufs, control, MSG_ERRQUEUE | MSG_DONTWAIT);
+    if (!rv && rv.error() == condition::operation_not_ready)
+      return std::nullopt;
+    else if (!rv)
+      return {unexpect, rv.error()};
+
+    std::optional<tx_timestamp> ts;
+    for_each_cmsg(rv->control, [&ts] (const ::cmsghdr& cmsg, std::span<const std::byte> data) {
+        if (!((cmsg.cmsg_level == SOL_IP && cmsg.cmsg_type == IP_RECVERR)
+           || (cmsg.cmsg_level == SOL_IPV6 && cmsg.cmsg_type == IPV6_RECVERR))
+         || data.size() < sizeof(::sock_extended_err))
+          return;
+
+        ::sock_extended_err err;
+        std::memcpy(&err, data.data(), sizeof(err));
+        if (err.ee_errno != ENOMSG || err.ee_origin != SO_EE_ORIGIN_TIMESTAMPING)
+          return;
+
+        ts.emplace(tx_timestamp{
+          .stage = static_cast<tx_stage>(err.ee_info),
+          .id = err.ee_data,
+          .timestamps = {},
+        });
+      });
+
+    // Other entries on the error queue (e.g. ICMP errors) aren't ours to report
+    if (!ts)
+      continue;
+
+    ts->timestamps = parse_timestamps(rv->control);
+    return ts;
+  }
+}
+}  // namespace olifilo::io
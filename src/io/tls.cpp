@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/tls.hpp>
+
+#include <cerrno>
+#include <limits>
+#include <memory>
+
+#include <olifilo/io/poll.hpp>
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+namespace olifilo::io
+{
+const char* tls_error_category_t::name() const noexcept
+{
+  return "TLS-error";
+}
+
+std::string tls_error_category_t::message(int ev) const
+{
+  using enum tls_error;
+
+  switch (static_cast<tls_error>(ev))
+  {
+    case handshake_failed:
+      return "TLS handshake failed";
+    case certificate_verify_failed:
+      return "peer certificate verification failed";
+    case ktls_unavailable:
+      return "kernel TLS offload unavailable for this connection";
+    case invalid_certificate:
+      return "invalid certificate";
+  }
+
+  return "(unrecognized error)";
+}
+
+void tls_context::deleter::operator()(::ssl_ctx_st* ctx) const noexcept
+{
+  ::SSL_CTX_free(ctx);
+}
+
+expected<tls_context> tls_context::create_client(verify verify_mode) noexcept
+{
+  tls_context ctx(::SSL_CTX_new(::TLS_client_method()));
+  if (!ctx._ctx)
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+
+  const auto native = ctx.native_handle();
+  ::SSL_CTX_set_options(native, SSL_OP_ENABLE_KTLS | SSL_OP_NO_RENEGOTIATION | SSL_OP_NO_COMPRESSION);
+  ::SSL_CTX_set_verify(native, verify_mode == verify::none ? SSL_VERIFY_NONE : SSL_VERIFY_PEER, nullptr);
+
+  // TLS 1.3 servers send post-handshake messages (NewSessionTicket, KeyUpdate) after the handshake.
+  // The kernel delivers those as non-application-data records, failing plain read()/recv() with EIO.
+  // Only TLS 1.2 keeps the socket usable with the existing send/read/write calls.
+  if (!::SSL_CTX_set_min_proto_version(native, TLS1_2_VERSION)
+   || !::SSL_CTX_set_max_proto_version(native, TLS1_2_VERSION))
+    return {unexpect, make_error_code(tls_error::handshake_failed)};
+
+  // Only offer AEAD ciphers the kernel can take over
+  if (!::SSL_CTX_set_cipher_list(native, "ECDHE+AESGCM:ECDHE+CHACHA20"))
+    return {unexpect, make_error_code(tls_error::handshake_failed)};
+
+  return ctx;
+}
+
+expected<void> tls_context::use_default_verify_paths() noexcept
+{
+  if (!::SSL_CTX_set_default_verify_paths(native_handle()))
+    return {unexpect, make_error_code(tls_error::invalid_certificate)};
+  return {};
+}
+
+expected<void> tls_context::add_trust_anchor(std::string_view pem) noexcept
+{
+  if (pem.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    return {unexpect, make_error_code(std::errc::argument_out_of_domain)};
+
+  std::unique_ptr<::BIO, decltype(&::BIO_free)> bio(::BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size())), &::BIO_free);
+  if (!bio)
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+
+  ::X509_STORE* const store = ::SSL_CTX_get_cert_store(native_handle());
+  std::size_t count = 0;
+  while (std::unique_ptr<::X509, decltype(&::X509_free)> cert{::PEM_read_bio_X509(bio.get(), nullptr, nullptr, nullptr), &::X509_free})
+  {
+    if (!::X509_STORE_add_cert(store, cert.get()))
+      return {unexpect, make_error_code(tls_error::invalid_certificate)};
+    ++count;
+  }
+
+  // Reading until the end of the PEM data leaves a 'no start line' error behind
+  ::ERR_clear_error();
+
+  if (!count)
+    return {unexpect, make_error_code(tls_error::invalid_certificate)};
+  return {};
+}
+
+future<void> start_ktls(stream_socket& sock, const tls_context& ctx, const char* server_name) noexcept
+{
+  const auto fd = sock.handle();
+
+  // Owns the handshake state only: once the kernel has taken over the record layer this can go away.
+  // Freeing it doesn't touch the socket: SSL_set_fd doesn't transfer ownership of the fd.
+  std::unique_ptr<::SSL, decltype(&::SSL_free)> ssl(::SSL_new(ctx.native_handle()), &::SSL_free);
+  if (!ssl)
+    co_return make_error_code(std::errc::not_enough_memory);
+
+  if (!::SSL_set_fd(ssl.get(), fd))
+    co_return make_error_code(tls_error::handshake_failed);
+
+  if (server_name)
+  {
+    if (!::SSL_set_tlsext_host_name(ssl.get(), server_name))
+      co_return make_error_code(tls_error::handshake_failed);
+    if (::SSL_CTX_get_verify_mode(ctx.native_handle()) != SSL_VERIFY_NONE
+     && !::SSL_set1_host(ssl.get(), server_name))
+      co_return make_error_code(tls_error::handshake_failed);
+  }
+
+  while (true)
+  {
+    ::ERR_clear_error();
+    const auto rv = ::SSL_connect(ssl.get());
+    if (rv == 1)
+      break;
+
+    auto wait_for = io::poll::read;
+    switch (::SSL_get_error(ssl.get(), rv))
+    {
+      case SSL_ERROR_WANT_READ:
+        break;
+      case SSL_ERROR_WANT_WRITE:
+        wait_for = io::poll::write;
+        break;
+      case SSL_ERROR_SYSCALL:
+        if (errno)
+          co_return std::error_code(errno, std::system_category());
+        co_return make_error_code(std::errc::connection_aborted);
+      default:
+        if (::SSL_get_verify_result(ssl.get()) != X509_V_OK)
+          co_return make_error_code(tls_error::certificate_verify_failed);
+        co_return make_error_code(tls_error::handshake_failed);
+    }
+
+    if (auto wait = co_await io::poll(fd, wait_for); !wait)
+      co_return wait;
+  }
+
+  if (!BIO_get_ktls_send(::SSL_get_wbio(ssl.get()))
+   || !BIO_get_ktls_recv(::SSL_get_rbio(ssl.get())))
+    co_return make_error_code(tls_error::ktls_unavailable);
+
+  co_return {};
+}
+}  // namespace olifilo::io
@@ -3,11 +3,14 @@
 #include <olifilo/mqtt.hpp>
 
 #include <olifilo/coro/wait.hpp>
+#include <olifilo/io/clock.hpp>
 #include <olifilo/io/sockopt.hpp>
 #include <olifilo/io/sockopts/socket.hpp>
 #include <olifilo/io/sockopts/tcp.hpp>
 #include <olifilo/mqtt/errors.hpp>
+#include <olifilo/mqtt/stats.hpp>
 
+#include <chrono>
 #include <iterator>
 
 #include <netdb.h>
@@ -16,6 +19,8 @@ namespace olifilo::io
 {
 namespace
 {
+mqtt_stats stats;
+
 template <typename Out>
   requires(std::output_iterator<Out, std::byte>
         || std::output_iterator<Out, std::uint8_t>)
@@ -35,6 +40,11 @@ constexpr Out serialize_remaining_length(Out out, std::uint32_t value)
 }
 }  // anonymous namespace
 
+mqtt_stats& mqtt_statistics() noexcept
+{
+  return stats;
+}
+
 const char* mqtt_error_category_t::name() const noexcept
 {
   return "MQTT-error";
@@ -68,8 +78,9 @@ future<mqtt> mqtt::connect(
   , std::optional<std::string_view> username
   , std::optional<std::string_view> password) noexcept
 {
-  mqtt con;
-  con.keep_alive = decltype(con.keep_alive)(con.keep_alive.count() << (id & 1));
+  stats.add_connect_attempt();
+
+  mqtt con(id);
   {
     char portstr[6];
     if (auto status = std::to_chars(std::begin(portstr), std::end(portstr) - 1, port);
@@ -132,6 +143,28 @@ future<mqtt> mqtt::connect(
     }
   }
 
+  co_return co_await handshake(std::move(con), id, username, password);
+}
+
+future<mqtt> mqtt::connect(
+    stream_socket                   sock
+  , std::uint8_t                    id
+  , std::optional<std::string_view> username
+  , std::optional<std::string_view> password) noexcept
+{
+  stats.add_connect_attempt();
+
+  mqtt con(id);
+  con._sock = std::move(sock);
+  return handshake(std::move(con), id, username, password);
+}
+
+future<mqtt> mqtt::handshake(
+    mqtt                            con
+  , std::uint8_t                    id
+  , std::optional<std::string_view> username
+  , std::optional<std::string_view> password) noexcept
+{
   // TCP: start sending keep-alive probes after two keep-alive periods have expired without any packets received.
   //      Killing the connection after sol_ip_tcp::keep_alive_count probes have failed to receive a reply.
   (void)setsockopt<sol_ip_tcp::keep_alive_idle>(con._sock.handle(), con.keep_alive * 2);
@@ -230,6 +263,7 @@ future<mqtt> mqtt::connect(
   if (connect_return_code)
     co_return connect_return_code;
 
+  stats.add_connect_succeeded();
   co_return con;
 }
 
@@ -265,6 +299,10 @@ future<void> mqtt::ping() noexcept
     0,
   };
 
+  // executor_clock: reports the simulated round trip when running on a simulated_link in virtual time
+  const auto start = executor_clock::now();
+  stats.add_ping_sent();
+
   // send PINGREQ command
   if (auto r = co_await this->_sock.write(as_bytes(std::span(ping_pkt)));
       !r)
@@ -283,6 +321,7 @@ future<void> mqtt::ping() noexcept
   if (static_cast<std::uint8_t>((*ack_pkt)[1]) != 0) // variable length header portion must be empty
     co_return std::make_error_code(std::errc::bad_message);
 
+  stats.add_ping_answered(executor_clock::now() - start);
   co_return {};
 }
 }  // namespace olifilo::io
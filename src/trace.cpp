@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/trace.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+#include <new>
+#include <span>
+#include <system_error>
+
+#include <olifilo/io/write.hpp>
+
+namespace olifilo::trace
+{
+namespace
+{
+std::mutex     registry_lock;
+detail::ring*  registry = nullptr;
+std::uint32_t  thread_count = 0;
+
+// Unregisters and frees the ring on thread exit
+struct ring_owner
+{
+  detail::ring* ring = nullptr;
+
+  ~ring_owner()
+  {
+    if (!ring)
+      return;
+
+    {
+      std::scoped_lock _(registry_lock);
+      for (auto i = &registry; *i; i = &(*i)->next)
+      {
+        if (*i == ring)
+        {
+          *i = ring->next;
+          break;
+        }
+      }
+    }
+    detail::current_ring = nullptr;
+    delete ring;
+  }
+};
+
+thread_local ring_owner owner;
+}  // anonymous namespace
+
+detail::ring* detail::register_thread() noexcept
+{
+  auto* const ring = new (std::nothrow) detail::ring;
+  if (!ring)
+    return nullptr;
+
+  {
+    std::scoped_lock _(registry_lock);
+    ring->thread = thread_count++;
+    ring->next = registry;
+    registry = ring;
+  }
+
+  owner.ring = ring;
+  return current_ring = ring;
+}
+
+std::vector<record> snapshot()
+{
+  std::vector<record> records;
+
+  std::scoped_lock _(registry_lock);
+  for (auto ring = registry; ring; ring = ring->next)
+  {
+    const auto head = std::atomic_ref(ring->head).load(std::memory_order_acquire);
+    const auto count = std::min<std::uint64_t>(head, buffer_records);
+    records.reserve(records.size() + count);
+    for (auto i = head - count; i != head; ++i)
+      records.push_back(ring->records[i & (buffer_records - 1)]);
+  }
+
+  return records;
+}
+
+expected<void> dump(io::file_descriptor_handle fd) noexcept
+{
+  std::vector<record> records;
+#if __cpp_exceptions
+  try
+#endif
+  {
+    records = snapshot();
+  }
+#if __cpp_exceptions
+  catch (const std::bad_alloc&)
+  {
+    return {unexpect, make_error_code(std::errc::not_enough_memory)};
+  }
+#endif
+
+  file_header header;
+  header.record_count = records.size();
+  if (auto r = io::write_all(fd, as_bytes(std::span(&header, 1))); !r)
+    return r;
+  return io::write_all(fd, as_bytes(std::span(records)));
+}
+}  // namespace olifilo::trace
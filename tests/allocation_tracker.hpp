@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+/**
+ * Test harness counting allocations per coroutine, so tests can pin down what hot paths allocate.
+ *
+ * Include from exactly one translation unit of a test executable: it replaces the global operator
+ * new. Coroutine frames are only seen with OLIFILO_MEMORY_BUDGET. Naming coroutines requires their
+ * symbols to be exported, i.e. link with ENABLE_EXPORTS (-rdynamic).
+ */
+
+#include <olifilo/coro/async_profiler.hpp>
+#include <olifilo/coro/async_stack.hpp>
+#include <olifilo/coro/memory_budget.hpp>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace olifilo::test
+{
+struct allocation_counts
+{
+  std::size_t frames = 0;
+  std::size_t callee_lists = 0;
+  // from the global heap, or from a memory_budget's buffer and queue resources
+  std::size_t buffers = 0;
+  std::size_t bytes = 0;
+
+  allocation_counts& operator+=(const allocation_counts& rhs) noexcept
+  {
+    frames += rhs.frames;
+    callee_lists += rhs.callee_lists;
+    buffers += rhs.buffers;
+    bytes += rhs.bytes;
+    return *this;
+  }
+};
+
+class allocation_tracker;
+
+namespace detail
+{
+constinit inline thread_local allocation_tracker* this_thread_allocation_tracker = nullptr;
+}  // namespace detail
+
+/**
+ * Counts the allocations made on this thread while in scope, per coroutine function:
+ *  - coroutine frames are attributed to the coroutine they belong to
+ *  - everything else to the innermost coroutine the executor resumed, see current_async_stack(), or
+ *    to "[no coroutine]" outside of those
+ *
+ * Installs a memory_budget without limit, so every coroutine started while in scope should be done
+ * before this goes out of scope.
+ */
+class allocation_tracker final : private allocation_observer
+{
+  public:
+    // Distinct coroutines counted separately, the rest gets lumped together as "[other]"
+    static constexpr std::size_t max_functions = 256;
+
+    allocation_tracker() noexcept
+      : _previous(detail::this_thread_allocation_tracker)
+    {
+      _budget.observe(this);
+      detail::this_thread_allocation_tracker = this;
+    }
+
+    ~allocation_tracker()
+    {
+      detail::this_thread_allocation_tracker = _previous;
+      _budget.observe(nullptr);
+    }
+
+    allocation_tracker(const allocation_tracker&) = delete;
+    allocation_tracker& operator=(const allocation_tracker&) = delete;
+
+    static allocation_tracker* current() noexcept
+    {
+      return detail::this_thread_allocation_tracker;
+    }
+
+    // Summed over every coroutine whose name starts with 'name', e.g. "olifilo::io::mqtt::ping("
+    allocation_counts of(std::string_view name)
+    {
+      const pause untracked(*this);
+      allocation_counts counts;
+      for (std::size_t i = 0; i < _used; ++i)
+        if (name_of(_entries[i]).starts_with(name))
+          counts += _entries[i].counts;
+      return counts;
+    }
+
+    allocation_counts total() const noexcept
+    {
+      allocation_counts counts = _other;
+      for (std::size_t i = 0; i < _used; ++i)
+        counts += _entries[i].counts;
+      return counts;
+    }
+
+    void reset() noexcept
+    {
+      _used = 0;
+      _other = {};
+    }
+
+    // One line per coroutine that allocated anything
+    void print(std::FILE* out)
+    {
+      const pause untracked(*this);
+      const auto line = [out] (std::string_view name, const allocation_counts& counts) {
+        std::fprintf(out, "%6zu frames %6zu callee lists %6zu buffers %8zu bytes  %.*s\n",
+            counts.frames, counts.callee_lists, counts.buffers, counts.bytes, static_cast<int>(name.size()), name.data());
+      };
+      for (std::size_t i = 0; i < _used; ++i)
+        line(name_of(_entries[i]), _entries[i].counts);
+      if (_other.frames || _other.callee_lists || _other.buffers)
+        line("[other]", _other);
+    }
+
+    // Called by the replaced global operator new
+    void global_allocation(std::size_t size) noexcept
+    {
+      if (!_paused)
+        record(memory_category::buffer, size, nullptr);
+    }
+
+  private:
+    struct entry
+    {
+      // an address inside the coroutine's code, nullptr for allocations outside of any coroutine
+      const void*       function;
+      allocation_counts counts;
+      std::string       name;
+    };
+
+    // Symbolizing allocates: that shouldn't count
+    struct pause
+    {
+      explicit pause(allocation_tracker& tracker) noexcept
+        : tracker(tracker)
+        , was_paused(tracker._paused)
+      {
+        tracker._paused = true;
+      }
+
+      ~pause()
+      {
+        tracker._paused = was_paused;
+      }
+
+      allocation_tracker& tracker;
+      bool                was_paused;
+    };
+
+    // Memory for the budget, without going through (and so being counted as) the global heap
+    class untracked_resource final : public std::pmr::memory_resource
+    {
+        void* do_allocate(std::size_t size, std::size_t alignment) override
+        {
+          if (auto* const p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment))
+            return p;
+          throw std::bad_alloc();
+        }
+
+        void do_deallocate(void* p, std::size_t, std::size_t) override
+        {
+          std::free(p);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& rhs) const noexcept override
+        {
+          return this == &rhs;
+        }
+    };
+
+    void allocated(memory_category category, std::size_t size, const void* caller) noexcept override
+    {
+      record(category, size, caller);
+    }
+
+    void record(memory_category category, std::size_t size, const void* function) noexcept
+    {
+      if (!function)
+        if (const auto stack = current_async_stack(); !stack.empty())
+          function = async_frame_function(stack.back());
+
+      // Frames identify their ramp function, running coroutines their resume function: of() merges
+      // those by name, here only identical addresses get merged.
+      auto* counts = &_other;
+      for (std::size_t i = 0; i < _used; ++i)
+      {
+        if (_entries[i].function == function)
+        {
+          counts = &_entries[i].counts;
+          break;
+        }
+      }
+      if (counts == &_other && _used < max_functions)
+      {
+        // Reused entries keep their name's storage: assigning doesn't allocate until symbolized
+        _entries[_used].function = function;
+        _entries[_used].counts = {};
+        _entries[_used].name.clear();
+        counts = &_entries[_used++].counts;
+      }
+
+      switch (category)
+      {
+        case memory_category::coroutine_frame: ++counts->frames;       break;
+        case memory_category::callee_list:     ++counts->callee_lists; break;
+        case memory_category::buffer:
+        case memory_category::queue:           ++counts->buffers;      break;
+      }
+      counts->bytes += size;
+    }
+
+    std::string_view name_of(entry& e)
+    {
+      if (e.name.empty())
+        e.name = e.function ? coroutine_name(e.function) : "[no coroutine]";
+      return e.name;
+    }
+
+    allocation_tracker*   _previous;
+    bool                  _paused = false;
+    untracked_resource    _upstream;
+    memory_budget         _budget{std::numeric_limits<std::size_t>::max(), &_upstream};
+    entry                 _entries[max_functions];
+    std::size_t           _used = 0;
+    allocation_counts     _other;
+};
+}  // namespace olifilo::test
+
+namespace olifilo::test::detail
+{
+inline void* tracked_malloc(std::size_t size) noexcept
+{
+  if (auto* const tracker = allocation_tracker::current())
+    tracker->global_allocation(size);
+  return std::malloc(size ? size : 1);
+}
+
+inline void* tracked_aligned_alloc(std::size_t size, std::align_val_t alignment) noexcept
+{
+  if (auto* const tracker = allocation_tracker::current())
+    tracker->global_allocation(size);
+  const auto align = static_cast<std::size_t>(alignment);
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+}  // namespace olifilo::test::detail
+
+void* operator new(std::size_t size)
+{
+  if (auto* const p = olifilo::test::detail::tracked_malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return olifilo::test::detail::tracked_malloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (auto* const p = olifilo::test::detail::tracked_aligned_alloc(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return olifilo::test::detail::tracked_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "allocation_tracker.hpp"
+#include "check.hpp"
+#include "fake_broker.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/mqtt.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#include <sys/socket.h>
+
+namespace
+{
+using olifilo::test::allocation_counts;
+using olifilo::test::allocation_tracker;
+using olifilo::test::check;
+using olifilo::test::check_result;
+using olifilo::test::fake_broker;
+
+// What both sides together allocated while pinging
+olifilo::future<allocation_counts> ping_repeatedly(olifilo::io::stream_socket sock, unsigned pings) noexcept
+{
+  auto con = co_await olifilo::io::mqtt::connect(std::move(sock), 0);
+  if (!con)
+    co_return con.error();
+
+  auto before = allocation_tracker::current()->total();
+  for (unsigned i = 0; i < pings; ++i)
+    if (auto r = co_await con->ping(); !r)
+      co_return r.error();
+  auto steady_state = allocation_tracker::current()->total();
+
+  if (auto r = co_await con->disconnect(); !r)
+    co_return r.error();
+
+  steady_state.frames -= before.frames;
+  steady_state.callee_lists -= before.callee_lists;
+  steady_state.buffers -= before.buffers;
+  steady_state.bytes -= before.bytes;
+  co_return steady_state;
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) != 0)
+  {
+    std::perror("socketpair");
+    return 1;
+  }
+
+  constexpr unsigned pings = 10;
+  allocation_tracker allocations;
+  auto r = when_all(
+      ping_repeatedly(io::stream_socket(io::file_descriptor_handle(fds[0])), pings)
+    , fake_broker(io::stream_socket(io::file_descriptor_handle(fds[1])))
+    ).get();
+  if (!check_result(r, "when_all failed"))
+    return 1;
+
+  allocations.print(stdout);
+
+  // Its own frame, nothing else: writing and reading get attributed to file_descriptor::write/read
+  const auto ping = allocations.of("olifilo::io::mqtt::ping(");
+  const auto steady_state = *std::get<0>(*r);
+  if (!check(ping.frames == pings, "mqtt::ping should allocate exactly one frame of its own per call")
+   || !check(ping.buffers == 0, "mqtt::ping shouldn't allocate buffers")
+   || !check(steady_state.buffers == 0, "pinging shouldn't allocate buffers")
+   || !check(steady_state.callee_lists == 0, "pinging shouldn't outgrow callee lists' inline capacity")
+   // ping, its write & read, the broker's two reads and write
+   || !check(steady_state.frames <= 6 * pings, "pinging allocates more frames than it used to"))
+    return 1;
+
+  return 0;
+}
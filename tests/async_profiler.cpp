@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/async_profiler.hpp>
+#include <olifilo/coro/future.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+std::uint64_t burn_cpu(std::chrono::steady_clock::duration duration) noexcept
+{
+  std::uint64_t x = 0;
+  for (const auto end = std::chrono::steady_clock::now() + duration; std::chrono::steady_clock::now() < end;)
+    x = x * 6364136223846793005u + 1442695040888963407u;
+  return x;
+}
+
+// Burns CPU from within the executor, so samples get attributed to this coroutine
+olifilo::future<std::uint64_t> busy(std::chrono::steady_clock::duration duration) noexcept
+{
+  if (auto r = co_await olifilo::io::poll(olifilo::io::poll::timeout_clock::time_point{}); !r)
+    co_return r.error();
+  co_return burn_cpu(duration);
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  // Another thread getting SIGPROF while we stop and destroy profilers: stop() has to wait for its handler
+  std::atomic<bool> done = false;
+  std::thread spinner([&] {
+      while (!done.load(std::memory_order_relaxed))
+        (void)burn_cpu(1ms);
+    });
+
+  for (int i = 0; i < 50; ++i)
+  {
+    auto profiler = async_profiler::start(100us, 64);
+    if (!check(profiler.has_value(), "starting profiler failed"))
+      return 1;
+    (void)burn_cpu(1ms);
+  }
+
+  auto profiler = async_profiler::start(100us);
+  if (!check(profiler.has_value(), "starting profiler failed")
+   || !check(!async_profiler::start() && async_profiler::start().error() == std::errc::device_or_resource_busy
+      , "only one profiler should run at a time"))
+    return 1;
+
+  if (!check_result(busy(100ms).get(), "burning CPU failed"))
+    return 1;
+  profiler->stop();
+  done.store(true, std::memory_order_relaxed);
+  spinner.join();
+
+  if (!check(profiler->samples() > 0, "burning CPU should have been sampled"))
+    return 1;
+
+  std::FILE* const out = std::tmpfile();
+  if (!out)
+  {
+    std::perror("tmpfile");
+    return 1;
+  }
+  if (!check_result(profiler->write_folded(io::file_descriptor_handle(::fileno(out))), "writing folded stacks failed"))
+    return 1;
+
+  // Every line is "stack count" and the counts add up to the complete samples
+  std::rewind(out);
+  std::uint64_t counted = 0;
+  char line[4096];
+  while (std::fgets(line, sizeof(line), out))
+  {
+    const char* const count = std::strrchr(line, ' ');
+    char* end = nullptr;
+    const auto n = count ? std::strtoull(count + 1, &end, 10) : 0;
+    if (!check(count && count != line && n > 0 && *end == '\n', "malformed folded stack line"))
+      return 1;
+    counted += n;
+  }
+  std::fclose(out);
+
+  return check(counted > 0 && counted <= profiler->samples(), "folded counts should add up to the recorded samples") ? 0 : 1;
+}
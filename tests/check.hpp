@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+/**
+ * Assertion helpers shared by the tests: report what failed on stderr and let the caller bail out.
+ */
+
+#include <olifilo/expected.hpp>
+
+#include <cstdio>
+#include <system_error>
+#include <tuple>
+
+namespace olifilo::test
+{
+inline bool check(bool condition, const char* what)
+{
+  if (!condition)
+    std::fprintf(stderr, "error: %s\n", what);
+  return condition;
+}
+
+template <typename T>
+std::error_code first_error(const expected<T>& r) noexcept
+{
+  return r.error();
+}
+
+// when_all's result: its own error or else that of the first future that failed
+template <typename... Ts>
+std::error_code first_error(const expected<std::tuple<expected<Ts>...>>& r) noexcept
+{
+  if (!r)
+    return r.error();
+
+  return std::apply([] (const auto&... results) noexcept {
+      std::error_code error;
+      (void)((error = results.error()) || ...);
+      return error;
+    }, *r);
+}
+
+template <typename T>
+bool check_result(const expected<T>& r, const char* what)
+{
+  const auto error = first_error(r);
+  if (error)
+    std::fprintf(stderr, "error: %s: %s\n", what, error.message().c_str());
+  return !error;
+}
+}  // namespace olifilo::test
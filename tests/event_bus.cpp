@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/event_bus.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+enum class sensor_event : std::int32_t
+{
+  sample,
+  overflow,
+};
+
+enum class link_event : std::int32_t
+{
+  up,
+  down,
+};
+
+constinit const char* const SENSOR_EVENT = "SENSOR_EVENT";
+constinit const char* const LINK_EVENT = "LINK_EVENT";
+}  // anonymous namespace
+
+namespace olifilo::events::detail
+{
+template <>
+struct event_id<sensor_event>
+{
+  static constexpr const auto& base = SENSOR_EVENT;
+  static constexpr std::size_t sort_key = 0;
+  static constexpr auto min = std::to_underlying(sensor_event::sample);
+  static constexpr auto max = std::to_underlying(sensor_event::overflow);
+};
+
+template <>
+struct event<sensor_event::sample>
+{
+  using type = std::uint32_t;
+};
+
+template <>
+struct event_id<link_event>
+{
+  static constexpr const auto& base = LINK_EVENT;
+  static constexpr std::size_t sort_key = 1;
+  static constexpr auto min = std::to_underlying(link_event::up);
+  static constexpr auto max = std::to_underlying(link_event::down);
+};
+}  // namespace olifilo::events::detail
+
+namespace
+{
+// Posts only after the subscriber started waiting, so it has to get woken up through its eventfd
+olifilo::future<void> post_later(olifilo::io::event_bus& bus) noexcept
+{
+  // only a timeout to wait for: expiring is how it completes
+  if (auto r = co_await olifilo::io::poll(10ms); !r && r.error() != std::errc::timed_out)
+    co_return r;
+  bus.post<link_event::up>();
+  bus.post<sensor_event::sample>(42);
+  co_return {};
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  io::event_bus bus;
+
+  // Queues are bounded: events that don't fit get dropped and counted
+  {
+    auto samples = bus.subscribe<sensor_event::sample>(2);
+    if (!check(samples.has_value() && static_cast<bool>(*samples), "subscribing failed"))
+      return 1;
+    static_assert(std::is_same_v<decltype(samples)::value_type::result_t, std::uint32_t>);
+
+    if (!check(bus.post<sensor_event::sample>(1) == 1, "sample should be queued")
+     || !check(bus.post<sensor_event::sample>(2) == 1, "sample should be queued")
+     || !check(bus.post<sensor_event::sample>(3) == 0, "sample should be dropped by a full queue")
+     || !check(bus.post<sensor_event::overflow>() == 0, "event not subscribed to shouldn't be queued")
+     || !check(samples->dropped() == 1, "dropped sample should be counted"))
+      return 1;
+
+    for (std::uint32_t expected_sample : {1u, 2u})
+    {
+      auto sample = samples->receive().get();
+      if (!check_result(sample, "receiving failed")
+       || !check(*sample == expected_sample, "samples should be received in order"))
+        return 1;
+    }
+  }
+  if (!check(bus.post<sensor_event::sample>(4) == 0, "unsubscribing should stop queueing"))
+    return 1;
+
+  // Multiple enums decode to a variant of ids and a variant of payloads, with monostate for void
+  {
+    // Deliberately out of sort_key order: gets the same subscriber type as the sorted order
+    auto events = bus.subscribe<link_event::up, sensor_event::sample>();
+    if (!check(events.has_value(), "subscribing failed"))
+      return 1;
+    using subscriber_t = decltype(events)::value_type;
+    static_assert(std::is_same_v<subscriber_t, io::event_bus::subscriber<sensor_event::sample, link_event::up>>);
+    static_assert(std::is_same_v<subscriber_t::result_t,
+        std::pair<std::variant<sensor_event, link_event>, std::variant<std::monostate, std::uint32_t>>>);
+
+    auto r = when_all(events->receive(), post_later(bus)).get();
+    if (!check_result(r, "when_all failed"))
+      return 1;
+
+    const auto& [link_id, link_data] = *std::get<0>(*r);
+    if (!check(link_id == subscriber_t::event_id_t(link_event::up), "should receive link up first")
+     || !check(std::holds_alternative<std::monostate>(link_data), "link up has no payload"))
+      return 1;
+
+    auto sample = events->receive().get();
+    if (!check(sample.has_value(), "sample should still be queued"))
+      return 1;
+    if (!check(sample->first == subscriber_t::event_id_t(sensor_event::sample), "should receive sample second")
+     || !check(sample->second == subscriber_t::event_t(std::uint32_t(42)), "sample's payload should survive the queue"))
+      return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+/**
+ * Minimal MQTT broker for tests talking to olifilo::mqtt over a socket pair or simulated link.
+ */
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/stream_socket.hpp>
+#include <olifilo/io/shutdown.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+namespace olifilo::test
+{
+// Accepts any CONNECT, answers PINGREQs and stops at DISCONNECT
+inline future<void> fake_broker(io::stream_socket sock) noexcept
+{
+  while (true)
+  {
+    std::byte packet[256];
+    auto header = co_await sock.read(std::span(packet, 2), eagerness::lazy);
+    if (!header)
+      co_return header.error();
+    else if (header->size() != 2 || (static_cast<std::uint8_t>(packet[1]) & 0x80))
+      co_return make_error_code(std::errc::bad_message);
+
+    if (auto rest = co_await sock.read(std::span(packet).subspan(2, static_cast<std::uint8_t>(packet[1]))); !rest)
+      co_return rest.error();
+
+    switch (static_cast<std::uint8_t>(packet[0]) >> 4)
+    {
+      case 1: // CONNECT
+      {
+        constexpr std::uint8_t connack[] = {0x20, 2, 0, 0};
+        if (auto r = co_await sock.write(as_bytes(std::span(connack))); !r)
+          co_return r;
+        break;
+      }
+      case 12: // PINGREQ
+      {
+        constexpr std::uint8_t pingresp[] = {0xd0, 0};
+        if (auto r = co_await sock.write(as_bytes(std::span(pingresp))); !r)
+          co_return r;
+        break;
+      }
+      case 14: // DISCONNECT
+        co_return sock.shutdown(io::shutdown_how::write);
+      default:
+        co_return make_error_code(std::errc::bad_message);
+    }
+  }
+}
+}  // namespace olifilo::test
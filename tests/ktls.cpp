@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/io/stream_socket.hpp>
+#include <olifilo/coro/io/tls.hpp>
+#include <olifilo/expected.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+namespace
+{
+// ctest's SKIP_RETURN_CODE: the kernel we run on doesn't have the 'tls' ULP
+constexpr int skip_test = 77;
+
+constexpr char server_name[] = "localhost";
+
+struct self_signed
+{
+  std::unique_ptr<::EVP_PKEY, decltype(&::EVP_PKEY_free)> key{nullptr, &::EVP_PKEY_free};
+  std::unique_ptr<::X509, decltype(&::X509_free)> cert{nullptr, &::X509_free};
+
+  std::string cert_pem() const
+  {
+    std::unique_ptr<::BIO, decltype(&::BIO_free)> bio(::BIO_new(::BIO_s_mem()), &::BIO_free);
+    ::PEM_write_bio_X509(bio.get(), cert.get());
+    char* data = nullptr;
+    const auto size = BIO_get_mem_data(bio.get(), &data);
+    return std::string(data, static_cast<std::size_t>(size));
+  }
+};
+
+self_signed make_certificate()
+{
+  self_signed rv;
+  rv.key.reset(::EVP_EC_gen("P-256"));
+  rv.cert.reset(::X509_new());
+  const auto cert = rv.cert.get();
+  ::X509_set_version(cert, 2);
+  ::ASN1_INTEGER_set(::X509_get_serialNumber(cert), 1);
+  ::X509_gmtime_adj(::X509_getm_notBefore(cert), 0);
+  ::X509_gmtime_adj(::X509_getm_notAfter(cert), 3600);
+  ::X509_set_pubkey(cert, rv.key.get());
+  const auto name = ::X509_get_subject_name(cert);
+  ::X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>(server_name), -1, -1, 0);
+  ::X509_set_issuer_name(cert, name);
+  ::X509_sign(cert, rv.key.get(), ::EVP_sha256());
+  return rv;
+}
+
+// Plain user space OpenSSL echo server, accepting a single connection and offering TLS versions from 'min_version' on
+void echo_server(int listener, const self_signed& id, int min_version, int& negotiated)
+{
+  const int fd = ::accept(listener, nullptr, nullptr);
+  if (fd < 0)
+    return;
+
+  std::unique_ptr<::SSL_CTX, decltype(&::SSL_CTX_free)> ctx(::SSL_CTX_new(::TLS_server_method()), &::SSL_CTX_free);
+  ::SSL_CTX_use_certificate(ctx.get(), id.cert.get());
+  ::SSL_CTX_use_PrivateKey(ctx.get(), id.key.get());
+  ::SSL_CTX_set_min_proto_version(ctx.get(), min_version);
+  std::unique_ptr<::SSL, decltype(&::SSL_free)> ssl(::SSL_new(ctx.get()), &::SSL_free);
+  ::SSL_set_fd(ssl.get(), fd);
+
+  if (::SSL_accept(ssl.get()) == 1)
+  {
+    negotiated = ::SSL_version(ssl.get());
+    char buf[256];
+    int len;
+    while ((len = ::SSL_read(ssl.get(), buf, sizeof(buf))) > 0)
+      if (::SSL_write(ssl.get(), buf, len) != len)
+        break;
+  }
+
+  ::close(fd);
+}
+
+constexpr char message[] = "PINGREQ over kTLS";
+
+// Echoes 'message' over a kTLS connection to a server offering TLS versions from 'min_version' on
+olifilo::expected<void> echo(const olifilo::io::tls_context& ctx, const self_signed& id, int min_version, int& negotiated)
+{
+  using namespace olifilo;
+
+  const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  ::sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ::socklen_t addrlen = sizeof(addr);
+  if (listener < 0
+   || ::bind(listener, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr)) != 0
+   || ::listen(listener, 1) != 0
+   || ::getsockname(listener, reinterpret_cast<::sockaddr*>(&addr), &addrlen) != 0)
+  {
+    const std::error_code error(errno, std::system_category());
+    if (listener >= 0)
+      ::close(listener);
+    return {unexpect, error};
+  }
+
+  std::thread server(echo_server, listener, std::cref(id), min_version, std::ref(negotiated));
+
+  std::array<char, sizeof(message)> reply{};
+  auto result = [&]() -> future<void> {
+    auto sock = co_await io::stream_socket::create_connection(AF_INET, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr));
+    if (!sock)
+      co_return sock.error();
+
+    if (auto r = co_await io::start_ktls(*sock, ctx, server_name); !r)
+      co_return r;
+
+    // From here on only plain socket I/O: the kernel handles the records
+    if (auto r = co_await sock->send({as_bytes(std::span(message))}); !r)
+      co_return r;
+
+    if (auto r = co_await sock->read(as_writable_bytes(std::span(reply))); !r)
+      co_return r.error();
+    else if (r->size() != sizeof(message))
+      co_return make_error_code(std::errc::connection_aborted);
+
+    co_return {};
+  }().get();
+
+  ::shutdown(listener, SHUT_RDWR);
+  server.join();
+  ::close(listener);
+
+  if (result && std::memcmp(reply.data(), message, sizeof(message)) != 0)
+    return {unexpect, make_error_code(std::errc::bad_message)};
+  return result;
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  const auto id = make_certificate();
+
+  auto ctx = io::tls_context::create_client();
+  if (!ctx)
+  {
+    std::fprintf(stderr, "tls_context: %s\n", ctx.error().message().c_str());
+    return 1;
+  }
+  if (auto r = ctx->add_trust_anchor(id.cert_pem()); !r)
+  {
+    std::fprintf(stderr, "add_trust_anchor: %s\n", r.error().message().c_str());
+    return 1;
+  }
+
+  // A server preferring TLS 1.3 would send post-handshake records after it: we have to get TLS 1.2
+  int negotiated = 0;
+  if (auto r = echo(*ctx, id, TLS1_2_VERSION, negotiated); !r && r.error() == io::tls_error::ktls_unavailable)
+  {
+    std::fprintf(stderr, "skipping: %s\n", r.error().message().c_str());
+    return skip_test;
+  }
+  else if (!r)
+  {
+    std::fprintf(stderr, "error: %s\n", r.error().message().c_str());
+    return 1;
+  }
+  else if (negotiated != TLS1_2_VERSION)
+  {
+    std::fprintf(stderr, "error: negotiated TLS version 0x%x instead of TLS 1.2\n", negotiated);
+    return 1;
+  }
+
+  // TLS 1.3 only servers have to be refused instead of leaving us with a socket that fails reads
+  negotiated = 0;
+  if (auto r = echo(*ctx, id, TLS1_3_VERSION, negotiated); r || r.error() != io::tls_error::handshake_failed)
+  {
+    std::fprintf(stderr, "error: TLS 1.3 only server: %s\n", r ? "connected" : r.error().message().c_str());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/memory_budget.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/errors.hpp>
+
+#include <cstdio>
+#include <memory_resource>
+#include <new>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+using olifilo::test::check;
+
+olifilo::future<unsigned> nest(unsigned depth) noexcept
+{
+  if (depth == 0)
+    co_return 0u;
+
+  auto r = co_await nest(depth - 1);
+  if (!r)
+    co_return r.error();
+  co_return *r + 1;
+}
+
+// Awaiting more than the callee list's inline capacity
+olifilo::future<void> fan_out() noexcept
+{
+  std::vector<olifilo::future<unsigned>> children;
+  for (unsigned i = 0; i < 8; ++i)
+    children.push_back(nest(1));
+
+  if (auto r = co_await olifilo::when_all(children.begin(), children.end()); !r)
+    co_return r.error();
+  co_return {};
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  {
+    memory_budget budget(64 * 1024);
+    auto r = nest(16).get();
+    if (!check(r && *r == 16, "nesting within budget failed")
+     || !check(budget.usage(memory_category::coroutine_frame).allocations == 17, "not every frame got accounted")
+     || !check(budget.usage(memory_category::coroutine_frame).high_water > 0, "no frame high-water mark")
+     || !check(budget.used() == 0, "frames leaked from the budget"))
+      return 1;
+
+    if (!check(fan_out().get().has_value(), "fan out within budget failed")
+     || !check(budget.usage(memory_category::callee_list).high_water > 0, "no callee list high-water mark")
+     || !check(budget.used() == 0, "callee lists leaked from the budget"))
+      return 1;
+  }
+
+  {
+    // Running out fails the future instead of the process
+    memory_budget budget(2048);
+    auto r = nest(1000).get();
+    if (!check(!r && r.error() == error::coro_bad_alloc, "exceeding the budget should fail with coro_bad_alloc")
+     || !check(budget.usage(memory_category::coroutine_frame).failures == 1, "refused allocation not counted")
+     || !check(budget.high_water() <= budget.limit(), "budget exceeded")
+     || !check(budget.used() == 0, "frames leaked after failing"))
+      return 1;
+  }
+
+  {
+    memory_budget budget(1024);
+    std::pmr::vector<char> queue(budget.resource(memory_category::queue));
+    queue.resize(512);
+    if (!check(budget.usage(memory_category::queue).current >= 512, "queue not accounted"))
+      return 1;
+
+#if __cpp_exceptions
+    try
+    {
+      queue.resize(4096);
+      std::fprintf(stderr, "error: growing beyond the budget should throw\n");
+      return 1;
+    }
+    catch (const std::bad_alloc&)
+    {
+    }
+#endif
+  }
+
+  return 0;
+}
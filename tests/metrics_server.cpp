@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/acceptor.hpp>
+#include <olifilo/coro/io/metrics_server.hpp>
+#include <olifilo/coro/io/stream_socket.hpp>
+#include <olifilo/coro/io/tcp_metrics.hpp>
+#include <olifilo/coro/when_any.hpp>
+#include <olifilo/mqtt/stats.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using namespace std::literals::string_view_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+bool contains_line(std::string_view text, std::string_view line)
+{
+  for (std::size_t pos = 0; (pos = text.find(line, pos)) != text.npos; pos += line.size())
+    if ((pos == 0 || text[pos - 1] == '\n') && text.substr(pos + line.size()).starts_with('\n'))
+      return true;
+  return false;
+}
+
+// Everything a renderer produces, in chunks of at most 'chunk_size'
+std::optional<std::string> render_all(const olifilo::io::metrics_sources& sources, std::size_t chunk_size)
+{
+  auto renderer = olifilo::io::prometheus_renderer::create(sources);
+  if (!check_result(renderer, "creating renderer failed"))
+    return std::nullopt;
+
+  std::string text;
+  std::array<char, 4096> buf;
+  while (!renderer->done())
+  {
+    const auto chunk = renderer->render(std::span(buf).first(chunk_size));
+    if (!chunk.empty() && !check(chunk.back() == '\n', "chunks should only hold whole lines"))
+      return std::nullopt;
+    text.append(chunk.data(), chunk.size());
+  }
+  return text;
+}
+
+// Decodes a chunked transfer encoding body, std::nullopt if it's malformed or incomplete
+std::optional<std::string> dechunk(std::string_view body)
+{
+  std::string rv;
+  while (true)
+  {
+    const auto size_end = body.find("\r\n"sv);
+    if (size_end == body.npos)
+      return std::nullopt;
+
+    char* end;
+    const std::string size_str(body.substr(0, size_end));
+    const auto size = std::strtoul(size_str.c_str(), &end, 16);
+    if (size_str.empty() || *end != '\0')
+      return std::nullopt;
+    body.remove_prefix(size_end + 2);
+
+    if (body.size() < size + 2 || body.substr(size, 2) != "\r\n"sv)
+      return std::nullopt;
+    if (size == 0)
+      return rv;
+
+    rv.append(body.substr(0, size));
+    body.remove_prefix(size + 2);
+  }
+}
+
+bool check_renderer(const olifilo::io::tcp_metrics& tcp)
+{
+  // Without the executor: its counters change while rendering, these don't
+  const olifilo::io::metrics_sources sources{.executor = false, .mqtt = true, .tcp = &tcp};
+  const auto whole = render_all(sources, 4096);
+  if (!check(whole.has_value(), "rendering failed")
+   || !check(contains_line(*whole, "# TYPE olifilo_mqtt_ping_rtt_seconds summary"), "ping RTT quantiles should be a summary")
+   || !check(contains_line(*whole, "olifilo_mqtt_ping_rtt_seconds_count 2"), "ping RTT summary should count its samples")
+   || !check(contains_line(*whole, "olifilo_mqtt_pings_answered_total 2"), "answered pings should be counted")
+   || !check(contains_line(*whole, "olifilo_tcp_connections_total{endpoint=\"10.0.0.1:1883\"} 1"), "TCP metrics should be labeled by peer")
+   || !check(!whole->contains("olifilo_executor_"), "disabled sources shouldn't be rendered"))
+    return false;
+
+  // Just big enough for the longest line and snprintf()'s terminator: nearly every chunk has to end between two lines
+  std::size_t longest = 0;
+  for (std::size_t start = 0, end; (end = whole->find('\n', start)) != whole->npos; start = end + 1)
+    longest = std::max(longest, end + 1 - start);
+  const auto chunked = render_all(sources, longest + 1);
+  return check(chunked.has_value(), "rendering in small chunks failed")
+      && check(chunked == whole, "rendering in small chunks should produce the same output");
+}
+
+olifilo::future<std::string> scrape(const ::sockaddr_in& addr) noexcept
+{
+  auto client = co_await olifilo::io::stream_socket::create_connection(AF_INET, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr));
+  if (!client)
+    co_return client.error();
+
+  constexpr auto request = "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n"sv;
+  if (auto r = co_await client->write(as_bytes(std::span(request))); !r)
+    co_return r.error();
+
+  std::string response;
+  std::array<std::byte, 512> buf;
+  while (true)
+  {
+    auto r = co_await client->read_some(buf);
+    if (!r)
+      co_return r.error();
+    else if (r->empty())
+      co_return response;
+    response.append(reinterpret_cast<const char*>(r->data()), r->size());
+  }
+}
+
+bool check_scrape(const olifilo::io::tcp_metrics& tcp)
+{
+  using namespace olifilo;
+
+  // Find a free port: the server doesn't tell which one it got
+  ::sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto addrlen = static_cast<::socklen_t>(sizeof(addr));
+  if (auto probe = io::acceptor::create(reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr));
+      !check_result(probe, "listening failed")
+   || !check(::getsockname(probe->handle(), reinterpret_cast<::sockaddr*>(&addr), &addrlen) == 0, "getsockname failed"))
+    return false;
+
+  auto server = io::metrics_server::create(reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr), {.tcp = &tcp});
+  if (!check_result(server, "creating server failed"))
+    return false;
+
+  // serve() doesn't end by itself
+  auto r = when_any(server->serve(), scrape(addr), 5s).get();
+  if (!check_result(r, "scraping timed out")
+   || !check(r->index == 1, "server stopped serving"))
+    return false;
+
+  const auto response = std::get<1>(r->futures).get();
+  if (!check_result(response, "scraping failed"))
+    return false;
+
+  const auto header_end = response->find("\r\n\r\n"sv);
+  if (!check(response->starts_with("HTTP/1.1 200 OK\r\n"sv), "scrape should succeed")
+   || !check(header_end != response->npos && response->substr(0, header_end).contains("\r\nTransfer-Encoding: chunked"sv), "response should be chunked"))
+    return false;
+
+  const auto body = dechunk(std::string_view(*response).substr(header_end + 4));
+  return check(body.has_value(), "response should be properly chunked")
+      && check(contains_line(*body, "# TYPE olifilo_executor_resume_delay_seconds summary"), "resume delay quantiles should be a summary")
+      && check(body->contains("\nolifilo_executor_resume_delay_seconds_count "sv), "scrape should report the resume delay count")
+      && check(!body->contains("olifilo_executor_resume_delay_samples_total"sv), "resume delay count should be part of its summary")
+      && check(contains_line(*body, "# TYPE olifilo_mqtt_ping_rtt_seconds summary"), "ping RTT quantiles should be a summary")
+      && check(contains_line(*body, "olifilo_mqtt_ping_rtt_seconds_count 2"), "scrape should report the ping RTT count")
+      && check(contains_line(*body, "# TYPE olifilo_tcp_connections_total counter"), "scrape should include TCP metrics")
+      && check(contains_line(*body, "olifilo_tcp_connections_total{endpoint=\"10.0.0.1:1883\"} 1"), "scrape should report TCP metrics per peer");
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  auto& mqtt = io::mqtt_statistics();
+  mqtt.add_ping_sent();
+  mqtt.add_ping_answered(2ms);
+  mqtt.add_ping_sent();
+  mqtt.add_ping_answered(4ms);
+
+  io::tcp_metrics tcp;
+  if (!check_result(tcp.record("10.0.0.1:1883", {.rtt = 100us}, 0, true), "recording TCP sample failed"))
+    return 1;
+
+  if (!check_renderer(tcp)
+   || !check_scrape(tcp))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/regular_file.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace
+{
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+std::span<const std::byte> bytes(std::string_view str) noexcept
+{
+  return std::as_bytes(std::span(str));
+}
+
+bool equal(std::span<const std::byte> lhs, std::string_view rhs) noexcept
+{
+  return std::ranges::equal(lhs, bytes(rhs));
+}
+
+// Sum of the tokens left behind in every eventfd of this process, std::nullopt if that can't be determined
+std::optional<std::uint64_t> pending_eventfd_tokens()
+{
+  const auto dir = ::opendir("/proc/self/fdinfo");
+  if (!dir)
+    return std::nullopt;
+
+  std::uint64_t tokens = 0;
+  while (const auto entry = ::readdir(dir))
+  {
+    if (entry->d_name[0] == '.')
+      continue;
+
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/fdinfo/%s", entry->d_name);
+    const auto info = std::fopen(path, "r");
+    if (!info)
+      continue;
+
+    char line[128];
+    constexpr std::string_view count_label = "eventfd-count:";
+    while (std::fgets(line, sizeof(line), info))
+      if (std::strncmp(line, count_label.data(), count_label.size()) == 0)
+        tokens += std::strtoull(line + count_label.size(), nullptr, 16);
+    std::fclose(info);
+  }
+  ::closedir(dir);
+
+  return tokens;
+}
+
+bool check_offsets(olifilo::io::regular_file& file)
+{
+  if (!check_result(file.pwrite(bytes("hello"), 0).get(), "pwrite at start failed")
+   || !check_result(file.pwrite(bytes("world"), 100).get(), "pwrite past end failed"))
+    return false;
+
+  std::array<std::byte, 8> buf;
+  auto r = file.pread(std::span(buf).first(5), 100).get();
+  if (!check_result(r, "pread at offset failed")
+   || !check(equal(*r, "world"), "pread should read what pwrite wrote at the same offset"))
+    return false;
+
+  // Crosses the hole between both writes and ends at EOF
+  r = file.pread(buf, 98).get();
+  if (!check_result(r, "pread across hole failed")
+   || !check(r->size() == 7, "pread should only be short at EOF")
+   || !check(equal(r->first(2), std::string_view("\0\0", 2)) && equal(r->subspan(2), "world"), "holes should read as zeroes"))
+    return false;
+
+  r = file.pread(buf, 0).get();
+  if (!check_result(r, "pread at start failed")
+   || !check(r->size() == buf.size() && equal(r->first(5), "hello"), "pread at start should read the first write"))
+    return false;
+
+  r = file.pread(buf, 200).get();
+  return check_result(r, "pread past EOF failed")
+      && check(r->empty(), "pread past EOF should read nothing");
+}
+
+bool check_sync(olifilo::io::regular_file& file)
+{
+  return check_result(file.fsync().get(), "fsync failed")
+      && check_result(file.fdatasync().get(), "fdatasync failed");
+}
+
+// Destroyed while still queued for the pool or after a worker completed it, but before its waiter noticed
+bool check_destroy_pending(olifilo::io::regular_file& file)
+{
+  using namespace std::literals::chrono_literals;
+
+  std::array<std::byte, 5> buf;
+  std::optional<std::uint64_t> tokens;
+  for (unsigned attempt = 0;; ++attempt)
+  {
+    auto pending = file.pread(buf, 100);
+    // A worker may finish before the operation first checks for completion: nothing's pending then
+    if (pending.done())
+    {
+      if (!check(attempt < 100, "pread should suspend at least once"))
+        return false;
+      continue;
+    }
+
+    // Without running the executor nothing consumes the token
+    while ((tokens = pending_eventfd_tokens()) == 0)
+      std::this_thread::sleep_for(1ms);
+    if (!check(tokens == 1, "a completed operation should leave exactly one token"))
+      return false;
+    break;
+  }
+  tokens = pending_eventfd_tokens();
+  if (!check(tokens == 0, "destroying a completed operation should consume its token"))
+    return false;
+
+  constexpr std::size_t count = 8;
+  std::array<std::array<std::byte, 5>, count> bufs;
+  [&file, &bufs]<std::size_t... Is>(std::index_sequence<Is...>) {
+      // futures start eagerly: all of these get submitted before any gets destroyed, most are still queued then
+      const std::array pending{file.pread(bufs[Is], 100)...};
+    }(std::make_index_sequence<count>());
+
+  tokens = pending_eventfd_tokens();
+  if (!check(tokens == 0, "destroying pending operations should leave no tokens behind"))
+    return false;
+
+  auto r = file.pread(buf, 100).get();
+  if (!check_result(r, "pread after destroying pending operations failed")
+   || !check(equal(*r, "world"), "pread after destroying pending operations should read normally"))
+    return false;
+
+  tokens = pending_eventfd_tokens();
+  return check(tokens == 0, "completing an operation should consume its own token");
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  char path[] = "/tmp/olifilo-regular-file-XXXXXX";
+  const int tmp = ::mkstemp(path);
+  if (!check(tmp != -1, "mkstemp failed"))
+    return 1;
+  ::close(tmp);
+
+  auto file = io::regular_file::open(path, O_RDWR | O_TRUNC);
+  ::unlink(path);
+  if (!check_result(file, "open failed"))
+    return 1;
+
+  if (!check_offsets(*file)
+   || !check_sync(*file)
+   || !check_destroy_pending(*file))
+    return 1;
+
+  return 0;
+}
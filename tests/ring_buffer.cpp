@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/detail/ring_buffer.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <thread>
+
+namespace
+{
+using olifilo::detail::overflow_policy;
+using olifilo::detail::record_ring;
+using olifilo::test::check;
+
+// Records like events::fd_context's: a header followed by the payload
+struct record
+{
+  const char*   base;
+  std::int32_t  id;
+  std::uint64_t sequence;
+};
+
+bool push(record_ring& ring, std::uint64_t sequence)
+{
+  return ring.push([sequence] (std::span<std::byte> out) noexcept {
+      const record r{"TEST_EVENT", 1, sequence};
+      std::memcpy(out.data(), &r, sizeof(r));
+    });
+}
+
+bool pop(record_ring& ring, record& r)
+{
+  return ring.pop(as_writable_bytes(std::span(&r, 1)));
+}
+
+bool check_single_threaded(overflow_policy policy, std::uint64_t first_kept)
+{
+  constexpr std::size_t capacity = 4;
+  constexpr std::uint64_t pushed = capacity + 2;
+
+  record_ring ring;
+  if (!check(ring.reset(sizeof(record), capacity, policy).has_value(), "reset failed")
+   || !check(ring.empty(), "new ring should be empty"))
+    return false;
+
+  for (std::uint64_t i = 0; i < pushed; ++i)
+  {
+    const bool fits = i < capacity || policy == overflow_policy::drop_oldest;
+    if (!check(push(ring, i) == fits, "push into full ring should only succeed with drop_oldest"))
+      return false;
+  }
+  if (!check(ring.dropped() == pushed - capacity, "every overflow should be counted"))
+    return false;
+
+  record r;
+  for (std::uint64_t i = first_kept; i < first_kept + capacity; ++i)
+  {
+    if (!check(pop(ring, r), "pop from non-empty ring failed")
+     || !check(r.sequence == i && r.id == 1, "records should be popped in order"))
+      return false;
+  }
+  return check(!pop(ring, r) && ring.empty(), "ring should be empty after popping everything");
+}
+
+// The producer never waits for the consumer: whatever doesn't get received got dropped
+bool check_concurrent(overflow_policy policy)
+{
+  constexpr std::uint64_t pushed = 200'000;
+
+  record_ring ring;
+  if (!check(ring.reset(sizeof(record), 8, policy).has_value(), "reset failed"))
+    return false;
+
+  std::atomic<bool> done = false;
+  std::thread producer([&] {
+      for (std::uint64_t i = 0; i < pushed; ++i)
+        push(ring, i);
+      done.store(true, std::memory_order_release);
+    });
+
+  std::uint64_t received = 0;
+  std::uint64_t next = 0;
+  bool in_order = true;
+  for (bool finished = false; !finished;)
+  {
+    finished = done.load(std::memory_order_acquire);
+    record r;
+    while (pop(ring, r))
+    {
+      in_order = in_order && r.sequence >= next && r.base && r.id == 1;
+      next = r.sequence + 1;
+      ++received;
+    }
+  }
+  producer.join();
+
+  return check(in_order, "records should be received in order and intact")
+      && check(received + ring.dropped() == pushed, "every record should be either received or dropped");
+}
+}  // anonymous namespace
+
+int main()
+{
+  if (!check_single_threaded(overflow_policy::drop_newest, 0)
+   || !check_single_threaded(overflow_policy::drop_oldest, 2)
+   || !check_concurrent(overflow_policy::drop_newest)
+   || !check_concurrent(overflow_policy::drop_oldest))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/signal_set.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <system_error>
+#include <thread>
+#include <tuple>
+
+#include <pthread.h>
+#include <signal.h>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+std::atomic<bool> handled = false;
+
+extern "C" void on_signal(int) noexcept
+{
+  handled.store(true, std::memory_order_relaxed);
+}
+
+olifilo::future<void> sleep_for(std::chrono::milliseconds duration) noexcept
+{
+  // only a timeout to wait for: expiring is how it completes
+  if (auto r = co_await olifilo::io::poll(duration); !r && r.error() != std::errc::timed_out)
+    co_return r;
+  co_return {};
+}
+
+// Raises only after next() started waiting, so the signalfd has to wake the executor
+olifilo::future<void> raise_later(int signo) noexcept
+{
+  if (auto r = co_await sleep_for(10ms); !r)
+    co_return r;
+  if (::raise(signo) != 0)
+    co_return std::error_code(errno, std::system_category());
+  co_return {};
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  // Before starting any thread: those inherit the blocked signal mask
+  auto signals = io::signal_set::create({SIGUSR1});
+  if (!check_result(signals, "creating signal set failed"))
+    return 1;
+
+  if (auto r = when_all(signals->next(), raise_later(SIGUSR1)).get();
+      !check_result(r, "when_all failed")
+   || !check(*std::get<0>(*r) == SIGUSR1, "pending next() should receive the raised signal"))
+    return 1;
+
+  // Already pending before asking for it
+  if (!check(::raise(SIGUSR1) == 0, "raise failed"))
+    return 1;
+  if (auto r = signals->next().get();
+      !check_result(r, "next failed")
+   || !check(*r == SIGUSR1, "next() should receive the already pending signal"))
+    return 1;
+
+  // A signal with a handler interrupts the executor's select() with EINTR: it should keep waiting
+  struct ::sigaction action = {};
+  action.sa_handler = on_signal;
+  ::sigemptyset(&action.sa_mask);
+  if (!check(::sigaction(SIGUSR2, &action, nullptr) == 0, "installing signal handler failed"))
+    return 1;
+
+  std::thread interrupter([executor_thread = ::pthread_self()] {
+      // long enough for the executor to block
+      std::this_thread::sleep_for(20ms);
+      ::pthread_kill(executor_thread, SIGUSR2);
+    });
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto slept = sleep_for(100ms).get();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  interrupter.join();
+
+  if (!check_result(slept, "waiting failed after getting interrupted")
+   || !check(handled.load(std::memory_order_relaxed), "signal handler should have run")
+   || !check(elapsed >= 100ms, "getting interrupted shouldn't end waiting early"))
+    return 1;
+
+  return 0;
+}
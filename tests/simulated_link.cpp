@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "fake_broker.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/simulated_link.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/io/clock.hpp>
+#include <olifilo/mqtt.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::io::executor_clock;
+using olifilo::test::fake_broker;
+
+olifilo::future<executor_clock::duration> ping_round_trip(olifilo::io::stream_socket sock) noexcept
+{
+  auto con = co_await olifilo::io::mqtt::connect(std::move(sock), 0);
+  if (!con)
+    co_return con.error();
+
+  const auto start = executor_clock::now();
+  if (auto r = co_await con->ping(); !r)
+    co_return r.error();
+  const auto rtt = executor_clock::now() - start;
+
+  if (auto r = co_await con->disconnect(); !r)
+    co_return r.error();
+  co_return rtt;
+}
+
+// Time for 'size' bytes to get across, sent as one write
+olifilo::future<executor_clock::duration> transfer(olifilo::io::stream_socket from, olifilo::io::stream_socket to, std::size_t size) noexcept
+{
+  std::vector<std::byte> data(size), received(size);
+  const auto start = executor_clock::now();
+
+  auto both = co_await olifilo::when_all(
+      [] (olifilo::io::stream_socket& sock, std::span<const std::byte> data) -> olifilo::future<void> {
+        if (auto r = co_await sock.write(data); !r)
+          co_return r;
+        co_return sock.shutdown(olifilo::io::shutdown_how::write);
+      }(from, data)
+    , to.read(received)
+    );
+  if (!both)
+    co_return both.error();
+
+  auto& [sent, read] = *both;
+  if (!sent)
+    co_return sent.error();
+  else if (!read)
+    co_return read.error();
+  else if (read->size() != size)
+    co_return make_error_code(std::errc::connection_aborted);
+
+  co_return executor_clock::now() - start;
+}
+
+bool expect_between(const char* what, executor_clock::duration value, executor_clock::duration min, executor_clock::duration max)
+{
+  if (min <= value && value <= max)
+    return true;
+
+  std::fprintf(stderr, "error: %s took %lldus, expected [%lld, %lld]us\n", what
+    , static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(value).count())
+    , static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(min).count())
+    , static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(max).count()));
+  return false;
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  io::virtual_time sim;
+
+  // 50ms one way, 1 Mbit/s
+  const io::link_conditions wan{
+    .latency = 50ms,
+    .bytes_per_second = 125'000,
+  };
+
+  {
+    auto link = io::simulated_link::create(wan);
+    if (!link)
+    {
+      std::fprintf(stderr, "simulated_link: %s\n", link.error().message().c_str());
+      return 1;
+    }
+
+    auto r = when_all(link->run(), ping_round_trip(std::move(link->a)), fake_broker(std::move(link->b))).get();
+    if (!r || !std::get<0>(*r) || !std::get<1>(*r) || !std::get<2>(*r))
+    {
+      std::fprintf(stderr, "mqtt over simulated link failed\n");
+      return 1;
+    }
+
+    // Two 2 byte packets: propagation dominates
+    if (!expect_between("PINGREQ round trip", *std::get<1>(*r), 100ms, 101ms))
+      return 1;
+  }
+
+  {
+    auto link = io::simulated_link::create(wan);
+    if (!link)
+    {
+      std::fprintf(stderr, "simulated_link: %s\n", link.error().message().c_str());
+      return 1;
+    }
+
+    auto r = when_all(link->run(), transfer(std::move(link->a), std::move(link->b), 125'000)).get();
+    if (!r || !std::get<0>(*r) || !std::get<1>(*r))
+    {
+      std::fprintf(stderr, "transfer over simulated link failed\n");
+      return 1;
+    }
+
+    // Serialization dominates: 1s + one way latency
+    if (!expect_between("125kB transfer", *std::get<1>(*r), 1050ms, 1051ms))
+      return 1;
+  }
+
+  return 0;
+}
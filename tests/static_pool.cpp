@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+#include "fake_broker.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/interval.hpp>
+#include <olifilo/coro/memory_budget.hpp>
+#include <olifilo/coro/static_pool.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/errors.hpp>
+#include <olifilo/io/clock.hpp>
+#include <olifilo/mqtt.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <system_error>
+#include <utility>
+
+#include <sys/socket.h>
+
+namespace
+{
+// Every call to the global allocator, by anything in this process
+std::size_t global_allocations = 0;
+
+void* counted_malloc(std::size_t size) noexcept
+{
+  ++global_allocations;
+  return std::malloc(size ? size : 1);
+}
+
+void* counted_aligned_alloc(std::size_t size, std::align_val_t alignment) noexcept
+{
+  ++global_allocations;
+  const auto align = static_cast<std::size_t>(alignment);
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+}  // anonymous namespace
+
+void* operator new(std::size_t size)
+{
+  if (auto* const p = counted_malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return counted_malloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (auto* const p = counted_aligned_alloc(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return counted_aligned_alloc(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check_result;
+using olifilo::test::fake_broker;
+
+// The embedded configuration: every coroutine frame and callee list comes from here
+constinit olifilo::static_pool_resource<
+    olifilo::pool_class{256, 16}
+  , olifilo::pool_class{1024, 8}
+  , olifilo::pool_class{4096, 4}
+  > pools;
+
+// The steady state of do_mqtt: a keep-alive tick followed by a ping, over and over
+olifilo::future<void> keep_alive_loop(olifilo::io::stream_socket sock, unsigned pings, std::size_t& steady_state_allocations) noexcept
+{
+  auto con = co_await olifilo::io::mqtt::connect(std::move(sock), 0);
+  if (!con)
+    co_return con.error();
+
+  const auto before = global_allocations;
+  olifilo::interval keep_alive(con->keep_alive * 3 / 4);
+  for (unsigned i = 0; i < pings; ++i)
+  {
+    if (auto tick = co_await keep_alive.tick(); !tick)
+      co_return tick.error();
+
+    if (auto r = co_await con->ping(); !r)
+      co_return r;
+  }
+  steady_state_allocations = global_allocations - before;
+
+  co_return co_await con->disconnect();
+}
+
+olifilo::future<unsigned> nest(unsigned depth) noexcept
+{
+  if (depth == 0)
+    co_return 0u;
+
+  auto r = co_await nest(depth - 1);
+  if (!r)
+    co_return r.error();
+  co_return *r + 1;
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) != 0)
+  {
+    std::perror("socketpair");
+    return 1;
+  }
+
+  // Hours of keep-alive without waiting for them
+  io::virtual_time sim;
+  memory_budget budget(decltype(pools)::storage_size, &pools);
+
+  std::size_t steady_state_allocations = 0;
+  auto r = when_all(
+      keep_alive_loop(io::stream_socket(io::file_descriptor_handle(fds[0])), 500, steady_state_allocations)
+    , fake_broker(io::stream_socket(io::file_descriptor_handle(fds[1])))
+    ).get();
+  if (!check_result(r, "when_all failed"))
+    return 1;
+
+  if (steady_state_allocations != 0)
+  {
+    std::fprintf(stderr, "error: %zu global allocations during the keep-alive loop\n", steady_state_allocations);
+    return 1;
+  }
+
+  // Running out of blocks fails the future, not the process, and doesn't fall back to the heap
+  const auto before_exhaustion = global_allocations;
+  if (auto nested = nest(1000).get(); nested || nested.error() != error::coro_bad_alloc)
+  {
+    std::fprintf(stderr, "error: exhausting the pools should fail with coro_bad_alloc\n");
+    return 1;
+  }
+  else if (global_allocations != before_exhaustion
+        || pools.usage(decltype(pools)::size_classes - 1).failures == 0)
+  {
+    std::fprintf(stderr, "error: exhaustion not served from, or not reported by, the pools\n");
+    return 1;
+  }
+
+  for (std::size_t i = 0; i < decltype(pools)::size_classes; ++i)
+  {
+    const auto usage = pools.usage(i);
+    std::printf("pool %zu: %zu byte blocks, %zu/%zu used at most\n", i, usage.block_size, usage.high_water, usage.block_count);
+    if (usage.in_use != 0)
+    {
+      std::fprintf(stderr, "error: %zu blocks of %zu bytes leaked\n", usage.in_use, usage.block_size);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/acceptor.hpp>
+#include <olifilo/coro/io/stream_socket.hpp>
+#include <olifilo/coro/io/tcp_metrics.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+olifilo::io::tcp_connection_info sample(std::chrono::microseconds rtt, std::uint32_t congestion_window, std::uint32_t unacked, std::uint32_t lost)
+{
+  return {
+    .state = 0,
+    .rtt = rtt,
+    .rtt_variance = rtt / 2,
+    .retransmit_timeout = {},
+    .total_retransmits = 0,
+    .congestion_window = congestion_window,
+    .unacked = unacked,
+    .lost = lost,
+  };
+}
+
+bool check_record()
+{
+  olifilo::io::tcp_metrics metrics;
+  // Two connections to the same peer, the first one sampled twice, and one connection to another peer
+  if (!check_result(metrics.record("10.0.0.1:1883", sample(100us, 10, 2, 0), 1, true), "record failed")
+   || !check_result(metrics.record("10.0.0.1:1883", sample(300us, 5, 4, 1), 2, false), "record failed")
+   || !check_result(metrics.record("10.0.0.1:1883", sample(200us, 20, 0, 0), 0, true), "record failed")
+   || !check_result(metrics.record("10.0.0.2:1883", sample(50us, 8, 1, 0), 0, true), "record failed"))
+    return false;
+
+  const auto endpoints = metrics.snapshot();
+  if (!check(endpoints.size() == 2, "every peer should get its own entry")
+   || !check(endpoints[0].first == "10.0.0.1:1883" && endpoints[1].first == "10.0.0.2:1883", "entries should be keyed by peer"))
+    return false;
+
+  const auto& first = endpoints[0].second;
+  if (!check(first.connections == 2, "only first samples should count as connections")
+   || !check(first.samples == 3, "every sample should be counted")
+   || !check(first.rtt_last == 200us && first.rtt_variance_last == 100us, "last RTT should be the latest sample's")
+   || !check(first.rtt_min == 100us && first.rtt_max == 300us, "RTT extremes should span every sample")
+   || !check(first.rtt_mean() == 200us, "mean RTT should average every sample")
+   || !check(first.retransmits == 3, "retransmits should add up over samples and connections")
+   || !check(first.congestion_window_last == 20 && first.congestion_window_min == 5, "congestion window should track last and min")
+   || !check(first.unacked_last == 0 && first.unacked_max == 4, "unacked should track last and max")
+   || !check(first.lost_max == 1, "lost should track max"))
+    return false;
+
+  const auto& second = endpoints[1].second;
+  if (!check(second.connections == 1 && second.samples == 1, "other peer's samples shouldn't mix")
+   || !check(second.rtt_min == 50us && second.rtt_max == 50us && second.rtt_mean() == 50us, "single sample should be min, max and mean"))
+    return false;
+
+  metrics.reset();
+  return check(metrics.snapshot().empty(), "reset should forget every peer")
+      && check(olifilo::io::tcp_endpoint_metrics{}.rtt_mean() == 0us, "mean without samples should be zero");
+}
+
+// Exchanges some data, then closes both sides: the client's last step, so it ends up in TCP_CLOSE
+olifilo::future<void> converse(olifilo::io::stream_socket& client, olifilo::io::stream_socket server) noexcept
+{
+  constexpr std::array<std::byte, 4> ping{std::byte('p'), std::byte('i'), std::byte('n'), std::byte('g')};
+  std::array<std::byte, ping.size()> buf;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    if (auto r = co_await server.write(ping); !r)
+      co_return r;
+    if (auto r = co_await client.read(buf); !r)
+      co_return r.error();
+
+    // give the sampler a few periods
+    if (auto r = co_await olifilo::io::poll(15ms); !r && r.error() != std::errc::timed_out)
+      co_return r;
+  }
+
+  server.close();
+  co_return client.shutdown(olifilo::io::shutdown_how::write);
+}
+
+bool check_sample_loopback()
+{
+  using namespace olifilo;
+
+  ::sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto listener = io::acceptor::create(reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr));
+  auto addrlen = static_cast<::socklen_t>(sizeof(addr));
+  if (!check_result(listener, "listening failed")
+   || !check(::getsockname(listener->handle(), reinterpret_cast<::sockaddr*>(&addr), &addrlen) == 0, "getsockname failed"))
+    return false;
+
+  auto client = io::stream_socket::create_connection(AF_INET, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr)).get();
+  if (!check_result(client, "connecting failed"))
+    return false;
+  auto server = listener->accept().get();
+  if (!check_result(server, "accepting failed"))
+    return false;
+
+  io::tcp_metrics metrics;
+  if (!check_result(when_all(
+          io::sample_tcp_info(*client, metrics, 10ms)
+        , converse(*client, std::move(*server))
+        , 5s
+        ).get(), "sampling until close failed"))
+    return false;
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "127.0.0.1:%u", static_cast<unsigned>(ntohs(addr.sin_port)));
+  const auto endpoints = metrics.snapshot();
+  if (!check(endpoints.size() == 1 && endpoints[0].first == name, "samples should be recorded under the peer's address"))
+    return false;
+
+  const auto& peer = endpoints[0].second;
+  return check(peer.connections == 1, "a single connection should be counted once")
+      && check(peer.samples >= 2, "connection should be sampled periodically until closed")
+      && check(peer.rtt_min <= peer.rtt_mean() && peer.rtt_mean() <= peer.rtt_max && peer.rtt_max > 0us, "RTT should be sampled")
+      && check(peer.retransmits == 0, "loopback shouldn't retransmit");
+}
+}  // anonymous namespace
+
+int main()
+{
+  if (!check_record()
+   || !check_sample_loopback())
+    return 1;
+
+  return 0;
+}
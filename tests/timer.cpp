@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/io/timer.hpp>
+#include <olifilo/coro/when_any.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+using clock = olifilo::io::timer::clock;
+
+bool check_one_shot(olifilo::io::timer& timer)
+{
+  const auto deadline = clock::now() + 20ms;
+  if (!check_result(timer.arm(deadline), "arming failed"))
+    return false;
+
+  const auto expirations = timer.wait().get();
+  if (!check_result(expirations, "waiting failed")
+   || !check(*expirations == 1, "one-shot timer should expire once")
+   || !check(clock::now() >= deadline, "timer shouldn't expire before its deadline"))
+    return false;
+
+  const auto again = olifilo::when_any(timer.wait(), 50ms).get();
+  return check(!again && again.error() == std::errc::timed_out, "one-shot timer shouldn't expire again");
+}
+
+bool check_periodic(olifilo::io::timer& timer)
+{
+  constexpr auto period = 10ms;
+  const auto first = clock::now() + period;
+  if (!check_result(timer.arm(first, period), "arming failed"))
+    return false;
+
+  auto expirations = timer.wait().get();
+  if (!check_result(expirations, "waiting failed")
+   || !check(*expirations == 1, "periodic timer should report its first expiration"))
+    return false;
+  std::uint64_t total = *expirations;
+
+  // Not waiting for a while: the missed expirations get reported together instead of getting lost
+  std::this_thread::sleep_for(2 * period + period / 2);
+  expirations = timer.wait().get();
+  if (!check_result(expirations, "waiting failed")
+   || !check(*expirations >= 2, "missed expirations should be reported at once"))
+    return false;
+  total += *expirations;
+
+  while (total < 20)
+  {
+    expirations = timer.wait().get();
+    if (!check_result(expirations, "waiting failed"))
+      return false;
+    total += *expirations;
+  }
+
+  // Without drift the last expiration still falls on the grid set by the first deadline
+  const auto now = clock::now();
+  const auto last = first + (total - 1) * period;
+  if (!check(last <= now && now < last + period, "periodic expirations shouldn't drift"))
+    return false;
+
+  if (!check_result(timer.disarm(), "disarming failed"))
+    return false;
+  const auto again = olifilo::when_any(timer.wait(), 3 * period).get();
+  return check(!again && again.error() == std::errc::timed_out, "disarmed timer shouldn't expire");
+}
+}  // anonymous namespace
+
+int main()
+{
+  auto timer = olifilo::io::timer::create();
+  if (!check_result(timer, "creating timer failed"))
+    return 1;
+
+  if (!check_one_shot(*timer)
+   || !check_periodic(*timer))
+    return 1;
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/coro/io/socket_descriptor.hpp>
+#include <olifilo/coro/io/timestamping.hpp>
+#include <olifilo/errors.hpp>
+#include <olifilo/io/bind.hpp>
+#include <olifilo/io/connect.hpp>
+#include <olifilo/io/recvmsg.hpp>
+#include <olifilo/io/socket.hpp>
+#include <olifilo/io/sockopt.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::test::check;
+using olifilo::test::check_result;
+
+constexpr auto timestamping = olifilo::io::timestamping::rx_software
+                            | olifilo::io::timestamping::tx_software
+                            | olifilo::io::timestamping::software
+                            | olifilo::io::timestamping::id;
+
+std::span<const std::byte> bytes(std::string_view str) noexcept
+{
+  return std::as_bytes(std::span(str));
+}
+
+// Software timestamps are taken from CLOCK_REALTIME while the test runs
+bool recent(const olifilo::io::kernel_timestamps& timestamps) noexcept
+{
+  if (!timestamps.software)
+    return false;
+
+  const auto age = std::chrono::system_clock::now() - *timestamps.software;
+  return age > -1s && age < 1s;
+}
+
+// Polls the error queue for a bit: the loopback device timestamps while sending, but don't rely on it
+olifilo::expected<std::optional<olifilo::io::tx_timestamp>> next_tx_timestamp(const olifilo::io::socket_descriptor& socket)
+{
+  for (int attempt = 0; attempt < 100; ++attempt)
+  {
+    auto ts = olifilo::io::read_tx_timestamp(socket);
+    if (!ts || *ts)
+      return ts;
+    std::this_thread::sleep_for(1ms);
+  }
+  return std::nullopt;
+}
+
+bool check_rx(olifilo::io::socket_descriptor& sender, olifilo::io::socket_descriptor& receiver)
+{
+  if (!check_result(sender.send({bytes("hello")}).get(), "sending failed"))
+    return false;
+
+  std::array<std::byte, 16> buf;
+  const auto r = olifilo::io::read_some_timestamped(receiver, buf).get();
+  if (!check_result(r, "timestamped read failed")
+   || !check(std::string_view(reinterpret_cast<const char*>(r->data.data()), r->data.size()) == "hello", "timestamped read should return the datagram")
+   || !check(recent(r->timestamps), "received datagram should have a recent software timestamp")
+   || !check(!r->timestamps.hardware, "loopback shouldn't produce hardware timestamps"))
+    return false;
+
+  // Straight recvmsg(): a short buffer truncates the datagram, but not its control messages
+  if (!check_result(sender.send({bytes("truncated")}).get(), "sending failed"))
+    return false;
+
+  std::array<std::byte, 4> small;
+  alignas(::cmsghdr) std::array<std::byte, 256> control;
+  const std::span<std::byte> bufs[] = {small};
+  auto msg = olifilo::io::recvmsg(receiver.handle(), bufs, control, MSG_DONTWAIT);
+  for (int attempt = 0; !msg && msg.error() == olifilo::condition::operation_not_ready && attempt < 100; ++attempt)
+  {
+    std::this_thread::sleep_for(1ms);
+    msg = olifilo::io::recvmsg(receiver.handle(), bufs, control, MSG_DONTWAIT);
+  }
+  return check_result(msg, "recvmsg failed")
+      && check(msg->size == small.size() && (msg->flags & MSG_TRUNC), "recvmsg should report truncation")
+      && check(!msg->control.empty() && msg->control.size() <= control.size(), "recvmsg should return the filled part of the control buffer")
+      && check(recent(olifilo::io::parse_timestamps(msg->control)), "recvmsg's control messages should hold the timestamp")
+      && check(!olifilo::io::parse_timestamps({}).software, "no control messages should parse as no timestamps");
+}
+
+bool check_tx(olifilo::io::socket_descriptor& sender)
+{
+  // Every datagram sent so far, in order: numbered from when timestamping::id got enabled
+  for (std::uint32_t id = 0; id < 2; ++id)
+  {
+    const auto ts = next_tx_timestamp(sender);
+    if (!check_result(ts, "reading TX timestamp failed")
+     || !check(ts->has_value(), "sent datagram should get a TX timestamp")
+     || !check((*ts)->stage == olifilo::io::tx_stage::sent, "only the requested stage should be reported")
+     || !check((*ts)->id == id, "TX timestamps should be numbered by datagram")
+     || !check(recent((*ts)->timestamps), "TX timestamp should be recent"))
+      return false;
+  }
+
+  const auto none = olifilo::io::read_tx_timestamp(sender);
+  return check_result(none, "reading TX timestamp failed")
+      && check(!*none, "every TX timestamp should be reported once");
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  auto receiver_fd = io::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK);
+  auto sender_fd = io::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK);
+  if (!check_result(receiver_fd, "creating receiver failed")
+   || !check_result(sender_fd, "creating sender failed"))
+    return 1;
+  io::socket_descriptor receiver(*receiver_fd), sender(*sender_fd);
+
+  ::sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto addrlen = static_cast<::socklen_t>(sizeof(addr));
+  if (!check_result(io::bind(receiver.handle(), reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr)), "bind failed")
+   || !check(::getsockname(receiver.handle(), reinterpret_cast<::sockaddr*>(&addr), &addrlen) == 0, "getsockname failed")
+   || !check_result(io::connect(sender.handle(), reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr)), "connect failed"))
+    return 1;
+
+  if (!check_result(io::setsockopt<io::sol_socket::timestamping>(receiver.handle(), timestamping), "enabling RX timestamps failed")
+   || !check_result(io::setsockopt<io::sol_socket::timestamping>(sender.handle(), timestamping), "enabling TX timestamps failed"))
+    return 1;
+
+  if (!check_rx(sender, receiver)
+   || !check_tx(sender))
+    return 1;
+
+  return 0;
+}
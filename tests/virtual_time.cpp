@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include <olifilo/coro/future.hpp>
+#include <olifilo/coro/interval.hpp>
+#include <olifilo/coro/when_all.hpp>
+#include <olifilo/io/clock.hpp>
+#include <olifilo/io/poll.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <system_error>
+#include <tuple>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+using namespace std::literals::chrono_literals;
+using olifilo::io::executor_clock;
+
+olifilo::future<std::uint64_t> keep_alive(executor_clock::duration period, executor_clock::duration run_time) noexcept
+{
+  const auto start = executor_clock::now();
+  olifilo::interval ticks(period);
+  std::uint64_t count = 0;
+  while (executor_clock::now() - start < run_time)
+  {
+    if (auto tick = co_await ticks.tick(); !tick)
+      co_return tick.error();
+    ++count;
+  }
+  co_return count;
+}
+
+// Time between starting to wait and 'fd' becoming readable
+olifilo::future<executor_clock::duration> wait_readable(int fd, executor_clock::duration timeout) noexcept
+{
+  const auto start = executor_clock::now();
+  if (auto r = co_await olifilo::io::poll(olifilo::io::file_descriptor_handle(fd), olifilo::io::poll::read, timeout); !r)
+    co_return r.error();
+  co_return executor_clock::now() - start;
+}
+
+olifilo::future<void> write_after(int fd, executor_clock::duration delay) noexcept
+{
+  if (auto r = co_await olifilo::io::poll(delay); !r && r.error() != std::errc::timed_out)
+    co_return r;
+
+  if (::write(fd, "x", 1) != 1)
+    co_return std::error_code(errno, std::system_category());
+  co_return {};
+}
+}  // anonymous namespace
+
+int main()
+{
+  using namespace olifilo;
+
+  const auto real_start = std::chrono::steady_clock::now();
+  io::virtual_time sim;
+  const auto start = sim.now();
+
+  // Ticks at 45s, 90s, ... 630s: the first one at or beyond the 10 minutes
+  if (auto ticks = keep_alive(45s, 10min).get(); !ticks)
+  {
+    std::fprintf(stderr, "keep_alive: %s\n", ticks.error().message().c_str());
+    return 1;
+  }
+  else if (*ticks != 14 || sim.now() - start != 630s)
+  {
+    std::fprintf(stderr, "error: %llu ticks, ending at %llds\n", static_cast<unsigned long long>(*ticks), static_cast<long long>(std::chrono::duration_cast<std::chrono::seconds>(sim.now() - start).count()));
+    return 1;
+  }
+
+  // In memory transport: time jumps to the writer's timeout, the reader's longer one doesn't expire
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) != 0)
+  {
+    std::perror("socketpair");
+    return 1;
+  }
+
+  auto both = when_all(wait_readable(fds[0], 2min), write_after(fds[1], 90s)).get();
+  ::close(fds[0]);
+  ::close(fds[1]);
+  if (!both)
+  {
+    std::fprintf(stderr, "when_all: %s\n", both.error().message().c_str());
+    return 1;
+  }
+
+  auto& [waited, written] = *both;
+  if (!waited || !written)
+  {
+    std::fprintf(stderr, "error: %s\n", (!waited ? waited.error() : written.error()).message().c_str());
+    return 1;
+  }
+  else if (*waited != 90s)
+  {
+    std::fprintf(stderr, "error: read after %lldns instead of 90s\n", static_cast<long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(*waited).count()));
+    return 1;
+  }
+
+  // And the nothing-arrives case: a timeout
+  if (auto r = [] () -> future<void> { co_return co_await io::poll(5min); }().get(); r || r.error() != std::errc::timed_out)
+  {
+    std::fprintf(stderr, "error: expected a timeout\n");
+    return 1;
+  }
+
+  if (std::chrono::steady_clock::now() - real_start > 10s)
+  {
+    std::fprintf(stderr, "error: simulating took too much real time\n");
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "check.hpp"
+
+#include <olifilo/detail/ring_buffer.hpp>
+#include <olifilo/detail/select_driver.hpp>
+#include <olifilo/detail/waiter_slots.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+
+#include <sys/select.h>
+
+namespace
+{
+using olifilo::detail::armed_select_slots;
+using olifilo::detail::overflow_policy;
+using olifilo::detail::record_ring;
+using olifilo::detail::select_waiter;
+using olifilo::detail::waiter_slots;
+using olifilo::test::check;
+
+bool check_arm_disarm()
+{
+  waiter_slots<int, 2> slots;
+  if (!check(!slots.any_claimed() && !slots.notify_needed(), "new slots should be free"))
+    return false;
+
+  const auto first = slots.arm(1);
+  const auto second = slots.arm(2);
+  if (!check(first < slots.capacity && second < slots.capacity && first != second, "arming should claim distinct slots")
+   || !check(slots[first] == 1 && slots[second] == 2, "armed slots should hold their waiter")
+   || !check(slots.any_claimed() && slots.notify_needed(), "armed slots should need notifying"))
+    return false;
+
+  if (!check(slots.arm(3) == slots.capacity, "arming more than capacity should fail"))
+    return false;
+
+  int sum = 0;
+  slots.for_each_armed([&sum] (int waiter) noexcept { sum += waiter; });
+  if (!check(sum == 3, "for_each_armed should visit every armed waiter exactly once"))
+    return false;
+
+  slots.disarm(first);
+  const auto third = slots.arm(3);
+  if (!check(third == first && slots[third] == 3, "a disarmed slot should be reusable"))
+    return false;
+
+  slots.disarm(second);
+  slots.disarm(third);
+  return check(!slots.any_claimed() && !slots.notify_needed(), "disarmed slots should be free");
+}
+
+// Dekker style pairing: either the waiter sees 'ready' after arming or the notifier sees it armed
+bool check_no_lost_wakeup()
+{
+  constexpr unsigned rounds = 20'000;
+
+  waiter_slots<int, 1> slots;
+  std::atomic<bool> ready = false;
+  std::atomic<bool> notified = false;
+  // the round the notifier should run next, zero once it's done with it
+  std::atomic<unsigned> round = 0;
+  unsigned lost = 0;
+
+  std::thread notifier([&] {
+      for (unsigned i = 0; i < rounds; ++i)
+      {
+        round.wait(0, std::memory_order_acquire);
+        ready.store(true, std::memory_order_relaxed);
+        notified.store(slots.notify_needed(), std::memory_order_relaxed);
+        round.store(0, std::memory_order_release);
+        round.notify_one();
+      }
+    });
+
+  for (unsigned i = 1; i <= rounds; ++i)
+  {
+    ready.store(false, std::memory_order_relaxed);
+    round.store(i, std::memory_order_release);
+    round.notify_one();
+    const auto slot = slots.arm(0);
+    const bool saw_ready = ready.load(std::memory_order_relaxed);
+    round.wait(i, std::memory_order_acquire);
+    if (!saw_ready && !notified.load(std::memory_order_relaxed))
+      ++lost;
+    slots.disarm(slot);
+  }
+  notifier.join();
+
+  return check(lost == 0, "notifier and waiter should never miss each other");
+}
+
+struct counting_waker
+{
+  std::atomic<unsigned>* triggered = nullptr;
+};
+
+void trigger(counting_waker waker) noexcept
+{
+  waker.triggered->fetch_add(1, std::memory_order_relaxed);
+}
+
+struct fd_context
+{
+  std::mutex                                     lock;
+  record_ring                                    queue;
+  waiter_slots<select_waiter<counting_waker>, 2> waiters;
+  std::atomic<bool>                              opened = true;
+};
+
+constexpr std::size_t fd_count = 2;
+using driver = olifilo::detail::select_driver<fd_context, fd_count>;
+
+bool push(fd_context& context)
+{
+  return context.queue.push([] (std::span<std::byte> record) noexcept {
+      record[0] = std::byte(1);
+    });
+}
+
+::fd_set only(int fd)
+{
+  ::fd_set set;
+  FD_ZERO(&set);
+  FD_SET(fd, &set);
+  return set;
+}
+
+bool check_select_driver()
+{
+  std::array<fd_context, fd_count> contexts;
+  for (auto& context : contexts)
+    if (!check(context.queue.reset(1, 4, overflow_policy::drop_oldest).has_value(), "reset failed"))
+      return false;
+
+  std::atomic<unsigned> triggered = 0;
+  const counting_waker waker{&triggered};
+
+  // Nothing queued: armed without waking, readiness comes from end_select
+  auto readfds = only(0);
+  armed_select_slots armed;
+  if (!check(driver::start_select(contexts, 1, &readfds, nullptr, nullptr, waker, trigger, armed), "start_select failed")
+   || !check(!FD_ISSET(0, &readfds) && triggered == 0, "an empty queue shouldn't be ready")
+   || !check(contexts[0].waiters.notify_needed(), "start_select should arm a slot"))
+    return false;
+
+  if (!check(push(contexts[0]), "push failed"))
+    return false;
+  driver::notify(contexts[0], trigger);
+  driver::end_select(contexts, armed);
+  if (!check(triggered == 1, "notifying should wake an armed select")
+   || !check(FD_ISSET(0, &readfds), "end_select should report a non-empty queue as readable")
+   || !check(!contexts[0].waiters.any_claimed(), "end_select should disarm"))
+    return false;
+
+  // Already queued: wakes right away
+  readfds = only(0);
+  if (!check(driver::start_select(contexts, 1, &readfds, nullptr, nullptr, waker, trigger, armed), "start_select failed")
+   || !check(triggered == 2, "a non-empty queue should wake at once"))
+    return false;
+  driver::end_select(contexts, armed);
+
+  // Capacity exhaustion: the failing call leaves nothing of its own armed
+  std::array<::fd_set, 3> sets{only(1), only(1), only(1)};
+  std::array<armed_select_slots, 3> armed_sets{};
+  if (!check(driver::start_select(contexts, 2, &sets[0], nullptr, nullptr, waker, trigger, armed_sets[0])
+          && driver::start_select(contexts, 2, &sets[1], nullptr, nullptr, waker, trigger, armed_sets[1]), "start_select failed")
+   || !check(!driver::start_select(contexts, 2, &sets[2], nullptr, nullptr, waker, trigger, armed_sets[2]) && armed_sets[2] == 0
+      , "selecting an fd more than its capacity should fail"))
+    return false;
+  driver::end_select(contexts, armed_sets[0]);
+  driver::end_select(contexts, armed_sets[1]);
+  if (!check(!contexts[1].waiters.any_claimed(), "every slot should be free again"))
+    return false;
+
+  // Closed: both readable and in error
+  auto errorfds = only(1);
+  readfds = only(1);
+  if (!check(driver::start_select(contexts, 2, &readfds, nullptr, &errorfds, waker, trigger, armed), "start_select failed"))
+    return false;
+  contexts[1].opened = false;
+  driver::end_select(contexts, armed);
+  if (!check(FD_ISSET(1, &readfds) && FD_ISSET(1, &errorfds), "a closed fd should be readable and in error"))
+    return false;
+
+  // Never writable: always 'ready' to fail writing
+  const auto before = triggered.load();
+  auto writefds = only(0);
+  if (!check(driver::start_select(contexts, 1, nullptr, &writefds, nullptr, waker, trigger, armed) && armed == 0, "start_select failed")
+   || !check(triggered == before + 1, "selecting for writing should wake at once"))
+    return false;
+
+  return true;
+}
+}  // anonymous namespace
+
+int main()
+{
+  if (!check_arm_disarm()
+   || !check_no_lost_wakeup()
+   || !check_select_driver())
+    return 1;
+
+  return 0;
+}
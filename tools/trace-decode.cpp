@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+// Offline decoder for olifilo::trace::dump() output: prints one line per record, ordered by time.
+// With --chrome it emits Chrome's JSON trace event format instead (loadable in Perfetto's UI and
+// chrome://tracing): coroutine lifetimes, poll waits and wait() calls become async slices, executor
+// iterations thread slices and awaiting a future becomes a flow from the caller to the callee's
+// completion.
+
+#include <olifilo/trace.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+using namespace olifilo;
+using namespace std::literals::string_view_literals;
+
+constexpr const char* category_name(trace::category cat) noexcept
+{
+  switch (cat)
+  {
+    case trace::category::executor:
+      return "executor";
+    case trace::category::promise:
+      return "promise";
+    case trace::category::io:
+      return "io";
+    case trace::category::app:
+      return "app";
+  }
+  return "?";
+}
+
+bool is_address(std::string_view name) noexcept
+{
+  return name == "handler" || name == "waiter" || name == "promise" || name == "caller" || name == "callee";
+}
+
+void print_arg(std::string_view name, std::uint64_t value)
+{
+  if (name.empty())
+    return;
+
+  if (is_address(name))
+    std::printf(" %.*s=0x%" PRIx64, static_cast<int>(name.size()), name.data(), value);
+  else if (name.ends_with("_ns") || name == "error")
+    std::printf(" %.*s=%" PRId64, static_cast<int>(name.size()), name.data(), static_cast<std::int64_t>(value));
+  else
+    std::printf(" %.*s=%" PRIu64, static_cast<int>(name.size()), name.data(), value);
+}
+
+void print_text(const std::vector<trace::record>& records, std::uint64_t start)
+{
+  for (const auto& rec : records)
+  {
+    const auto rel = rec.timestamp_ns - start;
+    std::printf("%10" PRIu64 ".%03" PRIu64 "us [%" PRIu32 "]", rel / 1000, rel % 1000, rec.thread);
+    if (rec.id >= std::size(trace::events))
+    {
+      std::printf(" event#%u %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", rec.id, rec.args[0], rec.args[1], rec.args[2]);
+      continue;
+    }
+
+    const auto& info = trace::events[rec.id];
+    std::printf(" %s.%s", category_name(info.cat), info.name);
+    for (std::size_t i = 0; i < std::size(info.args); ++i)
+      print_arg(info.args[i], rec.args[i]);
+    std::printf("\n");
+  }
+}
+
+class chrome_writer
+{
+  public:
+    explicit chrome_writer(std::uint64_t start) noexcept
+      : _start(start)
+    {
+      std::printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    }
+
+    ~chrome_writer()
+    {
+      std::printf("\n]}\n");
+    }
+
+    // 'extra' gets inserted verbatim, e.g. ,"id":"0x1234"
+    void event(const trace::record& rec, char phase, std::string_view cat, std::string_view name, const std::string& extra = {}, bool with_args = true)
+    {
+      const auto rel = rec.timestamp_ns - _start;
+      std::printf("%s{\"ph\":\"%c\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%" PRIu64 ".%03" PRIu64 ",\"cat\":\"%.*s\",\"name\":\"%.*s\"%s"
+          , std::exchange(_separator, ",\n"), phase, rec.thread, rel / 1000, rel % 1000
+          , static_cast<int>(cat.size()), cat.data()
+          , static_cast<int>(name.size()), name.data()
+          , extra.c_str());
+
+      if (with_args && rec.id < std::size(trace::events))
+      {
+        const auto& info = trace::events[rec.id];
+        const char* sep = "";
+        std::printf(",\"args\":{");
+        for (std::size_t i = 0; i < std::size(info.args); ++i)
+        {
+          const std::string_view arg = info.args[i];
+          if (arg.empty())
+            continue;
+          if (is_address(arg))
+            std::printf("%s\"%s\":\"0x%" PRIx64 "\"", std::exchange(sep, ","), info.args[i], rec.args[i]);
+          else
+            std::printf("%s\"%s\":%" PRId64, std::exchange(sep, ","), info.args[i], static_cast<std::int64_t>(rec.args[i]));
+        }
+        std::printf("}");
+      }
+      std::printf("}");
+    }
+
+  private:
+    std::uint64_t _start;
+    const char*   _separator = "";
+};
+
+std::string id(std::uint64_t value)
+{
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), ",\"id\":\"0x%" PRIx64 "\"", value);
+  return buf;
+}
+
+void print_chrome(const std::vector<trace::record>& records, std::uint64_t start)
+{
+  using enum trace::event;
+
+  chrome_writer out(start);
+  std::unordered_map<std::uint64_t, std::string> poll_names;
+  // callee promise -> flow id of the await edge that waits for its completion
+  std::unordered_map<std::uint64_t, std::uint64_t> pending_flows;
+  std::uint64_t flow_ids = 0;
+
+  for (const auto& rec : records)
+  {
+    if (rec.id >= std::size(trace::events))
+      continue;
+
+    const auto& info = trace::events[rec.id];
+    switch (static_cast<trace::event>(rec.id))
+    {
+      case iteration_begin:
+        out.event(rec, 'B', "executor", "iteration");
+        break;
+      case iteration_end:
+        out.event(rec, 'E', "executor", "iteration");
+        break;
+
+      case promise_create:
+        out.event(rec, 'b', "coroutine", "coroutine", id(rec.args[0]));
+        break;
+      case promise_final:
+        out.event(rec, 'n', "coroutine", "final_suspend", id(rec.args[0]));
+        if (auto flow = pending_flows.find(rec.args[0]); flow != pending_flows.end())
+        {
+          out.event(rec, 'f', "await", "await", ",\"bp\":\"e\"" + id(flow->second), false);
+          pending_flows.erase(flow);
+        }
+        break;
+      case promise_destroy:
+        out.event(rec, 'e', "coroutine", "coroutine", id(rec.args[0]));
+        pending_flows.erase(rec.args[0]);
+        break;
+
+      case await_future:
+      case wait_edge:
+        pending_flows[rec.args[1]] = ++flow_ids;
+        out.event(rec, 's', "await", "await", id(flow_ids), false);
+        break;
+      case wait_begin:
+        out.event(rec, 'b', "wait", "wait", id(rec.args[0]));
+        break;
+      case wait_end:
+        out.event(rec, 'e', "wait", "wait", id(rec.args[0]));
+        break;
+
+      case poll_suspend:
+      {
+        const int fd = static_cast<int>(rec.args[1]);
+        auto& name = poll_names[rec.args[0]];
+        name = fd == -1 ? "timeout" : "poll fd=" + std::to_string(fd);
+        out.event(rec, 'b', "poll", name, id(rec.args[0]));
+        break;
+      }
+      case poll_timed_out:
+      case poll_ready:
+        out.event(rec, 'n', "poll", info.name, id(rec.args[0]));
+        break;
+      case poll_resume:
+        if (auto name = poll_names.find(rec.args[0]); name != poll_names.end())
+        {
+          out.event(rec, 'e', "poll", name->second, id(rec.args[0]));
+          poll_names.erase(name);
+        }
+        break;
+
+      default:
+        out.event(rec, 'i', category_name(info.cat), info.name, ",\"s\":\"t\"");
+        break;
+    }
+  }
+}
+}  // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  const bool chrome = argc > 1 && argv[1] == "--chrome"sv;
+  if (chrome)
+  {
+    --argc;
+    ++argv;
+  }
+
+  std::FILE* in = argc > 1 ? std::fopen(argv[1], "rb") : stdin;
+  if (!in)
+  {
+    std::perror(argv[1]);
+    return 1;
+  }
+
+  trace::file_header header;
+  const trace::file_header expected_header;
+  if (std::fread(&header, sizeof(header), 1, in) != 1
+   || std::memcmp(header.magic, expected_header.magic, sizeof(header.magic)) != 0
+   || header.version != expected_header.version
+   || header.record_size != sizeof(trace::record))
+  {
+    std::fprintf(stderr, "not a (supported) olifilo trace\n");
+    return 1;
+  }
+  if (header.event_count != expected_header.event_count)
+    std::fprintf(stderr, "warning: trace has %" PRIu32 " event types, decoder knows %" PRIu32 "\n", header.event_count, expected_header.event_count);
+
+  std::vector<trace::record> records(header.record_count);
+  if (std::fread(records.data(), sizeof(trace::record), records.size(), in) != records.size())
+  {
+    std::fprintf(stderr, "truncated trace\n");
+    return 1;
+  }
+
+  std::ranges::stable_sort(records, {}, &trace::record::timestamp_ns);
+  const auto start = records.empty() ? 0 : records.front().timestamp_ns;
+
+  if (chrome)
+    print_chrome(records, start);
+  else
+    print_text(records, start);
+}